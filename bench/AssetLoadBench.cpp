@@ -0,0 +1,234 @@
+/*
+ * AssetLoadBench.cpp
+ *
+ * Measures how startup scales with the number of images: the time to decode
+ * them and upload their textures one after another, the way TextureCache
+ * loads them on first use, against decoding them on an AssetLoader's worker
+ * threads while the main thread uploads the finished ones.
+ *
+ * The images are copies of the clock's bitmaps under different names, written
+ * to a temporary directory first, so they are read from the page cache.
+ *
+ *   AssetLoadBench
+ *
+ * Run it from the top of the repository so it finds graphics/.
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <GL/glut.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include <time.h>
+#include <unistd.h>
+#include "AssetLoader.h"
+#include "HeadlessContext.h"
+#include "ImageLoader.h"
+#include "TextureCache.h"
+
+using namespace std;
+
+// every measurement is repeated this many times and the median reported
+#define REPETITIONS 5
+
+static const int assetCounts[] = { 4, 40, 100, 400 };
+static const char *sources[] = { "graphics/clockface.bmp", "graphics/hours_hand.bmp",
+								 "graphics/minutes_hand.bmp", "graphics/seconds_hand.bmp" };
+
+static double now()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/**
+ * Writes count bitmaps into the directory, cycling through the clock's images.
+ */
+static bool writeAssets(const string &directory, int count, vector<string> &files)
+{
+	ImageLoader images[4];
+
+	for(int i = 0; i < 4; i++)
+	{
+		if(!images[i].loadBMP(sources[i]))
+		{
+			printf("Error: run the benchmark from the top of the repository\n");
+			return false;
+		}
+	}
+
+	for(int i = 0; i < count; i++)
+	{
+		char name[64];
+		const ImageLoader &image = images[i % 4];
+
+		snprintf(name, sizeof(name), "/asset%03d.bmp", i);
+		files.push_back(directory + name);
+
+		if(!ImageLoader::saveBMP(files.back().c_str(), image.getWidth(), image.getHeight(),
+								 image.getPixelData()))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Drops the images and their textures from the cache again.
+ */
+static void unload(const vector<string> &files)
+{
+	for(size_t i = 0; i < files.size(); i++)
+	{
+		// images handed over by a loader have no reference yet
+		TextureCache::acquire(files[i]);
+		TextureCache::release(files[i]);
+		TextureCache::release(files[i]);
+	}
+}
+
+/**
+ * @param threads 0 to load on this thread with TextureCache alone.
+ * @return The median time from the first image decoded to the last texture
+ *         uploaded, in seconds.
+ */
+static double measure(const vector<string> &files, int threads)
+{
+	vector<double> times;
+
+	for(int r = 0; r < REPETITIONS; r++)
+	{
+		double start = now();
+
+		if(threads == 0)
+		{
+			for(size_t i = 0; i < files.size(); i++)
+			{
+				TextureCache::acquire(files[i]);
+				TextureCache::getTexture(files[i]);
+			}
+		}
+		else
+		{
+			AssetLoader loader(threads);
+			string filename;
+
+			for(size_t i = 0; i < files.size(); i++)
+			{
+				loader.add(files[i]);
+			}
+
+			// upload every image as soon as it is decoded
+			while(loader.next(filename))
+			{
+				TextureCache::getTexture(filename);
+			}
+		}
+
+		glFinish();
+		times.push_back(now() - start);
+
+		if(threads == 0)
+		{
+			for(size_t i = 0; i < files.size(); i++)
+			{
+				TextureCache::release(files[i]);
+			}
+		}
+		else
+		{
+			unload(files);
+		}
+	}
+
+	sort(times.begin(), times.end());
+
+	return times[times.size() / 2];
+}
+
+int main()
+{
+	char directory[] = "/tmp/AssetLoadBench.XXXXXX";
+
+	if(mkdtemp(directory) == NULL)
+	{
+		perror("Error");
+		return 1;
+	}
+
+	vector<string> files;
+	int maxCount = assetCounts[sizeof(assetCounts) / sizeof(assetCounts[0]) - 1];
+	bool written = writeAssets(directory, maxCount, files);
+	HeadlessContext context(64, 64);
+	int cores = max(1u, thread::hardware_concurrency());
+	int threadCounts[] = { 1, 2, 4, 8 };
+
+	if(written && context.isValid())
+	{
+		// once untimed, so the first case does not pay for the cold start
+		measure(files, 0);
+
+		printf("startup time in ms, median of %d runs, %d processors\n", REPETITIONS, cores);
+		printf("%8s %10s", "assets", "serial");
+
+		for(int t = 0; t < 4; t++)
+		{
+			char column[32];
+			snprintf(column, sizeof(column), "%d thread%s", threadCounts[t], threadCounts[t] > 1 ? "s" : "");
+			printf(" %10s", column);
+		}
+
+		printf(" %8s\n", "speedup");
+
+		for(size_t c = 0; c < sizeof(assetCounts) / sizeof(assetCounts[0]); c++)
+		{
+			vector<string> subset(files.begin(), files.begin() + assetCounts[c]);
+			double serial = measure(subset, 0);
+			double best = serial;
+
+			printf("%8d %10.2f", assetCounts[c], serial * 1000);
+
+			for(int t = 0; t < 4; t++)
+			{
+				double pooled = measure(subset, threadCounts[t]);
+
+				best = min(best, pooled);
+				printf(" %10.2f", pooled * 1000);
+			}
+
+			printf(" %7.2fx\n", serial / best);
+		}
+	}
+
+	for(size_t i = 0; i < files.size(); i++)
+	{
+		unlink(files[i].c_str());
+	}
+
+	rmdir(directory);
+
+	return written && context.isValid() ? 0 : 1;
+}
@@ -0,0 +1,285 @@
+/*
+ * ClockWallBench.cpp
+ *
+ * Measures how the wall of clocks scales with the number of clocks: the time
+ * to point all hands at a new time, and the frame rate of the whole wall
+ * drawn headless with OpenGL (every sprite batched, and with the faces cached
+ * in a LayerCache) and with the SoftwareRenderer.
+ *
+ *   ClockWallBench [WxH] [timezones.txt]
+ *
+ * Run it from the top of the repository so it finds graphics/.
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <GL/glut.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <time.h>
+#include "Sprite.h"
+#include "SpriteBatch.h"
+#include "TextureAtlas.h"
+#include "LayerCache.h"
+#include "ClockWall.h"
+#include "HeadlessContext.h"
+#include "SoftwareRenderer.h"
+#include "ImageLoader.h"
+
+using namespace std;
+
+// every measurement runs for at least this long and this many iterations
+#define MIN_SECONDS 0.5
+#define MIN_ITERATIONS 5
+
+static const size_t clockCounts[] = { 1, 10, 100, 1000, 2000, 5000 };
+
+static double now()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/**
+ * Draws the wall the way the window does: the faces from the cached layer,
+ * or every sprite when there is no layer, then the hands.
+ */
+static void drawFrame(const ClockWall &wall, SpriteBatch &batch, const LayerCache *layer)
+{
+	if(layer != NULL)
+	{
+		layer->draw();
+	}
+	else
+	{
+		glClear(GL_COLOR_BUFFER_BIT);
+	}
+
+	const vector<Sprite *> &faces = wall.getFaces();
+	const vector<Sprite *> &hands = wall.getHands();
+
+	batch.begin();
+
+	for(size_t i = 0; i < faces.size() && layer == NULL; i++)
+	{
+		batch.add(*faces[i]);
+	}
+
+	for(size_t i = 0; i < hands.size(); i++)
+	{
+		batch.add(*hands[i]);
+	}
+
+	batch.flush();
+}
+
+/**
+ * @return Frames per second of drawing the wall with OpenGL, a second later
+ *         every frame.
+ */
+static double measureGL(ClockWall &wall, SpriteBatch &batch, LayerCache *layer, int width, int height)
+{
+	time_t time = 1700000000;
+	int frames = 0;
+
+	if(layer != NULL)
+	{
+		layer->update(width, height);
+	}
+
+	glFinish();
+	double start = now();
+	double elapsed;
+
+	do
+	{
+		wall.update(time++);
+		drawFrame(wall, batch, layer);
+		frames++;
+
+		if(frames % MIN_ITERATIONS == 0)
+		{
+			glFinish();
+		}
+
+		elapsed = now() - start;
+	} while(frames < MIN_ITERATIONS || elapsed < MIN_SECONDS);
+
+	glFinish();
+
+	return frames / (now() - start);
+}
+
+/**
+ * @return Frames per second of drawing the wall with the software renderer,
+ *         with the faces cached in a layer.
+ */
+static double measureSoftware(ClockWall &wall, SoftwareRenderer &renderer, LayerCache &layer)
+{
+	const vector<Sprite *> &hands = wall.getHands();
+	time_t time = 1700000000;
+	int frames = 0;
+
+	layer.update(renderer);
+
+	double start = now();
+
+	do
+	{
+		wall.update(time++);
+		layer.draw(renderer);
+
+		for(size_t i = 0; i < hands.size(); i++)
+		{
+			renderer.draw(*hands[i]);
+		}
+
+		frames++;
+	} while(frames < MIN_ITERATIONS || now() - start < MIN_SECONDS);
+
+	return frames / (now() - start);
+}
+
+/**
+ * @return Microseconds it takes to point the hands of every clock at a new time.
+ */
+static double measureUpdate(ClockWall &wall)
+{
+	time_t time = 1700000000;
+	int updates = 0;
+
+	// the first update looks up the offsets of the zones
+	wall.update(time++);
+
+	double start = now();
+
+	do
+	{
+		wall.update(time++);
+		updates++;
+	} while(updates < MIN_ITERATIONS || now() - start < MIN_SECONDS / 5);
+
+	return (now() - start) / updates * 1e6;
+}
+
+int main(int argc, char *argv[])
+{
+	int width = 1280;
+	int height = 720;
+	const char *zonesFile = "timezones.txt";
+
+	for(int i = 1; i < argc; i++)
+	{
+		if(sscanf(argv[i], "%dx%d", &width, &height) != 2)
+		{
+			zonesFile = argv[i];
+		}
+	}
+
+	vector<string> zones;
+
+	if(!ClockWall::readZones(zonesFile, zones) || zones.empty())
+	{
+		return 1;
+	}
+
+	HeadlessContext context(width, height);
+
+	if(!context.isValid())
+	{
+		return 1;
+	}
+
+	// the state init() and reshape() in main.cpp set up
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glClearColor(1.0, 1.0, 1.0, 0.0);
+	glViewport(0, 0, width, height);
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glOrtho(-width/2, width/2, -height/2, height/2, -1.0, 1.0);
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+
+	Sprite face("graphics/clockface.bmp");
+	Sprite hoursHand("graphics/hours_hand.bmp");
+	Sprite minutesHand("graphics/minutes_hand.bmp");
+	Sprite secondsHand("graphics/seconds_hand.bmp");
+	Sprite *sprites[] = { &face, &hoursHand, &minutesHand, &secondsHand };
+	GLfloat pivots[][2] = { { 0.5, 0.5 }, { 0.5, 0.075 }, { 0.5, 0.0566 }, { 0.5, 0.0545 } };
+	TextureAtlas atlas;
+
+	for(int i = 0; i < 4; i++)
+	{
+		if(sprites[i]->getImage()->getPixelData() == NULL)
+		{
+			printf("Error: run the benchmark from the top of the repository\n");
+			return 1;
+		}
+
+		sprites[i]->setPivot(pivots[i][0], pivots[i][1]);
+		sprites[i]->setX(0);
+		sprites[i]->setY(0);
+		atlas.add(sprites[i]);
+	}
+
+	atlas.build();
+
+	SpriteBatch batch;
+	SoftwareRenderer renderer(width, height);
+
+	printf("%dx%d, %d zones from %s\n", width, height, (int)zones.size(), zonesFile);
+	printf("%8s %12s %12s %12s %12s %11s\n", "clocks", "update (us)", "gl (fps)",
+		   "gl layer", "software", "draw calls");
+
+	for(size_t i = 0; i < sizeof(clockCounts) / sizeof(clockCounts[0]); i++)
+	{
+		vector<string> wallZones;
+
+		for(size_t j = 0; j < clockCounts[i]; j++)
+		{
+			wallZones.push_back(zones[j % zones.size()]);
+		}
+
+		ClockWall wall(&face, &hoursHand, &minutesHand, &secondsHand);
+		wall.setZones(wallZones);
+		wall.layout(width, height);
+
+		LayerCache layer(255, 255, 255, 0);
+		const vector<Sprite *> &faces = wall.getFaces();
+
+		for(size_t j = 0; j < faces.size(); j++)
+		{
+			layer.add(faces[j]);
+		}
+
+		double update = measureUpdate(wall);
+		double batched = measureGL(wall, batch, NULL, width, height);
+		unsigned int drawCalls = batch.getDrawCalls();
+		double layered = measureGL(wall, batch, &layer, width, height);
+		double software = measureSoftware(wall, renderer, layer);
+
+		printf("%8d %12.1f %12.1f %12.1f %12.1f %11u\n", (int)clockCounts[i], update,
+			   batched, layered, software, drawCalls);
+	}
+
+	return 0;
+}
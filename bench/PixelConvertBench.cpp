@@ -0,0 +1,228 @@
+/*
+ * PixelConvertBench.cpp
+ *
+ * Compares the BGRA to RGBA conversion kernels in PixelConvert with the loop
+ * ImageLoader::fixPadding used before them, on the clock bitmaps and on large
+ * synthetic images.
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <time.h>
+#include "PixelConvert.h"
+
+using namespace std;
+
+struct Input
+{
+	string name;
+	LONG width;
+	LONG height;
+	vector<BYTE> pixels; // bottom-up BGRA rows without padding
+};
+
+static double now()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/**
+ * The conversion loop of ImageLoader::fixPadding before the SIMD kernels,
+ * kept here as the baseline.
+ */
+static void legacyFixPadding(BYTE *pixelData, const BYTE *tempPixelData, LONG width, LONG height)
+{
+	LONG byteWidth, padWidth;
+	DWORD size = width * height * 4;
+
+	byteWidth = padWidth = (LONG)((float)width * 32.0f / 8.0);
+
+	short padding = padWidth % 4 != 0;
+	padWidth += padding;
+
+	int offset = padWidth - byteWidth;
+
+	for(unsigned int i = 0; i < size - 2; i += 4)
+	{
+		if( (i + 1) % padWidth == 0)
+		{
+			i += offset;
+		}
+
+		*(pixelData + i)      = *(tempPixelData + i + 2); // R
+		*(pixelData + i + 1 ) = *(tempPixelData + i + 1); // G
+		*(pixelData + i + 2)  = *(tempPixelData + i);     // B
+		*(pixelData + i + 3)  = *(tempPixelData + i + 3); // A
+	}
+}
+
+static bool loadInput(const char *fileName, Input &input)
+{
+	FILE *in = fopen(fileName, "rb");
+
+	if(in == NULL)
+	{
+		return false;
+	}
+
+	BITMAPFILEHEADER fileHeader;
+	BITMAPINFOHEADER infoHeader;
+
+	bool valid = fread(&fileHeader, sizeof(fileHeader), 1, in) == 1 &&
+				 fread(&infoHeader, sizeof(infoHeader), 1, in) == 1 &&
+				 infoHeader.biBitCount == 32 && infoHeader.biHeight > 0;
+
+	if(valid)
+	{
+		input.name = fileName;
+		input.width = infoHeader.biWidth;
+		input.height = infoHeader.biHeight;
+		input.pixels.resize(input.width * input.height * 4);
+
+		fseek(in, fileHeader.bfOffBits, SEEK_SET);
+		valid = fread(&input.pixels[0], 1, input.pixels.size(), in) == input.pixels.size();
+	}
+
+	fclose(in);
+	return valid;
+}
+
+static void makeInput(LONG width, LONG height, Input &input)
+{
+	char name[64];
+	snprintf(name, sizeof(name), "synthetic %dx%d", width, height);
+
+	input.name = name;
+	input.width = width;
+	input.height = height;
+	input.pixels.resize(width * height * 4);
+
+	srand(width * 31 + height);
+
+	for(size_t i = 0; i < input.pixels.size(); i++)
+	{
+		input.pixels[i] = rand() & 0xff;
+	}
+}
+
+/**
+ * Runs the conversion until at least minimumTime passed and returns the
+ * fastest single run in seconds.
+ */
+static double measure(const Input &input, BYTE *output, int kernel, double minimumTime)
+{
+	double best = 1e9;
+	double start = now();
+	int runs = 0;
+
+	while(runs < 5 || now() - start < minimumTime)
+	{
+		double runStart = now();
+
+		if(kernel < 0)
+		{
+			legacyFixPadding(output, &input.pixels[0], input.width, input.height);
+		}
+		else
+		{
+			PixelConvert::bgraToRgba(output, &input.pixels[0], input.width, input.height,
+									 input.width * 4, false);
+		}
+
+		double elapsed = now() - runStart;
+		best = elapsed < best ? elapsed : best;
+		runs++;
+	}
+
+	return best;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *files[] = {
+		"graphics/clockface.bmp",
+		"graphics/hours_hand.bmp",
+		"graphics/minutes_hand.bmp",
+		"graphics/seconds_hand.bmp"
+	};
+	const char *kernelNames[] = { "scalar", "ssse3", "avx2" };
+
+	vector<Input> inputs;
+
+	for(int i = 0; i < 4; i++)
+	{
+		Input input;
+
+		if(loadInput(files[i], input))
+		{
+			inputs.push_back(input);
+		}
+		else
+		{
+			printf("skipping %s, could not read it\n", files[i]);
+		}
+	}
+
+	LONG sizes[][2] = { { 1920, 1080 }, { 4096, 4096 }, { 1023, 767 } };
+
+	for(int i = 0; i < 3; i++)
+	{
+		Input input;
+		makeInput(sizes[i][0], sizes[i][1], input);
+		inputs.push_back(input);
+	}
+
+	int supported = PixelConvert::getSupportedInstructionSet();
+	bool allMatch = true;
+
+	printf("%-28s %-8s %12s %12s %9s\n", "image", "kernel", "time (us)", "MB/s", "speedup");
+
+	for(size_t i = 0; i < inputs.size(); i++)
+	{
+		const Input &input = inputs[i];
+		vector<BYTE> expected(input.pixels.size());
+		vector<BYTE> output(input.pixels.size());
+		double megabytes = input.pixels.size() / 1e6;
+
+		double legacy = measure(input, &expected[0], -1, 0.2);
+		printf("%-28s %-8s %12.1f %12.1f %9.2f\n", input.name.c_str(), "legacy",
+			   legacy * 1e6, megabytes / legacy, 1.0);
+
+		for(int kernel = PixelConvert::SCALAR; kernel <= supported; kernel++)
+		{
+			PixelConvert::setInstructionSet((PixelConvert::InstructionSet)kernel);
+
+			double time = measure(input, &output[0], kernel, 0.2);
+			bool match = output == expected;
+			allMatch = allMatch && match;
+
+			printf("%-28s %-8s %12.1f %12.1f %9.2f%s\n", input.name.c_str(), kernelNames[kernel],
+				   time * 1e6, megabytes / time, legacy / time, match ? "" : "  MISMATCH");
+		}
+	}
+
+	return allMatch ? 0 : 1;
+}
@@ -0,0 +1,486 @@
+/*
+ * RenderBench.cpp
+ *
+ * Reproducible microbenchmarks of the image and sprite code, written as JSON
+ * so runs from different releases can be compared:
+ *
+ *  - ImageLoader::loadBMP in both load modes, on the clock's bitmaps and on
+ *    synthetic images of fixed sizes and contents
+ *  - the decoding ImageLoader::fixPadding does (BMPDecoder), on the same files
+ *  - ImageLoader::getAlpha and building the AlphaMask hit tests use
+ *  - Sprite::draw and SpriteBatch throughput into an offscreen Mesa surface
+ *  - Sprite::hitTest on a turning sprite
+ *  - whole frames (clear, turn every sprite, batch, finish) of 1, 100 and
+ *    10000 sprites
+ *
+ *   RenderBench [--json results.json]
+ *
+ * Every case runs for at least MIN_SECONDS and MIN_ITERATIONS, and reports
+ * the median and fastest iteration. Run it from the top of the repository
+ * so it finds graphics/.
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <GL/glut.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <time.h>
+#include <unistd.h>
+#include "ImageLoader.h"
+#include "AlphaMask.h"
+#include "BMPDecoder.h"
+#include "Sprite.h"
+#include "SpriteBatch.h"
+#include "TextureAtlas.h"
+#include "HeadlessContext.h"
+
+using namespace std;
+
+#define MIN_SECONDS 0.3
+#define MIN_ITERATIONS 10
+// sprites drawn per iteration of the draw throughput cases
+#define DRAWS_PER_ITERATION 1000
+#define SURFACE_SIZE 1024
+
+struct Result
+{
+	string name;
+	string input;
+	double medianSeconds;
+	double minSeconds;
+	int iterations;
+	// bytes or sprites handled per iteration, for the throughput columns
+	double bytes;
+	double sprites;
+};
+
+static vector<Result> results;
+
+static double now()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/**
+ * Runs the function until both limits are reached and records the median and
+ * fastest run. One untimed run comes first to warm up caches.
+ */
+template<typename Function>
+static Result &measure(const string &name, const string &input, Function function)
+{
+	vector<double> times;
+	double start = now();
+
+	function();
+
+	while((int)times.size() < MIN_ITERATIONS || now() - start < MIN_SECONDS)
+	{
+		double runStart = now();
+		function();
+		times.push_back(now() - runStart);
+	}
+
+	sort(times.begin(), times.end());
+
+	Result result;
+	result.name = name;
+	result.input = input;
+	result.medianSeconds = times[times.size() / 2];
+	result.minSeconds = times[0];
+	result.iterations = times.size();
+	result.bytes = 0;
+	result.sprites = 0;
+	results.push_back(result);
+
+	return results.back();
+}
+
+/**
+ * Writes a 32-bit bitmap of the given size with the same pseudo random
+ * contents every run, so the synthetic cases can be compared between runs.
+ */
+static bool writeSynthetic(const string &fileName, LONG width, LONG height)
+{
+	vector<BYTE> pixels(width * height * 4);
+	unsigned int seed = 12345;
+
+	for(size_t i = 0; i < pixels.size(); i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		pixels[i] = seed >> 16;
+	}
+
+	return ImageLoader::saveBMP(fileName.c_str(), width, height, &pixels[0]);
+}
+
+/**
+ * Decodes a bitmap file already in memory the way ImageLoader::fixPadding
+ * does when loading it, into a buffer for the whole image.
+ */
+static bool decode(const vector<BYTE> &file, vector<BYTE> &pixels)
+{
+	BITMAPFILEHEADER bmfh;
+	BITMAPINFOHEADER bmih;
+	DWORD masks[4] = { 0, 0, 0, 0 };
+
+	memcpy(&bmfh, &file[0], sizeof(bmfh));
+	memcpy(&bmih, &file[sizeof(bmfh)], sizeof(bmih));
+	memcpy(masks, &file[sizeof(bmfh) + sizeof(bmih)], sizeof(masks));
+
+	BMPDecoder decoder(bmih, masks, NULL, 0, &file[bmfh.bfOffBits], file.size() - bmfh.bfOffBits);
+
+	if(!decoder.isValid())
+	{
+		return false;
+	}
+
+	LONG stride = decoder.getWidth() * 4;
+	pixels.resize(stride * decoder.getHeight());
+
+	BYTE *target = &pixels[0];
+	LONG rows;
+
+	while((rows = decoder.decodeRows(target, stride, 16)) > 0)
+	{
+		target += rows * stride;
+	}
+
+	return true;
+}
+
+static bool readFile(const string &fileName, vector<BYTE> &file)
+{
+	FILE *in = fopen(fileName.c_str(), "rb");
+
+	if(in == NULL)
+	{
+		return false;
+	}
+
+	fseek(in, 0, SEEK_END);
+	file.resize(ftell(in));
+	fseek(in, 0, SEEK_SET);
+
+	bool read = fread(&file[0], 1, file.size(), in) == file.size();
+	fclose(in);
+
+	return read && file.size() > sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER) + 16;
+}
+
+static void benchImage(const string &fileName, const string &label)
+{
+	ImageLoader image(fileName.c_str());
+
+	if(!image.getLoaded())
+	{
+		printf("skipping %s, could not load it\n", fileName.c_str());
+		return;
+	}
+
+	double bytes = (double)image.getWidth() * image.getHeight() * 4;
+	char input[256];
+
+	snprintf(input, sizeof(input), "%s %dx%d", label.c_str(), (int)image.getWidth(), (int)image.getHeight());
+
+	measure("loadBMP convert", input, [&]() {
+		ImageLoader loaded(fileName.c_str(), ImageLoader::CONVERT);
+	}).bytes = bytes;
+
+	measure("loadBMP native", input, [&]() {
+		ImageLoader loaded(fileName.c_str(), ImageLoader::NATIVE);
+	}).bytes = bytes;
+
+	vector<BYTE> file;
+	vector<BYTE> pixels;
+
+	if(readFile(fileName, file) && decode(file, pixels))
+	{
+		measure("fixPadding", input, [&]() {
+			decode(file, pixels);
+		}).bytes = bytes;
+	}
+
+	measure("getAlpha", input, [&]() {
+		delete[] image.getAlpha();
+	}).bytes = bytes;
+
+	measure("AlphaMask", input, [&]() {
+		AlphaMask mask(image.getAlphaPlane(), image.getWidth(), image.getHeight());
+	}).bytes = bytes;
+}
+
+/**
+ * Places count copies of the sprite in a square grid filling the surface,
+ * each scaled to its cell.
+ */
+static void layoutGrid(vector<Sprite *> &sprites, const Sprite &sprite, int count)
+{
+	int columns = (int)ceil(sqrt((double)count));
+	GLfloat cell = (GLfloat)SURFACE_SIZE / columns;
+	GLfloat scale = cell / max(sprite.getImage()->getWidth(), sprite.getImage()->getHeight());
+
+	for(int i = 0; i < count; i++)
+	{
+		Sprite *copy = new Sprite(sprite);
+
+		copy->setScale(scale, scale);
+		copy->setX(-SURFACE_SIZE / 2 + (i % columns + 0.5f) * cell);
+		copy->setY(-SURFACE_SIZE / 2 + (i / columns + 0.5f) * cell);
+		sprites.push_back(copy);
+	}
+}
+
+static void benchSprites(Sprite &face, Sprite &hand)
+{
+	SpriteBatch batch;
+	GLfloat angle = 0;
+
+	// throughput of single sprites, the hand at its natural size
+	measure("Sprite::draw", "seconds hand x1000", [&]() {
+		for(int i = 0; i < DRAWS_PER_ITERATION; i++)
+		{
+			hand.setAngle(angle++);
+			hand.draw();
+		}
+
+		glFinish();
+	}).sprites = DRAWS_PER_ITERATION;
+
+	measure("SpriteBatch", "seconds hand x1000", [&]() {
+		batch.begin();
+
+		for(int i = 0; i < DRAWS_PER_ITERATION; i++)
+		{
+			hand.setAngle(angle++);
+			batch.add(hand);
+		}
+
+		batch.flush();
+		glFinish();
+	}).sprites = DRAWS_PER_ITERATION;
+
+	// points on a square around the pivot, half of them on the hand's side
+	int hits = 0;
+
+	measure("Sprite::hitTest", "seconds hand x1000", [&]() {
+		for(int i = 0; i < DRAWS_PER_ITERATION; i++)
+		{
+			hand.setAngle(angle++);
+			hits += hand.hitTest(hand.getX() + i % 32 - 16, hand.getY() + i % 200);
+		}
+	}).sprites = DRAWS_PER_ITERATION;
+
+	// whole frames the way the clock draws them, everything batched
+	int counts[] = { 1, 100, 10000 };
+
+	for(int c = 0; c < 3; c++)
+	{
+		vector<Sprite *> sprites;
+		char input[64];
+
+		layoutGrid(sprites, face, counts[c]);
+		snprintf(input, sizeof(input), "%d sprites %dx%d", counts[c], SURFACE_SIZE, SURFACE_SIZE);
+
+		measure("frame", input, [&]() {
+			glClear(GL_COLOR_BUFFER_BIT);
+			batch.begin();
+
+			for(size_t i = 0; i < sprites.size(); i++)
+			{
+				sprites[i]->rotate(1);
+				batch.add(*sprites[i]);
+			}
+
+			batch.flush();
+			glFinish();
+		}).sprites = counts[c];
+
+		for(size_t i = 0; i < sprites.size(); i++)
+		{
+			delete sprites[i];
+		}
+	}
+}
+
+static void printResults()
+{
+	printf("%-16s %-34s %12s %12s %12s\n", "benchmark", "input", "median (us)", "MB/s", "sprites/s");
+
+	for(size_t i = 0; i < results.size(); i++)
+	{
+		const Result &result = results[i];
+		double rate = 1 / result.medianSeconds;
+
+		printf("%-16s %-34s %12.1f", result.name.c_str(), result.input.c_str(), result.medianSeconds * 1e6);
+
+		if(result.bytes > 0)
+		{
+			printf(" %12.1f", result.bytes * rate / 1e6);
+		}
+		else
+		{
+			printf(" %12s", "-");
+		}
+
+		if(result.sprites > 0)
+		{
+			printf(" %12.0f\n", result.sprites * rate);
+		}
+		else
+		{
+			printf(" %12s\n", "-");
+		}
+	}
+}
+
+static bool writeJSON(const char *fileName)
+{
+	FILE *file = fopen(fileName, "w");
+
+	if(file == NULL)
+	{
+		printf("Error: cannot write %s\n", fileName);
+		return false;
+	}
+
+	fprintf(file, "{\n  \"benchmark\": \"RenderBench\",\n  \"results\": [");
+
+	for(size_t i = 0; i < results.size(); i++)
+	{
+		const Result &result = results[i];
+
+		fprintf(file, "%s\n    { \"name\": \"%s\", \"input\": \"%s\", \"median_us\": %.3f, \"min_us\": %.3f, \"iterations\": %d",
+				i > 0 ? "," : "", result.name.c_str(), result.input.c_str(),
+				result.medianSeconds * 1e6, result.minSeconds * 1e6, result.iterations);
+
+		if(result.bytes > 0)
+		{
+			fprintf(file, ", \"mb_per_s\": %.3f", result.bytes / result.medianSeconds / 1e6);
+		}
+
+		if(result.sprites > 0)
+		{
+			fprintf(file, ", \"sprites_per_s\": %.1f", result.sprites / result.medianSeconds);
+		}
+
+		if(result.name == "frame")
+		{
+			fprintf(file, ", \"fps\": %.2f", 1 / result.medianSeconds);
+		}
+
+		fprintf(file, " }");
+	}
+
+	fprintf(file, "\n  ]\n}\n");
+
+	return fclose(file) == 0;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *jsonFile = NULL;
+
+	for(int i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+		{
+			jsonFile = argv[++i];
+		}
+	}
+
+	const char *files[] = { "graphics/clockface.bmp", "graphics/hours_hand.bmp",
+							"graphics/minutes_hand.bmp", "graphics/seconds_hand.bmp" };
+
+	for(int i = 0; i < 4; i++)
+	{
+		benchImage(files[i], files[i]);
+	}
+
+	LONG sizes[] = { 64, 256, 1024, 2048 };
+
+	for(int i = 0; i < 4; i++)
+	{
+		char fileName[256];
+
+		snprintf(fileName, sizeof(fileName), "/tmp/RenderBench-%d-%ld.bmp", (int)getpid(), (long)sizes[i]);
+
+		if(writeSynthetic(fileName, sizes[i], sizes[i]))
+		{
+			benchImage(fileName, "synthetic");
+			unlink(fileName);
+		}
+	}
+
+	HeadlessContext context(SURFACE_SIZE, SURFACE_SIZE);
+
+	if(context.isValid())
+	{
+		// the state init() and reshape() in main.cpp set up
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glClearColor(1.0, 1.0, 1.0, 0.0);
+		glViewport(0, 0, SURFACE_SIZE, SURFACE_SIZE);
+		glMatrixMode(GL_PROJECTION);
+		glLoadIdentity();
+		glOrtho(-SURFACE_SIZE/2, SURFACE_SIZE/2, -SURFACE_SIZE/2, SURFACE_SIZE/2, -1.0, 1.0);
+		glMatrixMode(GL_MODELVIEW);
+		glLoadIdentity();
+
+		Sprite face("graphics/clockface.bmp");
+		Sprite hand("graphics/seconds_hand.bmp");
+		TextureAtlas atlas;
+
+		face.setPivot(0.5, 0.5);
+		hand.setPivot(0.5, 0.0545);
+		face.setX(0);
+		face.setY(0);
+		hand.setX(0);
+		hand.setY(0);
+		atlas.add(&face);
+		atlas.add(&hand);
+		atlas.build();
+
+		benchSprites(face, hand);
+	}
+	else
+	{
+		printf("skipping the sprite benchmarks, no offscreen OpenGL\n");
+	}
+
+	printResults();
+
+	if(jsonFile != NULL)
+	{
+		if(!writeJSON(jsonFile))
+		{
+			return 1;
+		}
+
+		printf("results written to %s\n", jsonFile);
+	}
+
+	return 0;
+}
@@ -0,0 +1,375 @@
+/*
+ * RenderServiceBench.cpp
+ *
+ * Generates load for a RenderService on a Unix socket and reports the median
+ * and 99th percentile latency of its requests and the requests served a
+ * second, with 1 to 32 clients sending one request after another over
+ * connections of their own:
+ *
+ *   hits    the same minute over and over, every image comes from the cache
+ *   misses  a different second every request, every image is rendered
+ *   mixed   nine in ten requests for a minute shown recently, one in ten new
+ *
+ *   RenderServiceBench [--software] [--threads N] [--size S]
+ *
+ * Run it from the top of the repository so it finds graphics/.
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <GL/glut.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "RenderService.h"
+#include "Sprite.h"
+
+using namespace std;
+
+// every case runs for this long
+#define CASE_SECONDS 1.0
+// a request taking longer than this means the service is not running
+#define TIMEOUT_SECONDS 10
+// minutes the mixed case comes back to
+#define HOT_MINUTES 60
+
+enum Scenario
+{
+	HITS,
+	MISSES,
+	MIXED
+};
+
+static const char *scenarioNames[] = { "hits", "misses", "mixed" };
+static const int clientCounts[] = { 1, 8, 32 };
+
+struct Result
+{
+	vector<double> latencies;
+	long rejected;
+	long failed;
+};
+
+// the times asked for by the misses, never the same second twice
+static atomic<long> nextMiss(1700000000);
+
+static double now()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+static int connectTo(const string &path)
+{
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	struct sockaddr_un address;
+	struct timeval timeout = { TIMEOUT_SECONDS, 0 };
+
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+	if(fd < 0 || connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0)
+	{
+		perror("Error");
+
+		if(fd >= 0)
+		{
+			close(fd);
+		}
+
+		return -1;
+	}
+
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	return fd;
+}
+
+/**
+ * Sends a request and reads the whole response.
+ * @param input Bytes received but not read yet, kept between requests.
+ * @return The status, or -1 if the connection failed.
+ */
+static int request(int fd, const string &path, string &input)
+{
+	string text = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+	if(write(fd, text.data(), text.size()) != (ssize_t)text.size())
+	{
+		return -1;
+	}
+
+	size_t end;
+	char buffer[65536];
+
+	while((end = input.find("\r\n\r\n")) == string::npos)
+	{
+		ssize_t count = read(fd, buffer, sizeof(buffer));
+
+		if(count <= 0)
+		{
+			return -1;
+		}
+
+		input.append(buffer, count);
+	}
+
+	int status = 0;
+	size_t length = 0;
+	const char *contentLength = strstr(input.c_str(), "Content-Length: ");
+
+	sscanf(input.c_str(), "HTTP/1.1 %d", &status);
+
+	if(contentLength != NULL && (size_t)(contentLength - input.c_str()) < end)
+	{
+		length = strtoul(contentLength + strlen("Content-Length: "), NULL, 10);
+	}
+
+	while(input.size() < end + 4 + length)
+	{
+		ssize_t count = read(fd, buffer, sizeof(buffer));
+
+		if(count <= 0)
+		{
+			return -1;
+		}
+
+		input.append(buffer, count);
+	}
+
+	input.erase(0, end + 4 + length);
+
+	return status;
+}
+
+static void runClient(const string &socketPath, Scenario scenario, int size, int seed, double until, Result *result)
+{
+	int fd = connectTo(socketPath);
+	string input;
+	unsigned int random = seed * 2654435761u + 1;
+
+	result->rejected = 0;
+	result->failed = 0;
+
+	while(fd >= 0 && now() < until)
+	{
+		long time;
+		random = random * 1103515245 + 12345;
+
+		if(scenario == HITS)
+		{
+			time = 1700000000;
+		}
+		else if(scenario == MISSES || (random >> 16) % 10 == 0)
+		{
+			time = nextMiss++;
+		}
+		else
+		{
+			// whole minutes of another day than the misses
+			time = 1600000000 + (long)((random >> 16) % HOT_MINUTES) * 60;
+		}
+
+		char path[128];
+		snprintf(path, sizeof(path), "/clock?time=%ld&size=%d", time, size);
+
+		double start = now();
+		int status = request(fd, path, input);
+
+		if(status == 200)
+		{
+			result->latencies.push_back(now() - start);
+		}
+		else if(status == 503)
+		{
+			result->rejected++;
+		}
+		else
+		{
+			result->failed++;
+			break;
+		}
+	}
+
+	if(fd >= 0)
+	{
+		close(fd);
+	}
+}
+
+/**
+ * Runs the clients for CASE_SECONDS and prints a line of results.
+ * @return False if any request failed.
+ */
+static bool measure(const string &socketPath, Scenario scenario, int clients, int size)
+{
+	vector<Result> results(clients);
+	vector<thread> threads;
+	double start = now();
+
+	for(int i = 0; i < clients; i++)
+	{
+		threads.push_back(thread(runClient, socketPath, scenario, size, i, start + CASE_SECONDS, &results[i]));
+	}
+
+	for(int i = 0; i < clients; i++)
+	{
+		threads[i].join();
+	}
+
+	double elapsed = now() - start;
+	vector<double> latencies;
+	long rejected = 0;
+	long failed = 0;
+
+	for(int i = 0; i < clients; i++)
+	{
+		latencies.insert(latencies.end(), results[i].latencies.begin(), results[i].latencies.end());
+		rejected += results[i].rejected;
+		failed += results[i].failed;
+	}
+
+	sort(latencies.begin(), latencies.end());
+
+	double p50 = latencies.empty() ? 0 : latencies[latencies.size() / 2];
+	double p99 = latencies.empty() ? 0 : latencies[latencies.size() * 99 / 100];
+
+	printf("%8s %8d %10.3f %10.3f %10.1f %8ld\n", scenarioNames[scenario], clients, p50 * 1000, p99 * 1000,
+		   latencies.size() / elapsed, rejected);
+
+	return failed == 0;
+}
+
+int main(int argc, char *argv[])
+{
+	bool software = false;
+	int threads = max(1u, thread::hardware_concurrency());
+	int size = 256;
+
+	for(int i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], "--software") == 0)
+		{
+			software = true;
+		}
+		else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+		{
+			threads = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+		{
+			size = atoi(argv[++i]);
+		}
+	}
+
+	Sprite face("graphics/clockface.bmp");
+	Sprite hoursHand("graphics/hours_hand.bmp");
+	Sprite minutesHand("graphics/minutes_hand.bmp");
+	Sprite secondsHand("graphics/seconds_hand.bmp");
+	Sprite *sprites[] = { &face, &hoursHand, &minutesHand, &secondsHand };
+	GLfloat pivots[][2] = { { 0.5, 0.5 }, { 0.5, 0.075 }, { 0.5, 0.0566 }, { 0.5, 0.0545 } };
+
+	for(int i = 0; i < 4; i++)
+	{
+		if(sprites[i]->getImage()->getPixelData() == NULL)
+		{
+			printf("Error: run the benchmark from the top of the repository\n");
+			return 1;
+		}
+
+		sprites[i]->setPivot(pivots[i][0], pivots[i][1]);
+		sprites[i]->setX(0);
+		sprites[i]->setY(0);
+	}
+
+	char directory[] = "/tmp/RenderServiceBench.XXXXXX";
+
+	if(mkdtemp(directory) == NULL)
+	{
+		perror("Error");
+		return 1;
+	}
+
+	string socketPath = string(directory) + "/clock.sock";
+	// the default cache and queue of --serve
+	RenderService service(threads, software, size, size, 64 << 20, 256);
+	bool ok = false;
+
+	service.addSkin("default", sprites);
+
+	if(service.listen(socketPath))
+	{
+		thread server(&RenderService::run, &service);
+		string input;
+		int fd = connectTo(socketPath);
+
+		// renders the hits' image and waits for the render threads to start
+		ok = fd >= 0 && request(fd, "/clock?time=1700000000&size=" + to_string(size), input) == 200;
+
+		if(fd >= 0)
+		{
+			close(fd);
+		}
+
+		if(ok)
+		{
+			printf("%dx%d images, %s renderer, %d render thread%s, %u processors\n", size, size,
+				   software ? "software" : "OpenGL", software ? threads : 1, software && threads > 1 ? "s" : "",
+				   thread::hardware_concurrency());
+			printf("%8s %8s %10s %10s %10s %8s\n", "case", "clients", "p50 (ms)", "p99 (ms)", "requests/s", "503s");
+
+			for(int scenario = HITS; scenario <= MIXED && ok; scenario++)
+			{
+				for(size_t i = 0; i < sizeof(clientCounts) / sizeof(clientCounts[0]) && ok; i++)
+				{
+					ok = measure(socketPath, (Scenario)scenario, clientCounts[i], size);
+				}
+			}
+		}
+		else
+		{
+			printf("Error: the service did not answer\n");
+		}
+
+		service.stop();
+		server.join();
+
+		// the counters belong to the thread that ran the service
+		if(ok)
+		{
+			printf("%s\n", service.getStats().c_str());
+		}
+	}
+
+	unlink(socketPath.c_str());
+	rmdir(directory);
+
+	return ok ? 0 : 1;
+}
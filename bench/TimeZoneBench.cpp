@@ -0,0 +1,256 @@
+/*
+ * TimeZoneBench.cpp
+ *
+ * Measures the time it takes to point the hands of a wall of clocks in many
+ * timezones at a new time: with localtime_r() switching TZ for every clock,
+ * with localtime_r() in a single zone (the cost of the C library alone), with
+ * a TimeZone lookup for every clock, and with the offsets kept until the next
+ * transition of every zone the way ClockWall does.
+ *
+ *   TimeZoneBench [clocks] [zone1970.tab]
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <time.h>
+#include "ClockWall.h"
+#include "RotationTable.h"
+#include "TimeZone.h"
+
+using namespace std;
+
+// every measurement runs for at least this long and this many ticks
+#define MIN_SECONDS 0.5
+#define MIN_TICKS 3
+#define DEFAULT_CLOCKS 10000
+#define SECONDS_PER_DAY (24 * 60 * 60)
+
+enum Method
+{
+	LOCALTIME_PER_ZONE,
+	LOCALTIME,
+	TIMEZONE,
+	CACHED_SPANS,
+	METHOD_COUNT
+};
+
+static const char *methodNames[] = { "localtime_r, TZ set per clock", "localtime_r, one zone",
+									 "TimeZone::getOffset", "offsets kept until transitions" };
+
+static vector<string> zoneNames;
+static vector<const TimeZone *> zones;
+static vector<TimeZone::Span> spans;
+// the zone of every clock
+static vector<size_t> clockZones;
+
+static double now()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/**
+ * Reads the zone names of a zone.tab style file, the third column.
+ */
+static bool readZoneTable(const char *fileName)
+{
+	ifstream in(fileName);
+	string line;
+
+	if(!in)
+	{
+		printf("Error: cannot read the timezones in %s\n", fileName);
+		return false;
+	}
+
+	while(getline(in, line))
+	{
+		if(line.empty() || line[0] == '#')
+		{
+			continue;
+		}
+
+		istringstream fields(line);
+		string codes, coordinates, name;
+
+		if(fields >> codes >> coordinates >> name)
+		{
+			zoneNames.push_back(name);
+		}
+	}
+
+	return !zoneNames.empty();
+}
+
+static void addRotations(long secondsOfDay, unsigned long &checksum)
+{
+	const Rotation *rotations[3];
+
+	if(secondsOfDay < 0)
+	{
+		secondsOfDay += SECONDS_PER_DAY;
+	}
+
+	ClockWall::getRotations(secondsOfDay / 3600, secondsOfDay / 60 % 60, secondsOfDay % 60, rotations);
+
+	// keeps the compiler from dropping the work, and compares the methods
+	checksum += (rotations[0] - rotations[1]) + (rotations[2] - rotations[1]) * 7;
+}
+
+/**
+ * Points the hands of every clock at the given time.
+ * @return A sum of the rotations, the same for every method.
+ */
+static unsigned long tick(Method method, time_t unixTime)
+{
+	unsigned long checksum = 0;
+	struct tm local;
+
+	if(method == CACHED_SPANS)
+	{
+		for(size_t i = 0; i < zones.size(); i++)
+		{
+			if(unixTime < spans[i].from || unixTime >= spans[i].until)
+			{
+				spans[i] = zones[i]->getSpan(unixTime);
+			}
+		}
+	}
+
+	for(size_t i = 0; i < clockZones.size(); i++)
+	{
+		size_t zone = clockZones[i];
+		long offset = 0;
+
+		switch(method)
+		{
+		case LOCALTIME_PER_ZONE:
+			setenv("TZ", zoneNames[zone].c_str(), 1);
+			tzset();
+			localtime_r(&unixTime, &local);
+			offset = local.tm_gmtoff;
+			break;
+
+		case LOCALTIME:
+			localtime_r(&unixTime, &local);
+			offset = local.tm_gmtoff;
+			break;
+
+		case TIMEZONE:
+			offset = zones[zone]->getOffset(unixTime);
+			break;
+
+		default:
+			offset = spans[zone].offset;
+			break;
+		}
+
+		addRotations((unixTime + offset) % SECONDS_PER_DAY, checksum);
+	}
+
+	return checksum;
+}
+
+/**
+ * @return Microseconds per tick.
+ */
+static double measure(Method method, unsigned long &checksum)
+{
+	time_t time = 1700000000;
+	int ticks = 0;
+	double start = now();
+
+	checksum = tick(method, time);
+
+	do
+	{
+		tick(method, ++time);
+		ticks++;
+	} while(ticks < MIN_TICKS || now() - start < MIN_SECONDS);
+
+	return (now() - start) / (ticks + 1) * 1e6;
+}
+
+int main(int argc, char *argv[])
+{
+	size_t clocks = argc > 1 ? atol(argv[1]) : DEFAULT_CLOCKS;
+	const char *zoneTable = argc > 2 ? argv[2] : "/usr/share/zoneinfo/zone1970.tab";
+
+	if(clocks == 0 || !readZoneTable(zoneTable))
+	{
+		return 1;
+	}
+
+	double start = now();
+
+	for(size_t i = 0; i < zoneNames.size(); i++)
+	{
+		zones.push_back(TimeZone::get(zoneNames[i]));
+	}
+
+	printf("%d clocks in %d zones from %s, zones loaded in %.1f ms\n", (int)clocks, (int)zones.size(),
+		   zoneTable, (now() - start) * 1000);
+
+	TimeZone::Span unknown = { 0, 0, 0 };
+	spans.assign(zones.size(), unknown);
+
+	for(size_t i = 0; i < clocks; i++)
+	{
+		clockZones.push_back(i % zones.size());
+	}
+
+	// the single zone case uses the first zone for every clock, its result
+	// differs from the others
+	setenv("TZ", zoneNames[0].c_str(), 1);
+	tzset();
+
+	unsigned long expected = 0;
+
+	printf("%-32s %12s %14s\n", "method", "tick (us)", "per clock (ns)");
+
+	for(int method = 0; method < METHOD_COUNT; method++)
+	{
+		unsigned long checksum;
+		double micros = measure((Method)method, checksum);
+
+		if(method == LOCALTIME_PER_ZONE)
+		{
+			expected = checksum;
+		}
+
+		printf("%-32s %12.1f %14.1f%s\n", methodNames[method], micros, micros * 1000 / clocks,
+			   method != LOCALTIME && checksum != expected ? "  (wrong hands!)" : "");
+
+		if(method == LOCALTIME_PER_ZONE)
+		{
+			// put the single zone back
+			setenv("TZ", zoneNames[0].c_str(), 1);
+			tzset();
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,104 @@
+/*
+ * AlphaMask.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include "AlphaMask.h"
+
+AlphaMask::AlphaMask()
+{
+	width = 0;
+	height = 0;
+	wordsPerRow = 0;
+}
+
+AlphaMask::AlphaMask(const BYTE *alpha, LONG width, LONG height, BYTE threshold)
+{
+	this->width = width;
+	this->height = height;
+	wordsPerRow = (width + 63) / 64;
+
+	bits.assign((size_t)wordsPerRow * height, 0);
+	spans.resize(height);
+
+	for(LONG y = 0; y < height; y++)
+	{
+		const BYTE *row = alpha + (size_t)y * width;
+		uint64_t *rowBits = &bits[(size_t)y * wordsPerRow];
+		Span &span = spans[y];
+
+		// a word at a time without a branch per pixel
+		for(LONG word = 0; word < wordsPerRow; word++)
+		{
+			LONG start = word * 64;
+			LONG count = width - start < 64 ? width - start : 64;
+			uint64_t value = 0;
+
+			for(LONG bit = 0; bit < count; bit++)
+			{
+				value |= (uint64_t)(row[start + bit] >= threshold) << bit;
+			}
+
+			rowBits[word] = value;
+		}
+
+		span.first = width;
+		span.last = -1;
+
+		for(LONG word = 0; word < wordsPerRow; word++)
+		{
+			if(rowBits[word] != 0)
+			{
+				span.first = word * 64 + __builtin_ctzll(rowBits[word]);
+				break;
+			}
+		}
+
+		for(LONG word = wordsPerRow - 1; word >= 0; word--)
+		{
+			if(rowBits[word] != 0)
+			{
+				span.last = word * 64 + 63 - __builtin_clzll(rowBits[word]);
+				break;
+			}
+		}
+	}
+}
+
+AlphaMask::~AlphaMask()
+{
+}
+
+unsigned long AlphaMask::getCoveredCount() const
+{
+	unsigned long count = 0;
+
+	for(size_t i = 0; i < bits.size(); i++)
+	{
+		count += __builtin_popcountll(bits[i]);
+	}
+
+	return count;
+}
+
+unsigned long AlphaMask::getByteSize() const
+{
+	return bits.size() * sizeof(uint64_t) + spans.size() * sizeof(Span);
+}
@@ -0,0 +1,115 @@
+/*
+ * AlphaMask.h
+ *
+ * One bit per pixel of an image telling whether it is opaque enough to count
+ * as part of the image, e.g. to hit test clicks on a sprite. Every row also
+ * keeps the first and last covered columns, so most misses never touch the
+ * bits at all and empty rows can be skipped without scanning them.
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifndef ALPHAMASK_H_
+#define ALPHAMASK_H_
+
+#include <stdint.h>
+#include <vector>
+#include "ImageLoader.h"
+
+using namespace std;
+
+// pixels at least half opaque are covered
+#define DEFAULT_ALPHA_THRESHOLD 128
+
+class AlphaMask
+{
+public:
+	/**
+	 * The covered columns of a row, first > last if none are.
+	 */
+	struct Span
+	{
+		LONG first;
+		LONG last;
+	};
+
+	/**
+	 * Creates an empty mask, which covers nothing.
+	 */
+	AlphaMask();
+
+	/**
+	 * @param alpha width * height alpha values, bottom row first, e.g. from
+	 *        ImageLoader::getAlphaPlane().
+	 * @param threshold The smallest alpha that counts as covered.
+	 */
+	AlphaMask(const BYTE *alpha, LONG width, LONG height, BYTE threshold = DEFAULT_ALPHA_THRESHOLD);
+	virtual ~AlphaMask();
+
+	/**
+	 * @return True if pixel (x, y), counting from the bottom left, is covered.
+	 *         Pixels outside the image are not.
+	 */
+	bool contains(LONG x, LONG y) const
+	{
+		if(y < 0 || y >= height || x < spans[y].first || x > spans[y].last)
+		{
+			return false;
+		}
+
+		return (bits[y * wordsPerRow + (x >> 6)] >> (x & 63)) & 1;
+	}
+
+	/**
+	 * @return The covered columns of row y, counting from the bottom.
+	 */
+	const Span &getRowSpan(LONG y) const
+	{
+		return spans[y];
+	}
+
+	/**
+	 * @return The number of covered pixels.
+	 */
+	unsigned long getCoveredCount() const;
+
+	/**
+	 * @return The memory the bits and the spans take, in bytes.
+	 */
+	unsigned long getByteSize() const;
+
+	LONG getWidth() const
+	{
+		return width;
+	}
+
+	LONG getHeight() const
+	{
+		return height;
+	}
+
+private:
+	LONG width;
+	LONG height;
+	LONG wordsPerRow;
+	vector<uint64_t> bits;
+	vector<Span> spans;
+};
+
+#endif /* ALPHAMASK_H_ */
@@ -0,0 +1,172 @@
+/*
+ * AssetLoader.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include "AssetLoader.h"
+#include "ImageLoader.h"
+#include "TextureCache.h"
+
+AssetLoader::AssetLoader(int threadCount)
+{
+	outstanding = 0;
+	stopping = false;
+
+	if(threadCount <= 0)
+	{
+		threadCount = thread::hardware_concurrency();
+	}
+
+	// hardware_concurrency() may not know
+	if(threadCount <= 0)
+	{
+		threadCount = 1;
+	}
+
+	for(int i = 0; i < threadCount; i++)
+	{
+		workers.push_back(thread(&AssetLoader::work, this));
+	}
+}
+
+AssetLoader::~AssetLoader()
+{
+	{
+		unique_lock<mutex> guard(lock);
+		stopping = true;
+		pending.clear();
+	}
+
+	workQueued.notify_all();
+
+	for(size_t i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+
+	for(size_t i = 0; i < decoded.size(); i++)
+	{
+		delete decoded[i].image;
+	}
+}
+
+void AssetLoader::add(const string &filename)
+{
+	if(TextureCache::contains(filename))
+	{
+		return;
+	}
+
+	{
+		unique_lock<mutex> guard(lock);
+
+		if(!queued.insert(filename).second)
+		{
+			return;
+		}
+
+		pending.push_back(filename);
+		outstanding++;
+	}
+
+	workQueued.notify_one();
+}
+
+bool AssetLoader::next(string &filename)
+{
+	Result result;
+
+	{
+		unique_lock<mutex> guard(lock);
+
+		if(outstanding == 0)
+		{
+			return false;
+		}
+
+		while(decoded.empty())
+		{
+			imageDecoded.wait(guard);
+		}
+
+		result = decoded.front();
+		decoded.pop_front();
+		outstanding--;
+	}
+
+	// outside the lock, the workers go on decoding meanwhile
+	TextureCache::insert(result.filename, result.image);
+	CpuProfiler::addThreadTimes(result.times);
+	filename = result.filename;
+
+	return true;
+}
+
+void AssetLoader::finish()
+{
+	string filename;
+
+	while(next(filename))
+	{
+	}
+}
+
+int AssetLoader::getThreadCount() const
+{
+	return workers.size();
+}
+
+void AssetLoader::work()
+{
+	for(;;)
+	{
+		string filename;
+
+		{
+			unique_lock<mutex> guard(lock);
+
+			while(pending.empty() && !stopping)
+			{
+				workQueued.wait(guard);
+			}
+
+			if(stopping)
+			{
+				return;
+			}
+
+			filename = pending.front();
+			pending.pop_front();
+		}
+
+		// the slow part, decoding and building the mip chain, without the lock
+		Result result;
+		result.filename = filename;
+		result.image = TextureCache::loadImage(filename);
+		CpuProfiler::takeThreadTimes(result.times);
+
+		{
+			unique_lock<mutex> guard(lock);
+			decoded.push_back(result);
+		}
+
+		imageDecoded.notify_one();
+	}
+}
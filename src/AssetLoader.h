@@ -0,0 +1,118 @@
+/*
+ * AssetLoader.h
+ *
+ * Decodes images on a pool of worker threads and hands them to TextureCache,
+ * so loading many of them at startup takes about as long as the slowest
+ * worker instead of the sum of all images. Only decoding runs on the
+ * workers; the thread that owns the GL context takes the decoded images
+ * with next() or finish() and does all the texture uploads itself.
+ *
+ *   AssetLoader loader;
+ *   loader.add("graphics/clockface.bmp");
+ *   ...
+ *   while(loader.next(filename))
+ *       TextureCache::getTexture(filename); // upload while the rest decodes
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifndef ASSETLOADER_H_
+#define ASSETLOADER_H_
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "CpuProfiler.h"
+
+using namespace std;
+
+class ImageLoader;
+
+class AssetLoader
+{
+public:
+	/**
+	 * Starts the workers.
+	 * @param threadCount 0 for one per processor.
+	 */
+	AssetLoader(int threadCount = 0);
+
+	/**
+	 * Stops the workers once the images they are decoding are done. Images
+	 * that were not handed to TextureCache yet are thrown away.
+	 */
+	virtual ~AssetLoader();
+
+	/**
+	 * Queues an image to be decoded, unless it is in TextureCache already or
+	 * was queued before.
+	 */
+	void add(const string &filename);
+
+	/**
+	 * Waits for the next image to be decoded and adds it to TextureCache, and
+	 * the time spent decoding it to the profiler's totals. Must be called from
+	 * the thread using TextureCache, which is the one owning the GL context.
+	 * @param filename Receives the path of the image.
+	 * @return False once all queued images were handed out.
+	 */
+	bool next(string &filename);
+
+	/**
+	 * Waits for all queued images and adds them to TextureCache, without
+	 * uploading any of them.
+	 */
+	void finish();
+
+	int getThreadCount() const;
+
+private:
+	struct Result
+	{
+		string filename;
+		ImageLoader *image;
+		// the sections timed while decoding it
+		CpuProfiler::Times times;
+	};
+
+	vector<thread> workers;
+	mutex lock;
+	// signalled when there is work to do or the workers should stop
+	condition_variable workQueued;
+	// signalled when an image was decoded
+	condition_variable imageDecoded;
+	deque<string> pending;
+	deque<Result> decoded;
+	set<string> queued;
+	// images queued and not handed out yet
+	int outstanding;
+	bool stopping;
+
+	void work();
+
+	// the workers cannot be copied along with the loader
+	AssetLoader(const AssetLoader &other);
+	AssetLoader &operator=(const AssetLoader &other);
+};
+
+#endif /* ASSETLOADER_H_ */
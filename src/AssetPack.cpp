@@ -0,0 +1,230 @@
+/*
+ * AssetPack.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "AssetPack.h"
+#include "LZ4Block.h"
+
+// pixel data starts on cache line boundaries
+#define DATA_ALIGNMENT 64
+
+AssetPack::AssetPack()
+{
+	mapping = NULL;
+	mappingSize = 0;
+	entries = NULL;
+	count = 0;
+}
+
+AssetPack::~AssetPack()
+{
+	close();
+}
+
+bool AssetPack::open(const char *fileName)
+{
+	struct stat info;
+
+	close();
+
+	int in = ::open(fileName, O_RDONLY);
+
+	if(in < 0)
+	{
+		return false;
+	}
+
+	if(fstat(in, &info) != 0 || (size_t)info.st_size < sizeof(ASSETPACKHEADER))
+	{
+		::close(in);
+		return false;
+	}
+
+	BYTE *file = (BYTE *)mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, in, 0);
+	::close(in);
+
+	if(file == MAP_FAILED)
+	{
+		return false;
+	}
+
+	ASSETPACKHEADER header;
+	memcpy(&header, file, sizeof(header));
+
+	if(header.magic != ASSET_PACK_MAGIC || header.version != ASSET_PACK_VERSION ||
+	   sizeof(header) + (size_t)header.count * sizeof(ASSETPACKENTRY) > (size_t)info.st_size)
+	{
+		printf("Error: %s is not a valid asset pack.\n", fileName);
+		munmap(file, info.st_size);
+		return false;
+	}
+
+	mapping = file;
+	mappingSize = info.st_size;
+	entries = (const ASSETPACKENTRY *)(file + sizeof(header));
+	count = header.count;
+
+	return true;
+}
+
+void AssetPack::close()
+{
+	if(mapping != NULL)
+	{
+		munmap(mapping, mappingSize);
+	}
+
+	mapping = NULL;
+	mappingSize = 0;
+	entries = NULL;
+	count = 0;
+}
+
+bool AssetPack::isOpen() const
+{
+	return mapping != NULL;
+}
+
+const ASSETPACKENTRY *AssetPack::find(const string &name) const
+{
+	for(DWORD i = 0; i < count; i++)
+	{
+		if(strncmp(entries[i].name, name.c_str(), ASSET_NAME_LENGTH) == 0)
+		{
+			return &entries[i];
+		}
+	}
+
+	return NULL;
+}
+
+bool AssetPack::extract(const ASSETPACKENTRY &entry, BYTE *destination) const
+{
+	DWORD rawSize = entry.width * entry.height * 4;
+
+	if(entry.offset > mappingSize || entry.size > mappingSize - entry.offset)
+	{
+		return false;
+	}
+
+	const BYTE *data = mapping + entry.offset;
+
+	if(entry.compression == COMPRESSION_LZ4)
+	{
+		return LZ4Block::decompress(destination, rawSize, data, entry.size);
+	}
+
+	if(entry.compression != COMPRESSION_NONE || entry.size != rawSize)
+	{
+		return false;
+	}
+
+	memcpy(destination, data, rawSize);
+	return true;
+}
+
+bool AssetPack::write(const char *fileName, const vector<Asset> &assets, bool compress)
+{
+	ASSETPACKHEADER header;
+	vector<ASSETPACKENTRY> packEntries(assets.size());
+	vector< vector<BYTE> > data(assets.size());
+
+	header.magic = ASSET_PACK_MAGIC;
+	header.version = ASSET_PACK_VERSION;
+	header.count = assets.size();
+
+	DWORD offset = sizeof(header) + assets.size() * sizeof(ASSETPACKENTRY);
+
+	for(size_t i = 0; i < assets.size(); i++)
+	{
+		const Asset &asset = assets[i];
+		ASSETPACKENTRY &entry = packEntries[i];
+		DWORD rawSize = asset.width * asset.height * 4;
+
+		if(asset.name.size() >= ASSET_NAME_LENGTH || asset.pixels.size() != rawSize)
+		{
+			printf("Error: cannot store %s in an asset pack.\n", asset.name.c_str());
+			return false;
+		}
+
+		memset(&entry, 0, sizeof(entry));
+		strncpy(entry.name, asset.name.c_str(), ASSET_NAME_LENGTH - 1);
+		entry.width = asset.width;
+		entry.height = asset.height;
+		entry.pivotX = asset.pivotX;
+		entry.pivotY = asset.pivotY;
+		entry.flags = PREMULTIPLIED;
+		entry.compression = COMPRESSION_NONE;
+		data[i] = asset.pixels;
+
+		if(compress)
+		{
+			vector<BYTE> compressed(LZ4Block::getMaxCompressedSize(rawSize));
+			compressed.resize(LZ4Block::compress(&compressed[0], &asset.pixels[0], rawSize));
+
+			if(compressed.size() < rawSize)
+			{
+				entry.compression = COMPRESSION_LZ4;
+				data[i].swap(compressed);
+			}
+		}
+
+		offset = (offset + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+		entry.offset = offset;
+		entry.size = data[i].size();
+		offset += entry.size;
+	}
+
+	FILE *out = fopen(fileName, "wb");
+
+	if(out == NULL)
+	{
+		perror("Error");
+		return false;
+	}
+
+	bool result = fwrite(&header, sizeof(header), 1, out) == 1;
+
+	if(!packEntries.empty())
+	{
+		result = result && fwrite(&packEntries[0], sizeof(ASSETPACKENTRY), packEntries.size(), out) == packEntries.size();
+	}
+
+	for(size_t i = 0; i < data.size() && result; i++)
+	{
+		// pad up to the aligned offset of the entry
+		static const BYTE zeros[DATA_ALIGNMENT] = { 0 };
+		size_t gap = packEntries[i].offset - ftell(out);
+
+		result = fwrite(zeros, 1, gap, out) == gap &&
+				 fwrite(&data[i][0], 1, data[i].size(), out) == data[i].size();
+	}
+
+	fclose(out);
+
+	return result;
+}
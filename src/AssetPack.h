@@ -0,0 +1,129 @@
+/*
+ * AssetPack.h
+ *
+ * A single file holding all the images of the clock, already decoded into
+ * the layout the renderers use: premultiplied RGBA rows, bottom row first,
+ * without padding. Every image is stored with its size and default pivot and
+ * may be LZ4 compressed. Packs are built by tools/AssetCompiler and read
+ * through ImageLoader::loadPack().
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifndef ASSETPACK_H_
+#define ASSETPACK_H_
+
+#include <string>
+#include <vector>
+#include "ImageLoader.h"
+
+using namespace std;
+
+#define ASSET_PACK_MAGIC 0x4b504341 // "ACPK"
+#define ASSET_PACK_VERSION 1
+#define ASSET_NAME_LENGTH 64
+
+//File header, followed by count entries and then the pixel data
+typedef struct __attribute__ ((__packed__)) tagASSETPACKHEADER
+{
+  DWORD  magic;
+  DWORD  version;
+  DWORD  count;
+} ASSETPACKHEADER;
+
+typedef struct __attribute__ ((__packed__)) tagASSETPACKENTRY
+{
+  char   name[ASSET_NAME_LENGTH];
+  LONG   width;
+  LONG   height;
+  float  pivotX;
+  float  pivotY;
+  DWORD  flags;
+  DWORD  compression;
+  DWORD  offset;
+  DWORD  size;
+} ASSETPACKENTRY;
+
+class AssetPack
+{
+public:
+	enum Flags
+	{
+		PREMULTIPLIED = 1
+	};
+
+	enum Compression
+	{
+		COMPRESSION_NONE = 0,
+		COMPRESSION_LZ4 = 1
+	};
+
+	/**
+	 * An image to write into a pack
+	 */
+	struct Asset
+	{
+		string name;
+		LONG width;
+		LONG height;
+		float pivotX;
+		float pivotY;
+		//premultiplied RGBA, bottom row first
+		vector<BYTE> pixels;
+	};
+
+	AssetPack();
+	virtual ~AssetPack();
+
+	/**
+	 * Maps the given pack into memory.
+	 * @return True on success false on failure
+	 */
+	bool open(const char *fileName);
+	void close();
+	bool isOpen() const;
+
+	/**
+	 * @return The entry stored under the given name, e.g.
+	 *         "graphics/clockface.bmp", or NULL if there is none.
+	 */
+	const ASSETPACKENTRY *find(const string &name) const;
+
+	/**
+	 * Copies or decompresses the pixels of an entry.
+	 * @param destination Receives width * height * 4 bytes.
+	 * @return False if the data is corrupt.
+	 */
+	bool extract(const ASSETPACKENTRY &entry, BYTE *destination) const;
+
+	/**
+	 * Writes the given images into a new pack.
+	 * @param compress Stores the pixels LZ4 compressed where that saves space.
+	 * @return True on success false on failure
+	 */
+	static bool write(const char *fileName, const vector<Asset> &assets, bool compress);
+
+private:
+	BYTE *mapping;
+	DWORD mappingSize;
+	const ASSETPACKENTRY *entries;
+	DWORD count;
+};
+
+#endif /* ASSETPACK_H_ */
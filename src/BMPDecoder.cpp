@@ -0,0 +1,335 @@
+/*
+ * BMPDecoder.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <cstdio>
+#include <cstring>
+#include "BMPDecoder.h"
+#include "PixelConvert.h"
+
+// RLE escape codes, they follow a zero count byte
+#define RLE_END_OF_LINE 0
+#define RLE_END_OF_BITMAP 1
+#define RLE_DELTA 2
+
+BMPDecoder::BMPDecoder(const BITMAPINFOHEADER &header, const DWORD *masks,
+					   const RGBQUAD *palette, LONG paletteSize,
+					   const BYTE *pixels, DWORD size)
+{
+	width = header.biWidth;
+	topDown = header.biHeight < 0;
+	height = topDown ? -header.biHeight : header.biHeight;
+	bpp = header.biBitCount;
+	compression = header.biCompression;
+	this->palette = palette;
+	this->paletteSize = palette != NULL ? paletteSize : 0;
+	this->pixels = pixels;
+	this->size = size;
+	//every row is padded to a DWORD boundary
+	padWidth = ((width * bpp + 31) / 32) * 4;
+	row = 0;
+	rlePosition = 0;
+	rleX = 0;
+	rleRow = 0;
+	rleDone = false;
+
+	//16-bit images default to 5 bits per channel, 32-bit ones to BGRA bytes
+	DWORD defaults16[4] = { 0x7c00, 0x03e0, 0x001f, 0 };
+	DWORD defaults32[4] = { 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000 };
+	const DWORD *channelMasks = bpp == 16 ? defaults16 : defaults32;
+
+	if(masks != NULL && (compression == COMPRESSION_BITFIELDS || compression == COMPRESSION_ALPHABITFIELDS))
+	{
+		channelMasks = masks;
+	}
+
+	for(int i = 0; i < 4; i++)
+	{
+		setChannel(i, channelMasks[i]);
+	}
+
+	bool rle = compression == COMPRESSION_RLE8 || compression == COMPRESSION_RLE4;
+	valid = false;
+
+	if(width <= 0 || height <= 0)
+	{
+		printf("Error: the bitmap has no pixels.\n");
+	}
+	else if(bpp != 1 && bpp != 4 && bpp != 8 && bpp != 16 && bpp != 24 && bpp != 32)
+	{
+		printf("Error: bitmaps with %d bits per pixel are not supported.\n", bpp);
+	}
+	else if(!(compression == COMPRESSION_RGB ||
+			  (compression == COMPRESSION_RLE8 && bpp == 8) ||
+			  (compression == COMPRESSION_RLE4 && bpp == 4) ||
+			  ((compression == COMPRESSION_BITFIELDS || compression == COMPRESSION_ALPHABITFIELDS) &&
+			   (bpp == 16 || bpp == 32))))
+	{
+		printf("Error: compression %d is not supported for %d-bit bitmaps.\n", compression, bpp);
+	}
+	else if(rle && topDown)
+	{
+		printf("Error: compressed bitmaps cannot be stored top-down.\n");
+	}
+	else if(bpp <= 8 && this->paletteSize <= 0)
+	{
+		printf("Error: the bitmap is missing its colour table.\n");
+	}
+	//some programs pad not only the rows but also the file size, so the data
+	//may be larger than needed, but never smaller
+	else if(!rle && (unsigned long long)padWidth * height > size)
+	{
+		printf("Error: the bitmap is missing pixel data.\n");
+	}
+	else
+	{
+		valid = true;
+	}
+}
+
+bool BMPDecoder::isValid() const
+{
+	return valid;
+}
+
+LONG BMPDecoder::getWidth() const
+{
+	return width;
+}
+
+LONG BMPDecoder::getHeight() const
+{
+	return height;
+}
+
+bool BMPDecoder::isTopDown() const
+{
+	return topDown;
+}
+
+LONG BMPDecoder::decodeRows(BYTE *destination, LONG destinationStride, LONG rowCount)
+{
+	if(!valid)
+	{
+		return 0;
+	}
+
+	LONG count = rowCount < height - row ? rowCount : height - row;
+
+	for(LONG i = 0; i < count; i++)
+	{
+		BYTE *target = destination + i * destinationStride;
+
+		if(compression == COMPRESSION_RLE8 || compression == COMPRESSION_RLE4)
+		{
+			decodeRLERow(target);
+		}
+		else
+		{
+			decodeRow(target, pixels + (DWORD)(row * padWidth));
+		}
+
+		row++;
+	}
+
+	return count;
+}
+
+void BMPDecoder::decodeRow(BYTE *destination, const BYTE *source) const
+{
+	switch(bpp)
+	{
+	case 1:
+	case 4:
+	case 8:
+	{
+		int pixelsPerByte = 8 / bpp;
+		BYTE indexMask = (1 << bpp) - 1;
+
+		for(LONG x = 0; x < width; x++)
+		{
+			//the leftmost pixel is in the most significant bits
+			int shift = (pixelsPerByte - 1 - x % pixelsPerByte) * bpp;
+			setPaletteColor(destination + x * 4, (source[x / pixelsPerByte] >> shift) & indexMask);
+		}
+		break;
+	}
+	case 24:
+		for(LONG x = 0; x < width; x++)
+		{
+			destination[x * 4]     = source[x * 3 + 2];
+			destination[x * 4 + 1] = source[x * 3 + 1];
+			destination[x * 4 + 2] = source[x * 3];
+			destination[x * 4 + 3] = 255;
+		}
+		break;
+	case 32:
+		if(compression == COMPRESSION_RGB)
+		{
+			//the common case, the byte order is fixed so a shuffle does the job
+			PixelConvert::bgraToRgbaRow(destination, source, width);
+			break;
+		}
+		//fall through, the masks say where the channels are
+	case 16:
+		for(LONG x = 0; x < width; x++)
+		{
+			DWORD value = bpp == 16 ? source[x * 2] | source[x * 2 + 1] << 8 :
+						  source[x * 4] | source[x * 4 + 1] << 8 | source[x * 4 + 2] << 16 |
+						  (DWORD)source[x * 4 + 3] << 24;
+
+			for(int c = 0; c < 4; c++)
+			{
+				destination[x * 4 + c] = expand(value, c);
+			}
+		}
+		break;
+	}
+}
+
+void BMPDecoder::decodeRLERow(BYTE *destination)
+{
+	//pixels the encoder skipped over stay transparent
+	memset(destination, 0, width * 4);
+
+	//a delta may have jumped past this row already
+	if(rleDone || rleRow > row)
+	{
+		return;
+	}
+
+	bool rle4 = compression == COMPRESSION_RLE4;
+
+	while(rlePosition + 2 <= size)
+	{
+		BYTE count = pixels[rlePosition];
+		BYTE value = pixels[rlePosition + 1];
+		rlePosition += 2;
+
+		if(count > 0)
+		{
+			//encoded run, RLE4 alternates between the two nibbles of value
+			for(int i = 0; i < count && rleX < width; i++, rleX++)
+			{
+				BYTE index = rle4 ? (i % 2 == 0 ? value >> 4 : value & 0x0f) : value;
+				setPaletteColor(destination + rleX * 4, index);
+			}
+		}
+		else if(value == RLE_END_OF_LINE)
+		{
+			rleRow++;
+			rleX = 0;
+			return;
+		}
+		else if(value == RLE_END_OF_BITMAP)
+		{
+			rleDone = true;
+			return;
+		}
+		else if(value == RLE_DELTA)
+		{
+			if(rlePosition + 2 > size)
+			{
+				break;
+			}
+
+			rleX += pixels[rlePosition];
+			rleRow += pixels[rlePosition + 1];
+			rlePosition += 2;
+
+			if(rleRow > row)
+			{
+				return;
+			}
+		}
+		else
+		{
+			//absolute run of value indices, padded to a WORD boundary
+			DWORD bytes = rle4 ? (value + 1) / 2 : value;
+
+			if(rlePosition + bytes > size)
+			{
+				break;
+			}
+
+			for(int i = 0; i < value && rleX < width; i++, rleX++)
+			{
+				BYTE data = pixels[rlePosition + (rle4 ? i / 2 : i)];
+				BYTE index = rle4 ? (i % 2 == 0 ? data >> 4 : data & 0x0f) : data;
+				setPaletteColor(destination + rleX * 4, index);
+			}
+
+			rlePosition += (bytes + 1) & ~1u;
+		}
+	}
+
+	//the data ended without an end of bitmap code
+	rleDone = true;
+}
+
+void BMPDecoder::setChannel(int index, DWORD mask)
+{
+	Channel &channel = channels[index];
+
+	channel.mask = mask;
+	channel.shift = mask != 0 ? __builtin_ctz(mask) : 0;
+	channel.bits = __builtin_popcount(mask);
+}
+
+void BMPDecoder::setPaletteColor(BYTE *destination, LONG index) const
+{
+	//indices past the end of the colour table show up black
+	if(index >= paletteSize)
+	{
+		destination[0] = destination[1] = destination[2] = 0;
+	}
+	else
+	{
+		destination[0] = palette[index].rgbRed;
+		destination[1] = palette[index].rgbGreen;
+		destination[2] = palette[index].rgbBlue;
+	}
+
+	//the reserved byte of palette entries is not alpha, most writers leave it 0
+	destination[3] = 255;
+}
+
+BYTE BMPDecoder::expand(DWORD value, int channel) const
+{
+	const Channel &c = channels[channel];
+
+	if(c.bits == 0)
+	{
+		//no alpha mask means the image is opaque
+		return channel == 3 ? 255 : 0;
+	}
+
+	DWORD bits = (value & c.mask) >> c.shift;
+
+	if(c.bits >= 8)
+	{
+		return bits >> (c.bits - 8);
+	}
+
+	//scale so the largest value becomes 255, e.g. 31 in a 5-bit channel
+	DWORD maximum = (1u << c.bits) - 1;
+	return (bits * 255 + maximum / 2) / maximum;
+}
@@ -0,0 +1,124 @@
+/*
+ * BMPDecoder.h
+ *
+ * Expands the pixels of a bitmap into 32-bit RGBA rows, a few rows at a time,
+ * so the caller can write them straight into their final place. Handles
+ * 1, 4 and 8-bit palettized images, RLE4 and RLE8 compression, 16 and 32-bit
+ * bitfields and plain 24 and 32-bit images.
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifndef BMPDECODER_H_
+#define BMPDECODER_H_
+
+#include "ImageLoader.h"
+
+class BMPDecoder
+{
+public:
+	//values of biCompression
+	enum Compression
+	{
+		COMPRESSION_RGB = 0,
+		COMPRESSION_RLE8 = 1,
+		COMPRESSION_RLE4 = 2,
+		COMPRESSION_BITFIELDS = 3,
+		COMPRESSION_ALPHABITFIELDS = 6
+	};
+
+	/**
+	 * @param header The info header of the bitmap.
+	 * @param masks Red, green, blue and alpha masks for bitfield images, NULL
+	 *        for the defaults. An alpha mask of 0 makes the image opaque.
+	 * @param palette The colour table of palettized images, may be NULL.
+	 * @param paletteSize Number of entries in the palette.
+	 * @param pixels The pixel data of the file.
+	 * @param size Bytes of pixel data available.
+	 */
+	BMPDecoder(const BITMAPINFOHEADER &header, const DWORD *masks,
+			   const RGBQUAD *palette, LONG paletteSize,
+			   const BYTE *pixels, DWORD size);
+
+	/**
+	 * @return False if the format is not supported or the pixel data is too
+	 *         short, after printing the reason.
+	 */
+	bool isValid() const;
+
+	LONG getWidth() const;
+
+	/**
+	 * @return The number of rows, always positive.
+	 */
+	LONG getHeight() const;
+
+	/**
+	 * @return True if the rows are stored top row first.
+	 */
+	bool isTopDown() const;
+
+	/**
+	 * Decodes the next rows in the order they are stored in the file.
+	 * Pixels an RLE image skips over are left transparent.
+	 * @param destination Receives the first row as width RGBA pixels.
+	 * @param destinationStride Bytes from one destination row to the next, may
+	 *        be negative to write the rows upwards.
+	 * @param rowCount The most rows to decode.
+	 * @return The number of rows decoded, 0 when the image is done.
+	 */
+	LONG decodeRows(BYTE *destination, LONG destinationStride, LONG rowCount);
+
+private:
+	struct Channel
+	{
+		DWORD mask;
+		int shift;
+		int bits;
+	};
+
+	LONG width;
+	LONG height;
+	bool topDown;
+	WORD bpp;
+	DWORD compression;
+	const RGBQUAD *palette;
+	LONG paletteSize;
+	const BYTE *pixels;
+	DWORD size;
+	LONG padWidth;
+	bool valid;
+	Channel channels[4];
+
+	//rows handed out so far
+	LONG row;
+	//where RLE decoding continues: read position and the pixel it writes next
+	DWORD rlePosition;
+	LONG rleX;
+	LONG rleRow;
+	bool rleDone;
+
+	void decodeRow(BYTE *destination, const BYTE *source) const;
+	void decodeRLERow(BYTE *destination);
+	void setChannel(int index, DWORD mask);
+	void setPaletteColor(BYTE *destination, LONG index) const;
+	BYTE expand(DWORD value, int channel) const;
+};
+
+#endif /* BMPDECODER_H_ */
@@ -0,0 +1,256 @@
+/*
+ * ClockWall.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include "ClockWall.h"
+#include "Sprite.h"
+#include "ImageLoader.h"
+#include "RotationTable.h"
+
+#define SECONDS_PER_DAY (24 * 60 * 60)
+// space left between neighbouring clocks, as a fraction of a cell
+#define CELL_MARGIN 0.05f
+
+ClockWall::ClockWall(const Sprite *face, const Sprite *hoursHand,
+					 const Sprite *minutesHand, const Sprite *secondsHand)
+{
+	templates[0] = face;
+	templates[1] = hoursHand;
+	templates[2] = minutesHand;
+	templates[3] = secondsHand;
+	sweep = false;
+}
+
+ClockWall::~ClockWall()
+{
+	deleteSprites();
+}
+
+void ClockWall::deleteSprites()
+{
+	for(size_t i = 0; i < faces.size(); i++)
+	{
+		delete faces[i];
+	}
+
+	for(size_t i = 0; i < hands.size(); i++)
+	{
+		delete hands[i];
+	}
+
+	faces.clear();
+	hands.clear();
+}
+
+bool ClockWall::readZones(const char *fileName, vector<string> &zones)
+{
+	ifstream in(fileName);
+
+	if(!in)
+	{
+		printf("Error: cannot read the timezones in %s\n", fileName);
+		return false;
+	}
+
+	string line;
+
+	while(getline(in, line))
+	{
+		size_t start = line.find_first_not_of(" \t\r");
+		size_t end = line.find_last_not_of(" \t\r");
+
+		if(start == string::npos || line[start] == '#')
+		{
+			continue;
+		}
+
+		zones.push_back(line.substr(start, end - start + 1));
+	}
+
+	return true;
+}
+
+void ClockWall::setZones(const vector<string> &zones)
+{
+	map<string, size_t> indices;
+
+	deleteSprites();
+	clockZones.clear();
+	this->zones.clear();
+
+	for(size_t i = 0; i < zones.size(); i++)
+	{
+		map<string, size_t>::iterator found = indices.find(zones[i]);
+
+		if(found == indices.end())
+		{
+			found = indices.insert(make_pair(zones[i], this->zones.size())).first;
+			this->zones.push_back(TimeZone::get(zones[i]));
+		}
+
+		clockZones.push_back(found->second);
+		faces.push_back(new Sprite(*templates[0]));
+
+		for(int hand = 1; hand < 4; hand++)
+		{
+			hands.push_back(new Sprite(*templates[hand]));
+		}
+	}
+
+	// an empty span, the offsets are looked up on the next update
+	TimeZone::Span unknown = { 0, 0, 0 };
+	zoneSpans.assign(this->zones.size(), unknown);
+}
+
+void ClockWall::layout(int width, int height)
+{
+	size_t count = faces.size();
+
+	if(count == 0 || width <= 0 || height <= 0)
+	{
+		return;
+	}
+
+	// try every number of columns and keep the one with the largest cells
+	size_t columns = 1;
+	GLfloat cell = 0;
+
+	for(size_t tryColumns = 1; tryColumns <= count; tryColumns++)
+	{
+		size_t tryRows = (count + tryColumns - 1) / tryColumns;
+		GLfloat tryCell = min((GLfloat)width / tryColumns, (GLfloat)height / tryRows);
+
+		if(tryCell > cell)
+		{
+			cell = tryCell;
+			columns = tryColumns;
+		}
+	}
+
+	size_t rows = (count + columns - 1) / columns;
+	const ImageLoader *image = templates[0]->getImage();
+	GLfloat faceSize = max(image->getWidth(), image->getHeight());
+	GLfloat scale = cell * (1 - CELL_MARGIN) / faceSize;
+
+	// the grid is centred on (0, 0), filled row by row from the top left
+	GLfloat left = -(columns * cell) / 2;
+	GLfloat top = rows * cell / 2;
+
+	for(size_t i = 0; i < count; i++)
+	{
+		GLfloat x = left + (i % columns + 0.5f) * cell;
+		GLfloat y = top - (i / columns + 0.5f) * cell;
+		Sprite *sprites[] = { faces[i], hands[i * 3], hands[i * 3 + 1], hands[i * 3 + 2] };
+
+		for(int j = 0; j < 4; j++)
+		{
+			sprites[j]->setX(x);
+			sprites[j]->setY(y);
+			sprites[j]->setScale(scale, scale);
+		}
+	}
+}
+
+void ClockWall::setSweep(bool sweep)
+{
+	this->sweep = sweep;
+}
+
+void ClockWall::update(time_t unixTime)
+{
+	struct timespec time = { unixTime, 0 };
+
+	update(time);
+}
+
+void ClockWall::update(const struct timespec &time)
+{
+	time_t unixTime = time.tv_sec;
+
+	for(size_t i = 0; i < zones.size(); i++)
+	{
+		if(unixTime < zoneSpans[i].from || unixTime >= zoneSpans[i].until)
+		{
+			zoneSpans[i] = zones[i]->getSpan(unixTime);
+		}
+	}
+
+	for(size_t i = 0; i < clockZones.size(); i++)
+	{
+		long seconds = (unixTime + zoneSpans[clockZones[i]].offset) % SECONDS_PER_DAY;
+		const Rotation *rotations[3];
+
+		if(seconds < 0)
+		{
+			seconds += SECONDS_PER_DAY;
+		}
+
+		if(sweep)
+		{
+			getRotations(seconds + time.tv_nsec / 1e9, rotations);
+		}
+		else
+		{
+			getRotations(seconds / 3600, seconds / 60 % 60, seconds % 60, rotations);
+		}
+
+		hands[i * 3]->setRotation(*rotations[0]);
+		hands[i * 3 + 1]->setRotation(*rotations[1]);
+		hands[i * 3 + 2]->setRotation(*rotations[2]);
+	}
+}
+
+const vector<Sprite *> &ClockWall::getFaces() const
+{
+	return faces;
+}
+
+const vector<Sprite *> &ClockWall::getHands() const
+{
+	return hands;
+}
+
+size_t ClockWall::getClockCount() const
+{
+	return faces.size();
+}
+
+void ClockWall::getRotations(int hour, int minute, int second, const Rotation *rotations[3])
+{
+	// the hour hand used to turn 30 degrees an hour plus 7.5 degrees every
+	// quarter hour, which is 900 of its 43200 positions
+	rotations[0] = &hourRotations[hour % 12 * 3600 + minute / 15 * 900];
+	rotations[1] = &minuteRotations[minute * 12];
+	rotations[2] = &secondRotations[second];
+}
+
+void ClockWall::getRotations(double secondsOfDay, const Rotation *rotations[3])
+{
+	// the finest table serves all three hands
+	rotations[0] = &hourRotations.nearest(fmod(secondsOfDay, 12 * 3600) / (12 * 3600));
+	rotations[1] = &hourRotations.nearest(fmod(secondsOfDay, 3600) / 3600);
+	rotations[2] = &hourRotations.nearest(fmod(secondsOfDay, 60) / 60);
+}
@@ -0,0 +1,140 @@
+/*
+ * ClockWall.h
+ *
+ * A grid of clocks, one per timezone, e.g. one for every datacenter on an ops
+ * dashboard. Every clock is made of copies of the four sprites of a single
+ * clock, so they all share the same textures (and atlas) and the whole wall
+ * is drawn by one SpriteBatch with a single draw call. The faces never move
+ * and can go into a LayerCache, the hands are redrawn every tick.
+ *
+ * The UTC offset of every zone is kept until the zone's next transition (see
+ * TimeZone); every tick the rotations of all hands are looked up in one pass
+ * from the UTC time and those offsets.
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifndef CLOCKWALL_H_
+#define CLOCKWALL_H_
+
+#include <GL/glut.h>
+#include <string>
+#include <vector>
+#include <time.h>
+#include "TimeZone.h"
+
+using namespace std;
+
+class Sprite;
+struct Rotation;
+
+class ClockWall
+{
+public:
+	/**
+	 * @param face, hours, minutes, seconds The sprites of a single clock with
+	 *        their pivots set up and placed at (0, 0), copied for every clock.
+	 */
+	ClockWall(const Sprite *face, const Sprite *hoursHand,
+			  const Sprite *minutesHand, const Sprite *secondsHand);
+
+	/**
+	 * Deletes the sprites of all clocks.
+	 */
+	virtual ~ClockWall();
+
+	/**
+	 * Reads timezone names, one per line. Empty lines and lines starting with
+	 * # are skipped.
+	 * @return False if the file cannot be read.
+	 */
+	static bool readZones(const char *fileName, vector<string> &zones);
+
+	/**
+	 * Sets the clocks on the wall, one per zone in the given order. Names are
+	 * the ones TimeZone::get() takes, e.g. "Europe/Paris". A zone may appear
+	 * several times.
+	 */
+	void setZones(const vector<string> &zones);
+
+	/**
+	 * Arranges the clocks in the grid with the largest cells that fits into a
+	 * frame buffer of the given size, centred like reshape() centres the world
+	 * coordinates.
+	 */
+	void layout(int width, int height);
+
+	/**
+	 * Points the hands of every clock at the given time.
+	 */
+	void update(time_t unixTime);
+
+	/**
+	 * Points the hands at the given time, sweeping through the fraction of the
+	 * second if setSweep() was called.
+	 */
+	void update(const struct timespec &time);
+
+	/**
+	 * Makes the hands sweep smoothly like a mechanical watch instead of
+	 * ticking once a second.
+	 */
+	void setSweep(bool sweep);
+
+	/**
+	 * @return The faces of all clocks. Clocks never overlap, so the faces can
+	 *         be drawn before all of the hands.
+	 */
+	const vector<Sprite *> &getFaces() const;
+
+	/**
+	 * @return The hours, minutes and seconds hands of every clock in turn.
+	 */
+	const vector<Sprite *> &getHands() const;
+
+	size_t getClockCount() const;
+
+	/**
+	 * Looks up the rotations of the hands for a time of day, the way the
+	 * single clock always has turned them: the hour hand moves in steps of
+	 * 7.5 degrees and the minute hand once a minute.
+	 * @param rotations Receives the hours, minutes and seconds rotations.
+	 */
+	static void getRotations(int hour, int minute, int second, const Rotation *rotations[3]);
+
+	/**
+	 * Looks up the rotations of hands that sweep smoothly instead of ticking,
+	 * to the nearest 1/120 of a degree.
+	 * @param secondsOfDay Seconds since midnight, with a fraction.
+	 */
+	static void getRotations(double secondsOfDay, const Rotation *rotations[3]);
+
+private:
+	const Sprite *templates[4];
+	vector<Sprite *> faces;
+	vector<Sprite *> hands;
+	vector<size_t> clockZones; // index into zones for every clock
+	vector<const TimeZone *> zones;
+	vector<TimeZone::Span> zoneSpans; // the offset of every zone and until when
+	bool sweep;
+
+	void deleteSprites();
+};
+
+#endif /* CLOCKWALL_H_ */
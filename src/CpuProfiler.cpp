@@ -0,0 +1,88 @@
+/*
+ * CpuProfiler.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <time.h>
+#include <thread>
+#include "CpuProfiler.h"
+
+using namespace std;
+
+static double now()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+// statics are initialized before main() runs, on the main thread
+static const thread::id mainThread = this_thread::get_id();
+
+CpuProfiler::Frame CpuProfiler::current;
+bool CpuProfiler::inFrame = false;
+double CpuProfiler::totalSeconds[SECTION_COUNT];
+unsigned long CpuProfiler::totalCalls[SECTION_COUNT];
+
+// the Scopes of threads other than the main one, until takeThreadTimes()
+static thread_local CpuProfiler::Times threadTimes;
+
+CpuProfiler::Scope::Scope(Section section)
+{
+	this->section = section;
+	start = now();
+}
+
+CpuProfiler::Scope::~Scope()
+{
+	double seconds = now() - start;
+
+	// the totals and the frame belong to the main thread
+	if(this_thread::get_id() != mainThread)
+	{
+		threadTimes.seconds[section] += seconds;
+		threadTimes.calls[section]++;
+		return;
+	}
+
+	totalSeconds[section] += seconds;
+	totalCalls[section]++;
+
+	if(inFrame)
+	{
+		current.cpuSeconds[section] += seconds;
+		current.calls[section]++;
+	}
+}
+
+void CpuProfiler::takeThreadTimes(Times &times)
+{
+	times = threadTimes;
+	threadTimes = Times();
+}
+
+void CpuProfiler::addThreadTimes(const Times &times)
+{
+	for(int i = 0; i < SECTION_COUNT; i++)
+	{
+		totalSeconds[i] += times.seconds[i];
+		totalCalls[i] += times.calls[i];
+	}
+}
@@ -0,0 +1,104 @@
+/*
+ * CpuProfiler.h
+ *
+ * The part of the Profiler that needs no OpenGL: the sections timed on the
+ * CPU with a Scope and the record of the current frame they add to. Code
+ * that is also built without GL, e.g. ImageLoader for the asset compiler,
+ * times itself with a CpuProfiler::Scope; everything else uses the Profiler,
+ * which adds the GPU times and the frame records.
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifndef CPUPROFILER_H_
+#define CPUPROFILER_H_
+
+class CpuProfiler
+{
+public:
+	enum Section
+	{
+		DISPLAY,
+		// SpriteBatch::draw(), the sprites of a frame
+		BATCH_DRAW,
+		// LayerCache::draw(), the cached layer copied under them
+		LAYER_DRAW,
+		INIT_SCENE,
+		LOAD_BMP,
+		SECTION_COUNT
+	};
+
+	/**
+	 * Times a section from its construction to the end of the enclosing block.
+	 * Sections may nest, each is charged its full time. On threads other than
+	 * the main one the time is kept aside for takeThreadTimes().
+	 */
+	class Scope
+	{
+	public:
+		Scope(Section section);
+		~Scope();
+
+	private:
+		Section section;
+		double start;
+	};
+
+	// the sections timed on a thread other than the main one
+	struct Times
+	{
+		double seconds[SECTION_COUNT];
+		unsigned int calls[SECTION_COUNT];
+	};
+
+	struct Frame
+	{
+		double cpuSeconds[SECTION_COUNT];
+		unsigned int calls[SECTION_COUNT];
+		// -1 until the query result arrives, or if there are no timer queries
+		double gpuSeconds;
+		unsigned long bytesUploaded;
+		unsigned int drawCalls;
+		// texture, buffer and frame buffer binds, blend functions and scissor
+		// rectangles set
+		unsigned int stateChanges;
+	};
+
+	/**
+	 * Hands out the times kept aside on the calling thread since the last call
+	 * and clears them, e.g. at the end of a worker's job.
+	 */
+	static void takeThreadTimes(Times &times);
+
+	/**
+	 * Adds times taken from another thread to the totals. Only the main thread
+	 * may call this. They are not charged to the current frame, which they did
+	 * not hold up.
+	 */
+	static void addThreadTimes(const Times &times);
+
+protected:
+	// the frame between Profiler::beginFrame() and endFrame()
+	static Frame current;
+	static bool inFrame;
+	static double totalSeconds[SECTION_COUNT];
+	static unsigned long totalCalls[SECTION_COUNT];
+};
+
+#endif /* CPUPROFILER_H_ */
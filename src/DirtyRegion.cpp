@@ -0,0 +1,198 @@
+/*
+ * DirtyRegion.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "DirtyRegion.h"
+
+// beyond this many rectangles, e.g. when every clock of a wall has moved,
+// they are merged into their bounding box
+#define MAX_RECTS 32
+
+static inline long area(const DirtyRegion::Rect &rect)
+{
+	return (long)rect.width * rect.height;
+}
+
+DirtyRegion::DirtyRegion()
+{
+	width = 0;
+	height = 0;
+}
+
+DirtyRegion::~DirtyRegion()
+{
+}
+
+void DirtyRegion::setSize(int width, int height)
+{
+	this->width = width;
+	this->height = height;
+	clear();
+}
+
+void DirtyRegion::clear()
+{
+	rects.clear();
+}
+
+void DirtyRegion::addAll()
+{
+	Rect rect = { 0, 0, width, height };
+
+	rects.clear();
+
+	if(width > 0 && height > 0)
+	{
+		rects.push_back(rect);
+	}
+}
+
+void DirtyRegion::add(const Sprite::Bounds &bounds)
+{
+	if(bounds.left > bounds.right || bounds.bottom > bounds.top || width <= 0 || height <= 0)
+	{
+		return;
+	}
+
+	// world coordinates of the frame buffer, matching glOrtho in reshape()
+	float worldLeft = -(width / 2);
+	float worldBottom = -(height / 2);
+	float pixelsPerUnitX = (float)width / (width / 2 - -(width / 2));
+	float pixelsPerUnitY = (float)height / (height / 2 - -(height / 2));
+
+	int left = max(0, (int)floor((bounds.left - worldLeft) * pixelsPerUnitX) - 1);
+	int right = min(width, (int)ceil((bounds.right - worldLeft) * pixelsPerUnitX) + 1);
+	int bottom = max(0, (int)floor((bounds.bottom - worldBottom) * pixelsPerUnitY) - 1);
+	int top = min(height, (int)ceil((bounds.top - worldBottom) * pixelsPerUnitY) + 1);
+
+	if(left >= right || bottom >= top)
+	{
+		return;
+	}
+
+	Rect rect = { left, bottom, right - left, top - bottom };
+	add(rect);
+}
+
+void DirtyRegion::add(const Sprite &sprite)
+{
+	if(!sprite.isDirty())
+	{
+		return;
+	}
+
+	Sprite::Bounds previous;
+	Sprite::Bounds current;
+
+	sprite.getDirtyBounds(previous, current);
+
+	add(previous);
+	add(current);
+}
+
+void DirtyRegion::add(Rect rect)
+{
+	// keep it inside the frame buffer
+	int right = min(width, rect.x + rect.width);
+	int top = min(height, rect.y + rect.height);
+
+	rect.x = max(0, rect.x);
+	rect.y = max(0, rect.y);
+	rect.width = right - rect.x;
+	rect.height = top - rect.y;
+
+	if(rect.width <= 0 || rect.height <= 0)
+	{
+		return;
+	}
+
+	// swallow every rectangle whose union with the new one has no more pixels
+	// than the two of them, until none is left. Overlapping rectangles that are
+	// not worth merging are simply redrawn twice.
+	bool merged = true;
+
+	while(merged)
+	{
+		merged = false;
+
+		for(size_t i = 0; i < rects.size(); i++)
+		{
+			const Rect &other = rects[i];
+			int left = min(rect.x, other.x);
+			int bottom = min(rect.y, other.y);
+			int right = max(rect.x + rect.width, other.x + other.width);
+			int top = max(rect.y + rect.height, other.y + other.height);
+			Rect combined = { left, bottom, right - left, top - bottom };
+
+			if(area(combined) <= area(rect) + area(other))
+			{
+				rect = combined;
+				rects.erase(rects.begin() + i);
+				merged = true;
+				break;
+			}
+		}
+	}
+
+	rects.push_back(rect);
+
+	if(rects.size() > MAX_RECTS)
+	{
+		Rect bounds = rects[0];
+
+		for(size_t i = 1; i < rects.size(); i++)
+		{
+			int right = max(bounds.x + bounds.width, rects[i].x + rects[i].width);
+			int top = max(bounds.y + bounds.height, rects[i].y + rects[i].height);
+
+			bounds.x = min(bounds.x, rects[i].x);
+			bounds.y = min(bounds.y, rects[i].y);
+			bounds.width = right - bounds.x;
+			bounds.height = top - bounds.y;
+		}
+
+		rects.assign(1, bounds);
+	}
+}
+
+bool DirtyRegion::isEmpty() const
+{
+	return rects.empty();
+}
+
+const vector<DirtyRegion::Rect> &DirtyRegion::getRects() const
+{
+	return rects;
+}
+
+long DirtyRegion::getPixelCount() const
+{
+	long count = 0;
+
+	for(size_t i = 0; i < rects.size(); i++)
+	{
+		count += area(rects[i]);
+	}
+
+	return count;
+}
@@ -0,0 +1,108 @@
+/*
+ * DirtyRegion.h
+ *
+ * The parts of the frame buffer that have to be redrawn for the next frame.
+ * Once a second only the hands move, so instead of clearing and compositing
+ * the whole clock the renderers only redraw the rectangles the hands covered
+ * before and after they turned: through glScissor with OpenGL and through a
+ * clip rectangle with the SoftwareRenderer.
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifndef DIRTYREGION_H_
+#define DIRTYREGION_H_
+
+#include <vector>
+#include "Sprite.h"
+
+using namespace std;
+
+class DirtyRegion
+{
+public:
+	/**
+	 * A rectangle of pixels with (0, 0) at the bottom left corner of the frame
+	 * buffer, the way glScissor takes it.
+	 */
+	struct Rect
+	{
+		int x;
+		int y;
+		int width;
+		int height;
+	};
+
+	DirtyRegion();
+	virtual ~DirtyRegion();
+
+	/**
+	 * Sets the size of the frame buffer, with world coordinates mapped to it
+	 * like reshape() in main.cpp does. Clears the region.
+	 */
+	void setSize(int width, int height);
+
+	/**
+	 * Forgets all rectangles, e.g. after they have been redrawn.
+	 */
+	void clear();
+
+	/**
+	 * Marks the whole frame buffer, e.g. when its contents were lost.
+	 */
+	void addAll();
+
+	/**
+	 * Marks the pixels touched by a rectangle in world coordinates, plus one
+	 * pixel around it for the edges of filtered sprites.
+	 */
+	void add(const Sprite::Bounds &bounds);
+
+	/**
+	 * Marks where the sprite was and where it is now if it is dirty.
+	 */
+	void add(const Sprite &sprite);
+
+	/**
+	 * Marks a rectangle of pixels, e.g. text drawn over the sprites.
+	 */
+	void add(Rect rect);
+
+	bool isEmpty() const;
+
+	/**
+	 * @return The rectangles to redraw. Rectangles close to each other are
+	 *         merged when redrawing both would cost more than their union,
+	 *         and when there are too many they become their bounding box.
+	 */
+	const vector<Rect> &getRects() const;
+
+	/**
+	 * @return The number of pixels in all the rectangles, i.e. the pixels that
+	 *         are cleared and composited again to redraw the region.
+	 */
+	long getPixelCount() const;
+
+private:
+	int width;
+	int height;
+	vector<Rect> rects;
+};
+
+#endif /* DIRTYREGION_H_ */
@@ -0,0 +1,110 @@
+/*
+ * FileWatcher.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include "FileWatcher.h"
+
+FileWatcher::FileWatcher()
+{
+	fd = -1;
+	watchDescriptor = -1;
+}
+
+FileWatcher::~FileWatcher()
+{
+	if(fd >= 0)
+	{
+		close(fd);
+	}
+}
+
+bool FileWatcher::watch(const string &directory)
+{
+	if(fd < 0)
+	{
+		fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+		if(fd < 0)
+		{
+			perror("Error");
+			return false;
+		}
+	}
+
+	watchDescriptor = inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+
+	if(watchDescriptor < 0)
+	{
+		perror("Error");
+		return false;
+	}
+
+	this->directory = directory;
+
+	return true;
+}
+
+bool FileWatcher::poll(vector<string> &changed)
+{
+	// room for many events, each is followed by its name
+	char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+
+	changed.clear();
+
+	if(fd < 0)
+	{
+		return false;
+	}
+
+	for(;;)
+	{
+		ssize_t length = read(fd, buffer, sizeof(buffer));
+
+		// EAGAIN once all events were read
+		if(length <= 0)
+		{
+			break;
+		}
+
+		for(char *next = buffer; next < buffer + length; )
+		{
+			const struct inotify_event *event = (const struct inotify_event *)next;
+
+			if(event->wd == watchDescriptor && event->len > 0)
+			{
+				string path = directory + "/" + event->name;
+
+				if(find(changed.begin(), changed.end(), path) == changed.end())
+				{
+					changed.push_back(path);
+				}
+			}
+
+			next += sizeof(struct inotify_event) + event->len;
+		}
+	}
+
+	return !changed.empty();
+}
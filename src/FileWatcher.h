@@ -0,0 +1,60 @@
+/*
+ * FileWatcher.h
+ *
+ * Reports files of a directory that were written or replaced, using inotify.
+ * Polling never blocks, so it can be done from the drawing loop.
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifndef FILEWATCHER_H_
+#define FILEWATCHER_H_
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class FileWatcher
+{
+public:
+	FileWatcher();
+	virtual ~FileWatcher();
+
+	/**
+	 * Starts watching a directory, without its subdirectories.
+	 * @return False if it cannot be watched.
+	 */
+	bool watch(const string &directory);
+
+	/**
+	 * Collects the files written (and closed) or moved into the directory
+	 * since the last call, each once, as directory + "/" + name. Editors that
+	 * save through a temporary file and rename it are caught as well.
+	 * @return False if nothing changed.
+	 */
+	bool poll(vector<string> &changed);
+
+private:
+	int fd;
+	int watchDescriptor;
+	string directory;
+};
+
+#endif /* FILEWATCHER_H_ */
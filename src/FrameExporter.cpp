@@ -0,0 +1,316 @@
+/*
+ * FrameExporter.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <time.h>
+#include <unistd.h>
+#include "FrameExporter.h"
+#include "PixelConvert.h"
+
+// starts every frame of a Y4M stream
+#define Y4M_FRAME "FRAME\n"
+// queued by the converter after the last frame
+#define END_OF_FRAMES -1
+
+static double now()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+FrameExporter::FrameExporter(int width, int height, Format format, int fps)
+{
+	this->width = width;
+	this->height = height;
+	this->format = format;
+	this->fps = fps;
+	file = NULL;
+	stopping = false;
+	failed = false;
+	framesWritten = 0;
+	convertSeconds = 0;
+	writeSeconds = 0;
+
+	size_t pixelCount = (size_t)width * height;
+	size_t chromaCount = (size_t)((width + 1) / 2) * ((height + 1) / 2);
+	size_t frameSize = format == Y4M ? strlen(Y4M_FRAME) + pixelCount + 2 * chromaCount : pixelCount * 4;
+
+	for(int i = 0; i < EXPORT_BUFFERS; i++)
+	{
+		frames[i].pixels.resize(pixelCount * 4);
+		frames[i].output.resize(frameSize);
+
+		if(format == Y4M)
+		{
+			memcpy(&frames[i].output[0], Y4M_FRAME, strlen(Y4M_FRAME));
+		}
+
+		idle.push_back(i);
+	}
+}
+
+FrameExporter::~FrameExporter()
+{
+	finish();
+}
+
+FrameExporter::Format FrameExporter::getFormat(const string &name)
+{
+	return name == "rgba" ? RGBA : Y4M;
+}
+
+bool FrameExporter::open(const string &fileName)
+{
+	// a reader that goes away, e.g. an encoder that fails, shows up as a
+	// failed write instead of killing the program
+	signal(SIGPIPE, SIG_IGN);
+
+	if(fileName == "-")
+	{
+		// keep the real stdout for the frames and send everything else that
+		// is printed to stderr
+		cout.flush();
+		fflush(stdout);
+
+		int video = dup(STDOUT_FILENO);
+
+		if(video >= 0 && dup2(STDERR_FILENO, STDOUT_FILENO) >= 0)
+		{
+			file = fdopen(video, "wb");
+		}
+	}
+	else
+	{
+		file = fopen(fileName.c_str(), "wb");
+	}
+
+	if(file == NULL)
+	{
+		perror(fileName.c_str());
+		return false;
+	}
+
+	if(!writeHeader())
+	{
+		perror(fileName.c_str());
+		fclose(file);
+		file = NULL;
+		return false;
+	}
+
+	converter = thread(&FrameExporter::convert, this);
+	writer = thread(&FrameExporter::write, this);
+
+	return true;
+}
+
+bool FrameExporter::writeHeader()
+{
+	if(format != Y4M)
+	{
+		return true;
+	}
+
+	// C420jpeg: the chroma samples sit between the luma samples they average
+	return fprintf(file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, fps) > 0;
+}
+
+BYTE *FrameExporter::acquire()
+{
+	unique_lock<mutex> guard(lock);
+
+	while(idle.empty() && !failed)
+	{
+		changed.wait(guard);
+	}
+
+	if(failed)
+	{
+		return NULL;
+	}
+
+	int index = idle.front();
+	idle.pop_front();
+
+	return &frames[index].pixels[0];
+}
+
+void FrameExporter::submit(BYTE *pixels)
+{
+	for(int i = 0; i < EXPORT_BUFFERS; i++)
+	{
+		if(&frames[i].pixels[0] == pixels)
+		{
+			unique_lock<mutex> guard(lock);
+			rendered.push_back(i);
+			changed.notify_all();
+			return;
+		}
+	}
+}
+
+void FrameExporter::convert()
+{
+	for(;;)
+	{
+		int index;
+
+		{
+			unique_lock<mutex> guard(lock);
+
+			while(rendered.empty() && !stopping)
+			{
+				changed.wait(guard);
+			}
+
+			if(rendered.empty())
+			{
+				converted.push_back(END_OF_FRAMES);
+				changed.notify_all();
+				return;
+			}
+
+			index = rendered.front();
+			rendered.pop_front();
+		}
+
+		double start = now();
+		const BYTE *pixels = &frames[index].pixels[0];
+		BYTE *output = &frames[index].output[0];
+
+		if(format == Y4M)
+		{
+			BYTE *luma = output + strlen(Y4M_FRAME);
+			BYTE *blue = luma + width * height;
+			BYTE *red = blue + ((width + 1) / 2) * ((height + 1) / 2);
+
+			PixelConvert::rgbaToI420(luma, blue, red, pixels, width, height, true);
+		}
+		else
+		{
+			// video frames start at the top
+			for(int y = 0; y < height; y++)
+			{
+				memcpy(output + y * width * 4, pixels + (height - 1 - y) * width * 4, width * 4);
+			}
+		}
+
+		unique_lock<mutex> guard(lock);
+		convertSeconds += now() - start;
+		converted.push_back(index);
+		changed.notify_all();
+	}
+}
+
+void FrameExporter::write()
+{
+	for(;;)
+	{
+		int index;
+		bool skip;
+
+		{
+			unique_lock<mutex> guard(lock);
+
+			while(converted.empty())
+			{
+				changed.wait(guard);
+			}
+
+			index = converted.front();
+			converted.pop_front();
+			skip = failed;
+		}
+
+		if(index == END_OF_FRAMES)
+		{
+			return;
+		}
+
+		// frames after a failed write are dropped, they still have to go
+		// back to acquire() so nothing waits for them
+		double start = now();
+		const vector<BYTE> &output = frames[index].output;
+		bool written = !skip && fwrite(&output[0], 1, output.size(), file) == output.size();
+
+		unique_lock<mutex> guard(lock);
+		writeSeconds += now() - start;
+
+		if(written)
+		{
+			framesWritten++;
+		}
+		else if(!failed)
+		{
+			perror("Error: cannot write the video");
+			failed = true;
+		}
+
+		idle.push_back(index);
+		changed.notify_all();
+	}
+}
+
+bool FrameExporter::finish()
+{
+	if(file == NULL)
+	{
+		return !failed;
+	}
+
+	{
+		unique_lock<mutex> guard(lock);
+		stopping = true;
+		changed.notify_all();
+	}
+
+	converter.join();
+	writer.join();
+
+	if(fclose(file) != 0 && !failed)
+	{
+		perror("Error: cannot write the video");
+		failed = true;
+	}
+
+	file = NULL;
+
+	return !failed;
+}
+
+long FrameExporter::getFramesWritten() const
+{
+	return framesWritten;
+}
+
+double FrameExporter::getConvertSeconds() const
+{
+	return convertSeconds;
+}
+
+double FrameExporter::getWriteSeconds() const
+{
+	return writeSeconds;
+}
@@ -0,0 +1,155 @@
+/*
+ * FrameExporter.h
+ *
+ * Streams rendered frames to a file or a pipe as raw video, e.g. into
+ * ffmpeg to make a time-lapse of the clock. The frames go through three
+ * stages on their own threads: the caller renders a frame into a buffer it
+ * gets from acquire(), a converter thread turns it into the output format
+ * and a writer thread writes it out, so the three overlap and the slowest
+ * of them sets the pace instead of their sum.
+ *
+ *   FrameExporter exporter(width, height, FrameExporter::Y4M, 60);
+ *   exporter.open("-");
+ *   for every frame:
+ *       BYTE *pixels = exporter.acquire(); // NULL once writing failed
+ *       context.readPixels(pixels);
+ *       exporter.submit(pixels);
+ *   exporter.finish();
+ *
+ * A few frames are in flight at a time; acquire() waits when the writer
+ * falls behind.
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifndef FRAMEEXPORTER_H_
+#define FRAMEEXPORTER_H_
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ImageLoader.h"
+
+using namespace std;
+
+// frames in flight between rendering and writing
+#define EXPORT_BUFFERS 4
+
+class FrameExporter
+{
+public:
+	enum Format
+	{
+		// YUV4MPEG2, planar YUV 4:2:0 with a header giving the size and rate
+		Y4M,
+		// RGBA pixels, top row first, without any header
+		RGBA
+	};
+
+	FrameExporter(int width, int height, Format format, int fps);
+
+	/**
+	 * Stops the threads, writing the frames submitted so far.
+	 */
+	virtual ~FrameExporter();
+
+	/**
+	 * Opens the output and starts the threads.
+	 * @param fileName "-" for stdout. The program's own messages go to stderr
+	 *        from then on so they do not end up in the video.
+	 * @return False if the file cannot be opened.
+	 */
+	bool open(const string &fileName);
+
+	/**
+	 * Waits for a free frame.
+	 * @return A buffer for width * height RGBA pixels, bottom row first like
+	 *         glReadPixels, or NULL once the output could not be written.
+	 */
+	BYTE *acquire();
+
+	/**
+	 * Queues a frame from acquire() to be converted and written, after the
+	 * ones submitted before it.
+	 */
+	void submit(BYTE *pixels);
+
+	/**
+	 * Waits until all submitted frames are written and closes the output.
+	 * @return False if writing any of them failed.
+	 */
+	bool finish();
+
+	long getFramesWritten() const;
+
+	/**
+	 * @return Seconds the converter and the writer were busy.
+	 */
+	double getConvertSeconds() const;
+	double getWriteSeconds() const;
+
+	/**
+	 * @return Format::RGBA for "rgba", Format::Y4M for anything else.
+	 */
+	static Format getFormat(const string &name);
+
+private:
+	struct Frame
+	{
+		vector<BYTE> pixels;
+		vector<BYTE> output;
+	};
+
+	int width;
+	int height;
+	Format format;
+	int fps;
+	FILE *file;
+	Frame frames[EXPORT_BUFFERS];
+
+	mutex lock;
+	// signalled whenever a frame moves from one stage to the next
+	condition_variable changed;
+	// indices into frames in every stage, oldest first
+	deque<int> idle;
+	deque<int> rendered;
+	deque<int> converted;
+	bool stopping;
+	bool failed;
+
+	thread converter;
+	thread writer;
+	long framesWritten;
+	double convertSeconds;
+	double writeSeconds;
+
+	void convert();
+	void write();
+	bool writeHeader();
+
+	// the threads cannot be copied along with the exporter
+	FrameExporter(const FrameExporter &other);
+	FrameExporter &operator=(const FrameExporter &other);
+};
+
+#endif /* FRAMEEXPORTER_H_ */
@@ -0,0 +1,117 @@
+/*
+ * FrameTimeHistogram.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <cstdio>
+#include "FrameTimeHistogram.h"
+
+#define BUCKET_SECONDS 0.00001
+#define BUCKET_COUNT 10000
+
+FrameTimeHistogram::FrameTimeHistogram() : buckets(BUCKET_COUNT, 0)
+{
+	count = 0;
+	max = 0;
+}
+
+FrameTimeHistogram::~FrameTimeHistogram()
+{
+}
+
+void FrameTimeHistogram::add(double seconds)
+{
+	long bucket = (long)(seconds / BUCKET_SECONDS);
+
+	if(bucket < 0)
+	{
+		bucket = 0;
+	}
+	else if(bucket >= BUCKET_COUNT)
+	{
+		bucket = BUCKET_COUNT - 1;
+	}
+
+	buckets[bucket]++;
+	count++;
+
+	if(seconds > max)
+	{
+		max = seconds;
+	}
+}
+
+void FrameTimeHistogram::clear()
+{
+	buckets.assign(BUCKET_COUNT, 0);
+	count = 0;
+	max = 0;
+}
+
+unsigned long FrameTimeHistogram::getCount() const
+{
+	return count;
+}
+
+double FrameTimeHistogram::getPercentile(double fraction) const
+{
+	if(count == 0)
+	{
+		return 0;
+	}
+
+	// the frame at this rank, counting from 1
+	unsigned long rank = (unsigned long)(fraction * count + 0.5);
+	unsigned long seen = 0;
+
+	if(rank < 1)
+	{
+		rank = 1;
+	}
+
+	for(int i = 0; i < BUCKET_COUNT; i++)
+	{
+		seen += buckets[i];
+
+		if(seen >= rank)
+		{
+			// the upper edge of the bucket, but never beyond the slowest frame
+			double seconds = (i + 1) * BUCKET_SECONDS;
+			return seconds < max ? seconds : max;
+		}
+	}
+
+	return max;
+}
+
+double FrameTimeHistogram::getMax() const
+{
+	return max;
+}
+
+string FrameTimeHistogram::getSummary() const
+{
+	char summary[128];
+
+	snprintf(summary, sizeof(summary), "p50 %.2fms, p99 %.2fms, max %.2fms over %lu frames",
+			 getPercentile(0.5) * 1000, getPercentile(0.99) * 1000, max * 1000, count);
+
+	return summary;
+}
@@ -0,0 +1,72 @@
+/*
+ * FrameTimeHistogram.h
+ *
+ * Counts frame times in buckets of 10 microseconds, cheap enough to record
+ * every frame, and reports their percentiles. A single slow frame shows up
+ * in the maximum and a few of them in the 99th percentile even when the
+ * average frame rate looks fine.
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifndef FRAMETIMEHISTOGRAM_H_
+#define FRAMETIMEHISTOGRAM_H_
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class FrameTimeHistogram
+{
+public:
+	FrameTimeHistogram();
+	virtual ~FrameTimeHistogram();
+
+	/**
+	 * Counts one frame. Times beyond the last bucket (100ms) go into the last
+	 * bucket but still count for the maximum.
+	 */
+	void add(double seconds);
+
+	void clear();
+
+	unsigned long getCount() const;
+
+	/**
+	 * @param fraction 0.5 for the median, 0.99 for the 99th percentile.
+	 * @return The frame time in seconds that the given fraction of the frames
+	 *         did not exceed, to the resolution of a bucket. 0 without frames.
+	 */
+	double getPercentile(double fraction) const;
+
+	double getMax() const;
+
+	/**
+	 * @return e.g. "p50 16.67ms, p99 17.01ms, max 18.30ms over 3600 frames".
+	 */
+	string getSummary() const;
+
+private:
+	vector<unsigned long> buckets;
+	unsigned long count;
+	double max;
+};
+
+#endif /* FRAMETIMEHISTOGRAM_H_ */
@@ -0,0 +1,151 @@
+/*
+ * HeadlessContext.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include "HeadlessContext.h"
+#include <EGL/eglext.h>
+#include <GL/gl.h>
+#include <cstdio>
+
+HeadlessContext::HeadlessContext(int width, int height)
+{
+	this->width = width;
+	this->height = height;
+	display = EGL_NO_DISPLAY;
+	surface = EGL_NO_SURFACE;
+	context = EGL_NO_CONTEXT;
+	valid = false;
+
+	// prefer Mesa's surfaceless platform, the default platform needs an X server
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+		(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+	if(getPlatformDisplay != NULL)
+	{
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+	}
+
+	if(display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL))
+	{
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+		if(display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL))
+		{
+			printf("Error: could not initialize EGL (error 0x%x).\n", eglGetError());
+			display = EGL_NO_DISPLAY;
+			return;
+		}
+	}
+
+	const EGLint configAttributes[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_ALPHA_SIZE, 8,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+
+	const EGLint surfaceAttributes[] = {
+		EGL_WIDTH, width,
+		EGL_HEIGHT, height,
+		EGL_NONE
+	};
+
+	EGLConfig config;
+	EGLint numConfigs = 0;
+
+	if(!eglChooseConfig(display, configAttributes, &config, 1, &numConfigs) || numConfigs == 0)
+	{
+		printf("Error: no EGL config with an RGBA pbuffer and desktop OpenGL.\n");
+		return;
+	}
+
+	// the sprites use the fixed function pipeline, so ask for desktop GL
+	// rather than GLES
+	eglBindAPI(EGL_OPENGL_API);
+
+	surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+	context = eglCreateContext(display, config, EGL_NO_CONTEXT, NULL);
+
+	if(surface == EGL_NO_SURFACE || context == EGL_NO_CONTEXT)
+	{
+		printf("Error: could not create the offscreen surface (error 0x%x).\n", eglGetError());
+		return;
+	}
+
+	valid = eglMakeCurrent(display, surface, surface, context);
+}
+
+HeadlessContext::~HeadlessContext()
+{
+	if(display == EGL_NO_DISPLAY)
+	{
+		return;
+	}
+
+	eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+	if(context != EGL_NO_CONTEXT)
+	{
+		eglDestroyContext(display, context);
+	}
+
+	if(surface != EGL_NO_SURFACE)
+	{
+		eglDestroySurface(display, surface);
+	}
+
+	eglTerminate(display);
+}
+
+bool HeadlessContext::isValid() const
+{
+	return valid;
+}
+
+void HeadlessContext::readPixels(BYTE *pixels) const
+{
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+}
+
+bool HeadlessContext::saveBMP(const char *fileName) const
+{
+	BYTE *pixels = new BYTE[width * height * 4];
+
+	readPixels(pixels);
+	bool result = ImageLoader::saveBMP(fileName, width, height, pixels);
+
+	delete[] pixels;
+	return result;
+}
+
+int HeadlessContext::getWidth() const
+{
+	return width;
+}
+
+int HeadlessContext::getHeight() const
+{
+	return height;
+}
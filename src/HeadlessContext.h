@@ -0,0 +1,72 @@
+/*
+ * HeadlessContext.h
+ *
+ * An OpenGL context without a window, for rendering on machines without a
+ * display. Uses EGL with an offscreen pbuffer surface, which Mesa provides on
+ * its software rasterizer (llvmpipe) even when no X server is running.
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifndef HEADLESSCONTEXT_H_
+#define HEADLESSCONTEXT_H_
+
+#include <EGL/egl.h>
+#include "ImageLoader.h"
+
+class HeadlessContext
+{
+public:
+	/**
+	 * Creates an offscreen surface of the given size and makes its context
+	 * current. Check isValid() before rendering.
+	 */
+	HeadlessContext(int width, int height);
+	virtual ~HeadlessContext();
+
+	/**
+	 * @return True if the context was created and is current.
+	 */
+	bool isValid() const;
+
+	/**
+	 * Waits for rendering to finish and copies the surface into memory.
+	 * @param pixels Receives width * height 32-bit RGBA pixels, bottom row first.
+	 */
+	void readPixels(BYTE *pixels) const;
+
+	/**
+	 * Writes the current contents of the surface to a 32-bit bitmap.
+	 * @return True on success false on failure
+	 */
+	bool saveBMP(const char *fileName) const;
+
+	int getWidth() const;
+	int getHeight() const;
+
+private:
+	EGLDisplay display;
+	EGLSurface surface;
+	EGLContext context;
+	int width;
+	int height;
+	bool valid;
+};
+
+#endif /* HEADLESSCONTEXT_H_ */
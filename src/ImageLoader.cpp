@@ -21,180 +21,508 @@
  *
  */
 #include "ImageLoader.h"
+#include "BMPDecoder.h"
+#include "AssetPack.h"
+#include "CpuProfiler.h"
+#include "AlphaMask.h"
 #include <cstdio>
 #include <cstring>
+#include <algorithm>
 #include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <emmintrin.h>
+
+using namespace std;
 #define BITMAP_TYPE 19778
+//rows decoded per step, the decoder never needs more memory than that
+#define DECODE_ROWS 16
 
 ImageLoader::ImageLoader()
 {
 	reset();
 }
 
-ImageLoader::ImageLoader(const char *fileName)
+ImageLoader::ImageLoader(const char *fileName, LoadMode mode)
 {
 	reset();
-	loadBMP(fileName);
+	loadBMP(fileName, mode);
 }
 
 ImageLoader::~ImageLoader()
 {
+	freePixels();
+}
+
+void ImageLoader::freePixels(void)
+{
+    for(int level = 1; level < mipLevelCount; level++)
+    {
+        delete[] mipLevels[level];
+    }
+
+    mipLevelCount = 1;
+
     if(colors != NULL)
     {
         delete[] colors;
+        colors = NULL;
     }
 
-    if(pixelData != NULL)
+    //pixels used in place belong to the mapping
+    if(mapping != NULL)
+    {
+        munmap(mapping, mappingSize);
+        mapping = NULL;
+    }
+    else if(pixelData != NULL)
     {
         delete[] pixelData;
     }
-}
 
+    pixelData = NULL;
 
+    //the alpha of the old pixels is no longer valid
+    delete[] alphaPlane;
+    alphaPlane = NULL;
+    delete alphaMask;
+    alphaMask = NULL;
+}
 
-bool ImageLoader::loadBMP(const char * fileName)
+bool ImageLoader::loadBMP(const char * fileName, LoadMode mode)
 {
-	FILE *in = NULL;
+	CpuProfiler::Scope scope(CpuProfiler::LOAD_BMP);
+	int in = -1;
+	struct stat info;
+	struct timespec start, end;
+	BYTE *file = NULL;
 	bool result = false;
 
-	//open the file for reading in binary mode
-	in = fopen(fileName, "rb");
-	if(in == NULL)
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	//open the file for reading and map it into memory, so the headers and the
+	//pixels can be read in place without copying them into a buffer first
+	in = open(fileName, O_RDONLY);
+	if(in < 0 || fstat(in, &info) != 0)
 	{
 		perror("Error");
 		printf("errno = %d\n", errno);
+		if(in >= 0)
+		{
+			close(in);
+		}
 		return false;
 	}
 
-	fread(&bmfh, sizeof(BITMAPFILEHEADER), 1, in);
+	size_t fileSize = info.st_size;
 
-	// check if this is even the right type of file
-	if(bmfh.bfType != BITMAP_TYPE)
+	if(fileSize < sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER))
+	{
+		printf("Error: %s is too small to be a bitmap.\n", fileName);
+		close(in);
+		return false;
+	}
+
+	file = (BYTE *)mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, in, 0);
+	//the mapping stays valid after the file is closed
+	close(in);
+
+	if(file == MAP_FAILED)
 	{
 		perror("Error");
 		printf("errno = %d\n", errno);
 		return false;
 	}
 
-	fread(&bmih,sizeof(BITMAPINFOHEADER),1,in);
+	//the pixels are read once from front to back
+	madvise(file, fileSize, MADV_SEQUENTIAL);
+
+	memcpy(&bmfh, file, sizeof(BITMAPFILEHEADER));
+
+	// check if this is even the right type of file
+	if(bmfh.bfType != BITMAP_TYPE || bmfh.bfOffBits >= fileSize)
+	{
+		printf("Error: %s is not a valid bitmap.\n", fileName);
+		munmap(file, fileSize);
+		return false;
+	}
+
+	memcpy(&bmih, file + sizeof(BITMAPFILEHEADER), sizeof(BITMAPINFOHEADER));
 	width = bmih.biWidth;
 	height = bmih.biHeight;
 	bpp = bmih.biBitCount;
 
-	// TODO: make this work for 24bit images as well! It will segfault if given a 24 bit image...
-	//set the number of colours
-	LONG numColors = 1 << bmih.biBitCount;
+	//set the number of colours, biClrUsed may ask for a shorter palette
+	LONG numColors = 0;
+
+	if(bpp <= 8 && bpp > 0)
+	{
+		numColors = 1 << bpp;
+
+		if(bmih.biClrUsed > 0 && bmih.biClrUsed < (DWORD)numColors)
+		{
+			numColors = bmih.biClrUsed;
+		}
+	}
 
     //bitmap is not loaded yet
     loaded = false;
     //make sure memory is not lost
-    if(colors != NULL)
-    {
-        delete[] colors;
-    }
+    freePixels();
+    premultiplied = false;
+    pivotStored = false;
 
-    if(pixelData != NULL)
-    {
-        delete[] pixelData;
-    }
+	//load the palette for 8 bits per pixel or less, it follows the info header
+	//whatever version of the header the file uses
+	DWORD paletteOffset = sizeof(BITMAPFILEHEADER) + bmih.biSize;
 
-	//load the palette for 8 bits per pixel
-	if(bmih.biBitCount < 24)
+	if(numColors > 0 && paletteOffset + numColors * sizeof(RGBQUAD) <= fileSize)
 	{
 	    colors = new RGBQUAD[numColors];
-	    fread(colors, sizeof(RGBQUAD), numColors, in);
+	    memcpy(colors, file + paletteOffset, numColors * sizeof(RGBQUAD));
+	}
+	else
+	{
+	    numColors = 0;
 	}
 
-	DWORD size = bmfh.bfSize - bmfh.bfOffBits;
+	//bitfield masks directly follow the basic info header, either as part of
+	//a newer header or on their own. Only newer headers and ALPHABITFIELDS
+	//images have an alpha mask.
+	DWORD masks[4] = { 0, 0, 0, 0 };
+	DWORD masksOffset = sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER);
+	bool hasAlphaMask = bmih.biSize >= 56 || bmih.biCompression == BMPDecoder::COMPRESSION_ALPHABITFIELDS;
 
-	BYTE *tempPixelData = NULL;
+	if(masksOffset + sizeof(masks) <= fileSize)
+	{
+		memcpy(masks, file + masksOffset, hasAlphaMask ? 4 * sizeof(DWORD) : 3 * sizeof(DWORD));
+	}
 
-	tempPixelData = new BYTE[size];
+	//some programs write a wrong file size, never read past the end of the file.
+	//A size that ends before the pixels start is ignored
+	size_t fileEnd = bmfh.bfSize > bmfh.bfOffBits ? min((size_t)bmfh.bfSize, fileSize) : fileSize;
+	DWORD size = fileEnd - bmfh.bfOffBits;
 
-	if(tempPixelData == NULL)
+	if(mode == NATIVE && bpp == 32 && bmih.biCompression == 0)
 	{
-		printf("Error: out of memory. Cannot find space to load image into memory.\n");
-	    fclose(in);
-	    return false;
+		result = useInPlace(file + bmfh.bfOffBits, size);
+	}
+	else
+	{
+		result = fixPadding(file + bmfh.bfOffBits, size, masks, numColors);
 	}
 
-	fread(tempPixelData, sizeof(BYTE), size, in);
-
-	result = fixPadding(tempPixelData, size);
 	loaded = result;
 
-	delete[] tempPixelData;
-	fclose(in);
+	//keep the file mapped while its pixels are used in place
+	if(result && pixelData == file + bmfh.bfOffBits)
+	{
+		mapping = file;
+		mappingSize = fileSize;
+		//the whole image will be read again by the texture upload
+		madvise(file, fileSize, MADV_WILLNEED);
+	}
+	else
+	{
+		munmap(file, fileSize);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	loadTime = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	peakRSS = usage.ru_maxrss;
 
 	return result;
 }
 
-bool ImageLoader::fixPadding(BYTE const * const tempPixelData, DWORD size)
+bool ImageLoader::fixPadding(BYTE const * const tempPixelData, DWORD size,
+							 const DWORD *masks, LONG numColors)
 {
-	//byteWidth is the width of the actual image in bytes
-	//padWidth is the width of the image plus the extra padding
-	LONG byteWidth, padWidth;
-
-	//initially set both to the width of the image
-	byteWidth = padWidth = (LONG)((float)width * (float)bpp / 8.0);
+	BMPDecoder decoder(bmih, masks, colors, numColors, tempPixelData, size);
 
-	//add any extra space to bring each line to a DWORD boundary
-	short padding = padWidth % 4 != 0;
-	padWidth += padding;
+	if(!decoder.isValid())
+	{
+		return false;
+	}
 
-	DWORD diff;
-	int offset;
+	height = decoder.getHeight();
+	//byteWidth is the width of the decoded image in bytes, without padding
+	LONG byteWidth = width * 4;
 
-	height = bmih.biHeight;
-	//set diff to the actual image size(no padding)
-	diff = height * byteWidth;
 	//allocate memory for the image
-	pixelData = new BYTE[diff];
+	pixelData = new BYTE[height * byteWidth];
+	format = FORMAT_RGBA;
+	stride = byteWidth;
+	flipped = false;
+
+	//the rows are kept bottom-up, which is what OpenGL expects, so top-down
+	//bitmaps are decoded from the last row upwards
+	BYTE *target = decoder.isTopDown() ? pixelData + (height - 1) * byteWidth : pixelData;
+	LONG step = decoder.isTopDown() ? -byteWidth : byteWidth;
+	LONG rows;
+
+	//decode straight into place a few rows at a time, so no second buffer the
+	//size of the image is ever needed
+	while((rows = decoder.decodeRows(target, step, DECODE_ROWS)) > 0)
+	{
+		target += rows * step;
+	}
+
+	return true;
+}
+
+bool ImageLoader::useInPlace(BYTE const * const filePixelData, DWORD size)
+{
+	flipped = bmih.biHeight < 0;
+	height = flipped ? -bmih.biHeight : bmih.biHeight;
+	//32-bit rows are always DWORD aligned
+	stride = width * 4;
+	format = FORMAT_BGRA;
 
+	if(width <= 0 || (unsigned long)stride * height > size)
+	{
+		printf("Error: the bitmap is missing pixel data.\n");
+		return false;
+	}
+
+	pixelData = (BYTE *)filePixelData;
+
+	return true;
+}
+
+bool ImageLoader::loadPack(const AssetPack &pack, const string &name)
+{
+	struct timespec start, end;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	loaded = false;
+	freePixels();
+
+	const ASSETPACKENTRY *entry = pack.find(name);
+
+	if(entry == NULL || entry->width <= 0 || entry->height <= 0)
+	{
+		printf("Error: %s is not in the asset pack.\n", name.c_str());
+		return false;
+	}
+
+	width = entry->width;
+	height = entry->height;
+	bpp = 32;
+	format = FORMAT_RGBA;
+	stride = width * 4;
+	flipped = false;
+	premultiplied = (entry->flags & AssetPack::PREMULTIPLIED) != 0;
+	pivotStored = true;
+	pivotX = entry->pivotX;
+	pivotY = entry->pivotY;
+
+	pixelData = new BYTE[height * stride];
+
+	if(!pack.extract(*entry, pixelData))
+	{
+		printf("Error: %s is corrupt in the asset pack.\n", name.c_str());
+		freePixels();
+		return false;
+	}
+
+	loaded = true;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	loadTime = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	peakRSS = usage.ru_maxrss;
+
+	return true;
+}
+
+BYTE *ImageLoader::create(LONG width, LONG height, PixelFormat format, bool premultiplied)
+{
+	freePixels();
+
+	this->width = width;
+	this->height = height;
+	this->format = format;
+	this->premultiplied = premultiplied;
+	bpp = 32;
+	stride = width * 4;
+	flipped = false;
+	pivotStored = false;
+
+	pixelData = new BYTE[height * stride];
+	memset(pixelData, 0, height * stride);
+	loaded = true;
+
+	return pixelData;
+}
+
+int ImageLoader::generateMipmaps(int maxLevels)
+{
 	if(pixelData == NULL)
 	{
-	    return false;
+		return 0;
 	}
 
-	//bitmap is inverted, so the padding needs to be removed
-	//and the image reversed
-	//Here you can start from the back of the file or the front,
-	//after the header.  The only problem is that some programs
-	//will pad not only the data, but also the file size to
-	//be divisible by 4 bytes.
-	if(height > 0)
+	maxLevels = min(maxLevels, MAX_MIP_LEVELS);
+
+	while(mipLevelCount < maxLevels &&
+		  (getMipWidth(mipLevelCount - 1) > 1 || getMipHeight(mipLevelCount - 1) > 1))
 	{
-	    offset = padWidth - byteWidth;
+		int level = mipLevelCount;
+
+		mipLevels[level] = new BYTE[getMipWidth(level) * getMipHeight(level) * 4];
+		downsample(mipLevels[level], getMipLevel(level - 1), getMipWidth(level - 1),
+				   getMipHeight(level - 1), getMipStride(level - 1));
+		mipLevelCount++;
+	}
+
+	return mipLevelCount;
+}
+
+void ImageLoader::downsample(BYTE *destination, const BYTE *source,
+							 LONG width, LONG height, LONG sourceStride)
+{
+	LONG halfWidth = max(width / 2, 1);
+	LONG halfHeight = max(height / 2, 1);
+	// a side of one pixel is averaged with itself
+	LONG stepX = width > 1 ? 4 : 0;
+	LONG stepY = height > 1 ? sourceStride : 0;
 
-	    for(unsigned int i = 0; i < size - 2; i += 4)
-	    {
-	        if( (i + 1) % padWidth == 0)
-	        {
-	            i += offset;
-	        }
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i rounding = _mm_set1_epi16(2);
 
-	        // swap data for it to have the right order
-	        *(pixelData + i)      = *(tempPixelData + i + 2); // R
-	        *(pixelData + i + 1 ) = *(tempPixelData + i + 1); // G
-	        *(pixelData + i + 2)  = *(tempPixelData + i);     // B
-	        *(pixelData + i + 3)  = *(tempPixelData + i + 3); // A
-	    }
+	for(LONG y = 0; y < halfHeight; y++)
+	{
+		const BYTE *top = source + y * 2 * sourceStride;
+		const BYTE *bottom = top + stepY;
+		BYTE *target = destination + y * halfWidth * 4;
+		LONG x = 0;
+
+		// four source pixels of both rows give two destination pixels
+		if(stepX != 0)
+		{
+			for(; x + 2 <= halfWidth; x += 2)
+			{
+				__m128i row0 = _mm_loadu_si128((const __m128i *)(top + x * 8));
+				__m128i row1 = _mm_loadu_si128((const __m128i *)(bottom + x * 8));
+
+				// one channel per 16 bit lane, the rows added up
+				__m128i left = _mm_add_epi16(_mm_unpacklo_epi8(row0, zero), _mm_unpacklo_epi8(row1, zero));
+				__m128i right = _mm_add_epi16(_mm_unpackhi_epi8(row0, zero), _mm_unpackhi_epi8(row1, zero));
+
+				// add each pixel to its neighbour in the upper half of the register
+				left = _mm_add_epi16(left, _mm_srli_si128(left, 8));
+				right = _mm_add_epi16(right, _mm_srli_si128(right, 8));
+
+				__m128i sum = _mm_unpacklo_epi64(left, right);
+				sum = _mm_srli_epi16(_mm_add_epi16(sum, rounding), 2);
+
+				_mm_storel_epi64((__m128i *)(target + x * 4), _mm_packus_epi16(sum, zero));
+			}
+		}
+
+		for(; x < halfWidth; x++)
+		{
+			const BYTE *p0 = top + x * 2 * stepX;
+			const BYTE *p1 = bottom + x * 2 * stepX;
+
+			for(int c = 0; c < 4; c++)
+			{
+				target[x * 4 + c] = (p0[c] + p0[stepX + c] + p1[c] + p1[stepX + c] + 2) >> 2;
+			}
+		}
 	}
-	//the image is not reversed.  Only the padding needs to be removed.
-	else
+}
+
+bool ImageLoader::saveBMP(const char *fileName, LONG width, LONG height, const BYTE *pixels)
+{
+	FILE *out = NULL;
+	vector<BYTE> data;
+
+	out = fopen(fileName, "wb");
+	if(out == NULL)
 	{
-		// TODO: test this branch!
-	    height = height * -1;
-	    offset = 0;
+		perror("Error");
+		printf("errno = %d\n", errno);
+		return false;
+	}
+
+	encodeBMP(width, height, pixels, data);
+	fwrite(&data[0], sizeof(BYTE), data.size(), out);
+
+	return fclose(out) == 0;
+}
 
-	    do
-	    {
-	    	memcpy((pixelData + (offset * byteWidth)), (tempPixelData + (offset * padWidth)), byteWidth);
-	        offset++;
-	    } while(offset < height);
+void ImageLoader::encodeBMP(LONG width, LONG height, const BYTE *pixels, vector<BYTE> &data)
+{
+	BITMAPFILEHEADER fileHeader;
+	BITMAPINFOHEADER infoHeader;
+	DWORD size = width * height * 4;
+
+	memset(&fileHeader, 0, sizeof(BITMAPFILEHEADER));
+	memset(&infoHeader, 0, sizeof(BITMAPINFOHEADER));
+
+	fileHeader.bfType = BITMAP_TYPE;
+	fileHeader.bfOffBits = sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER);
+	fileHeader.bfSize = fileHeader.bfOffBits + size;
+
+	infoHeader.biSize = sizeof(BITMAPINFOHEADER);
+	infoHeader.biWidth = width;
+	infoHeader.biHeight = height; // positive height, bottom row first
+	infoHeader.biPlanes = 1;
+	infoHeader.biBitCount = 32;
+	infoHeader.biSizeImage = size;
+
+	data.resize(fileHeader.bfSize);
+	memcpy(&data[0], &fileHeader, sizeof(BITMAPFILEHEADER));
+	memcpy(&data[sizeof(BITMAPFILEHEADER)], &infoHeader, sizeof(BITMAPINFOHEADER));
+
+	// 32-bit rows never need padding, only the colour order differs
+	BYTE *to = &data[fileHeader.bfOffBits];
+
+	for(DWORD x = 0; x < size; x += 4)
+	{
+		to[x]     = pixels[x + 2]; // B
+		to[x + 1] = pixels[x + 1]; // G
+		to[x + 2] = pixels[x];     // R
+		to[x + 3] = pixels[x + 3]; // A
 	}
+}
 
-	return true;
+void ImageLoader::swap(ImageLoader &other)
+{
+	std::swap(bmfh, other.bmfh);
+	std::swap(bmih, other.bmih);
+	std::swap(colors, other.colors);
+	std::swap(pixelData, other.pixelData);
+	std::swap(mipLevels, other.mipLevels);
+	std::swap(mipLevelCount, other.mipLevelCount);
+	std::swap(loaded, other.loaded);
+	std::swap(width, other.width);
+	std::swap(height, other.height);
+	std::swap(bpp, other.bpp);
+	std::swap(loadTime, other.loadTime);
+	std::swap(peakRSS, other.peakRSS);
+	std::swap(format, other.format);
+	std::swap(stride, other.stride);
+	std::swap(flipped, other.flipped);
+	std::swap(premultiplied, other.premultiplied);
+	std::swap(pivotStored, other.pivotStored);
+	std::swap(pivotX, other.pivotX);
+	std::swap(pivotY, other.pivotY);
+	std::swap(mapping, other.mapping);
+	std::swap(mappingSize, other.mappingSize);
+	std::swap(alphaPlane, other.alphaPlane);
+	std::swap(alphaMask, other.alphaMask);
 }
 
 void ImageLoader::reset(void)
@@ -204,23 +532,68 @@ void ImageLoader::reset(void)
 	pixelData = NULL;
 	colors = NULL;
 	loaded = false;
+	loadTime = 0;
+	peakRSS = 0;
+	format = FORMAT_RGBA;
+	stride = 0;
+	flipped = false;
+	premultiplied = false;
+	pivotStored = false;
+	pivotX = 0;
+	pivotY = 0;
+	mipLevelCount = 1;
+	mapping = NULL;
+	mappingSize = 0;
+	alphaPlane = NULL;
+	alphaMask = NULL;
 }
 
 BYTE *ImageLoader::getAlpha() const
 {
+	const BYTE *plane = getAlphaPlane();
+
+	if(plane == NULL)
+	{
+		return NULL;
+	}
+
 	LONG arraySize = width * height;
 	BYTE *array = new BYTE[arraySize];
 
-	if(array == NULL)
+	memcpy(array, plane, arraySize);
+
+	return array;
+}
+
+const BYTE *ImageLoader::getAlphaPlane() const
+{
+	if(alphaPlane == NULL && pixelData != NULL)
 	{
-		delete[] array;
-		return NULL;
+		alphaPlane = new BYTE[width * height];
+
+		for(LONG y = 0; y < height; y++)
+		{
+			const BYTE *row = getRow(y);
+			BYTE *alpha = alphaPlane + y * width;
+
+			for(LONG x = 0; x < width; x++)
+			{
+				alpha[x] = row[x * 4 + 3]; // the alpha is the fourth byte in RGBA and BGRA alike
+			}
+		}
 	}
 
-	for(long i = 0; i < arraySize; i++)
+	return alphaPlane;
+}
+
+const AlphaMask &ImageLoader::getAlphaMask() const
+{
+	if(alphaMask == NULL)
 	{
-		array[i] = pixelData[i * 4 + 3]; // jump to the alpha and extract it everytime
+		const BYTE *plane = getAlphaPlane();
+
+		alphaMask = plane != NULL ? new AlphaMask(plane, width, height) : new AlphaMask();
 	}
 
-	return array;
+	return *alphaMask;
 }
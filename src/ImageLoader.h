@@ -1,8 +1,8 @@
 /*
  * ImageLoader.h
  *
- * An image loader designed to read a 32-bit bitmap. Although it may be extended to be
- * do other things too in the future.
+ * An image loader designed to read bitmaps. Palettized, RLE compressed, 16, 24 and
+ * 32-bit images are all expanded to 32-bit RGBA.
  *
  *  Created on: 2010-08-11
  *      Author: Michael Yagudaev
@@ -27,11 +27,20 @@
 #ifndef IMAGELOADER_H_
 #define IMAGELOADER_H_
 
+#include <string>
+#include <vector>
+
 typedef unsigned char BYTE;
 typedef int LONG;
 typedef unsigned int DWORD;
 typedef unsigned short WORD;
 
+class AssetPack;
+class AlphaMask;
+
+//enough levels for any image whose sides fit in a LONG
+#define MAX_MIP_LEVELS 32
+
 //File information header
 //provides general information about the file
 typedef struct __attribute__ ((__packed__)) tagBITMAPFILEHEADER
@@ -75,6 +84,29 @@ class ImageLoader
 public:
     //variables
 
+    /**
+     * How loadBMP stores the pixels in memory
+     */
+    enum LoadMode
+    {
+        /**
+         * Tightly packed RGBA rows, bottom row first. Costs one conversion pass.
+         */
+        CONVERT,
+        /**
+         * The pixels are left in the file, which stays mapped into memory: BGRA
+         * rows with getStride() bytes between them, top row first if isFlipped().
+         * Bitmaps other than uncompressed 32-bit ones are converted instead.
+         */
+        NATIVE
+    };
+
+    enum PixelFormat
+    {
+        FORMAT_RGBA,
+        FORMAT_BGRA
+    };
+
     //methods
 
     /**
@@ -85,7 +117,7 @@ public:
     /**
      * Initializes an image with the given image loaded from disk
      */
-    ImageLoader(const char *fileName);
+    ImageLoader(const char *fileName, LoadMode mode = CONVERT);
 
     /**
      * Destructor...
@@ -96,14 +128,85 @@ public:
      * Loads the given image.
      * @return True on success false on failure
      */
-    bool loadBMP(const char *fileName);
+    bool loadBMP(const char *fileName, LoadMode mode = CONVERT);
+
+    /**
+     * Saves 32-bit RGBA pixels as a 32-bit bitmap with the alpha channel in the
+     * fourth byte, the same layout loadBMP reads.
+     * @param pixels width * height pixels, bottom row first.
+     * @return True on success false on failure
+     */
+    static bool saveBMP(const char *fileName, LONG width, LONG height, const BYTE *pixels);
+
+    /**
+     * Encodes pixels the way saveBMP writes them, in memory.
+     * @param data Receives the whole file.
+     */
+    static void encodeBMP(LONG width, LONG height, const BYTE *pixels, std::vector<BYTE> &data);
+
+    /**
+     * Loads an image from an asset pack instead of a bitmap. The pixels are
+     * premultiplied RGBA rows, bottom row first, and the image has the pivot
+     * stored in the pack.
+     * @param name The name of the image in the pack, e.g. "graphics/clockface.bmp"
+     * @return True on success false on failure
+     */
+    bool loadPack(const AssetPack &pack, const std::string &name);
+
+    /**
+     * Replaces the image with a new, transparent one.
+     * @return The pixels to fill in, bottom row first without padding.
+     */
+    BYTE *create(LONG width, LONG height, PixelFormat format, bool premultiplied);
+
+    /**
+     * Exchanges the pixels and everything known about them with another
+     * image, e.g. to put a reloaded image in place of one that is in use.
+     */
+    void swap(ImageLoader &other);
+
+    /**
+     * Builds the mip chain of the image with a 2x2 box filter, each level half
+     * the size of the previous one (rounded down) until 1x1 or maxLevels
+     * levels exist. The levels keep the format and row order of the image.
+     * @return The number of levels, including the image itself.
+     */
+    int generateMipmaps(int maxLevels = MAX_MIP_LEVELS);
+
+    /**
+     * Halves 32-bit pixels in each direction with a 2x2 box filter, the last
+     * row or column of odd sizes is dropped. Sides of 1 pixel stay 1 pixel.
+     * The order of the channels does not matter.
+     * @param destination Receives max(width / 2, 1) * max(height / 2, 1)
+     *        tightly packed pixels.
+     * @param sourceStride Bytes from one source row to the next.
+     */
+    static void downsample(BYTE *destination, const BYTE *source,
+                           LONG width, LONG height, LONG sourceStride);
 
     /**
      * Get the alpha channel as an array of bytes
-     * @param size The size of the returned array, will return -1 on failure
+     * @return A copy of getAlphaPlane() for the caller to delete[].
      */
     BYTE *getAlpha() const;
 
+    /**
+     * Extracts the alpha channel the first time it is asked for and keeps it
+     * until the pixels change, so asking again costs nothing.
+     * @return width * height alpha values, bottom row first. Owned by the
+     *         image, NULL if it has no pixels.
+     */
+    const BYTE *getAlphaPlane() const;
+
+    /**
+     * Builds the coverage mask of the image the first time it is asked for,
+     * from the alpha plane with the default threshold. Sprites share their
+     * images, so all sprites of an image share the mask as well.
+     * @return The mask, empty if the image has no pixels. Valid until the
+     *         pixels change.
+     */
+    const AlphaMask &getAlphaMask() const;
+
     // Getter and setters...
     LONG getHeight() const
     {
@@ -120,29 +223,163 @@ public:
         return loaded;
     }
 
+    /**
+     * @return The first row of pixels as stored in memory, see getFormat(),
+     *         getStride() and isFlipped() for their layout.
+     */
     BYTE *getPixelData() const
     {
         return pixelData;
     }
 
+    /**
+     * @return Row y of the image counting from the bottom, whatever order the
+     *         rows are stored in.
+     */
+    const BYTE *getRow(LONG y) const
+    {
+        return pixelData + (flipped ? height - 1 - y : y) * stride;
+    }
+
+    PixelFormat getFormat() const
+    {
+        return format;
+    }
+
+    /**
+     * @return Bytes from the start of one stored row to the next.
+     */
+    LONG getStride() const
+    {
+        return stride;
+    }
+
+    /**
+     * @return True if the rows are stored top row first, which OpenGL would
+     *         show upside down.
+     */
+    bool isFlipped() const
+    {
+        return flipped;
+    }
+
     LONG getWidth() const
     {
         return width;
     }
 
+    /**
+     * @return True if the colour channels are already multiplied by alpha, to
+     *         be blended with GL_ONE, GL_ONE_MINUS_SRC_ALPHA.
+     */
+    bool isPremultiplied() const
+    {
+        return premultiplied;
+    }
+
+    /**
+     * @return True if the image came with a default pivot, see getPivotX().
+     */
+    bool hasPivot() const
+    {
+        return pivotStored;
+    }
+
+    float getPivotX() const
+    {
+        return pivotX;
+    }
+
+    float getPivotY() const
+    {
+        return pivotY;
+    }
+
+    /**
+     * @return The time the last loadBMP call took, in seconds.
+     */
+    double getLoadTime() const
+    {
+        return loadTime;
+    }
+
+    /**
+     * @return The peak resident set size of the process right after the last
+     *         loadBMP call, in kilobytes.
+     */
+    long getPeakRSS() const
+    {
+        return peakRSS;
+    }
+
+    /**
+     * @return The number of mip levels, 1 until generateMipmaps() is called.
+     */
+    int getMipLevelCount() const
+    {
+        return mipLevelCount;
+    }
+
+    /**
+     * @return The first stored row of the given level, level 0 being the image
+     *         itself. Levels above 0 are tightly packed.
+     */
+    const BYTE *getMipLevel(int level) const
+    {
+        return level == 0 ? pixelData : mipLevels[level];
+    }
+
+    LONG getMipWidth(int level) const
+    {
+        LONG size = width >> level;
+        return size > 0 ? size : 1;
+    }
+
+    LONG getMipHeight(int level) const
+    {
+        LONG size = height >> level;
+        return size > 0 ? size : 1;
+    }
+
+    LONG getMipStride(int level) const
+    {
+        return level == 0 ? stride : getMipWidth(level) * 4;
+    }
+
 private:
     //variables
     BITMAPFILEHEADER bmfh;
     BITMAPINFOHEADER bmih;
     RGBQUAD *colors;
     BYTE *pixelData;
+    //levels 1 and up of the mip chain
+    BYTE *mipLevels[MAX_MIP_LEVELS];
+    int mipLevelCount;
     bool loaded;
     LONG width;
     LONG height;
     WORD bpp;
+    double loadTime;
+    long peakRSS;
+    PixelFormat format;
+    LONG stride;
+    bool flipped;
+    bool premultiplied;
+    bool pivotStored;
+    float pivotX;
+    float pivotY;
+    //the mapped file when the pixels are used in place
+    BYTE *mapping;
+    DWORD mappingSize;
+    //built on demand from the pixels and freed with them
+    mutable BYTE *alphaPlane;
+    mutable AlphaMask *alphaMask;
 
     //methods
     void reset(void);
-    bool fixPadding(BYTE const * const tempPixelData, DWORD size);
+    void freePixels(void);
+    bool fixPadding(BYTE const * const tempPixelData, DWORD size,
+                    const DWORD *masks, LONG numColors);
+    bool useInPlace(BYTE const * const filePixelData, DWORD size);
 };
 #endif /* IMAGELOADER_H_ */
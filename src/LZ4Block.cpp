@@ -0,0 +1,260 @@
+/*
+ * LZ4Block.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <cstring>
+#include "LZ4Block.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// A block is a list of sequences. Each one starts with a token whose high
+// nibble is the number of literals and whose low nibble is the match length
+// minus MIN_MATCH; 15 in either means more length bytes follow. Then come the
+// literals, a 2 byte little endian offset back into the output, and the extra
+// match length bytes. The last sequence only has literals.
+///////////////////////////////////////////////////////////////////////////////
+
+#define MIN_MATCH 4
+// the format requires the last 5 bytes to be literals and the last match to
+// start at least 12 bytes before the end
+#define LAST_LITERALS 5
+#define MATCH_LIMIT 12
+#define MAX_OFFSET 65535
+#define HASH_BITS 14
+
+static inline DWORD read32(const BYTE *p)
+{
+	DWORD value;
+	memcpy(&value, p, 4);
+	return value;
+}
+
+static inline DWORD hash(DWORD sequence)
+{
+	return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static BYTE *writeLength(BYTE *out, DWORD length)
+{
+	while(length >= 255)
+	{
+		*out++ = 255;
+		length -= 255;
+	}
+
+	*out++ = (BYTE)length;
+	return out;
+}
+
+static BYTE *writeSequence(BYTE *out, const BYTE *literals, DWORD literalCount,
+						   DWORD offset, DWORD matchLength)
+{
+	BYTE *token = out++;
+	DWORD extraMatch = matchLength >= MIN_MATCH ? matchLength - MIN_MATCH : 0;
+
+	*token = (BYTE)((literalCount < 15 ? literalCount : 15) << 4);
+
+	if(literalCount >= 15)
+	{
+		out = writeLength(out, literalCount - 15);
+	}
+
+	memcpy(out, literals, literalCount);
+	out += literalCount;
+
+	if(matchLength == 0)
+	{
+		return out;
+	}
+
+	*out++ = offset & 0xff;
+	*out++ = offset >> 8;
+	*token |= extraMatch < 15 ? extraMatch : 15;
+
+	if(extraMatch >= 15)
+	{
+		out = writeLength(out, extraMatch - 15);
+	}
+
+	return out;
+}
+
+DWORD LZ4Block::getMaxCompressedSize(DWORD size)
+{
+	return size + size / 255 + 16;
+}
+
+DWORD LZ4Block::compress(BYTE *destination, const BYTE *source, DWORD size)
+{
+	BYTE *out = destination;
+	DWORD anchor = 0;
+	DWORD position = 0;
+
+	if(size > MATCH_LIMIT)
+	{
+		// positions of the last sequence seen with each hash, plus one so 0 is empty
+		DWORD *table = new DWORD[1 << HASH_BITS];
+		memset(table, 0, sizeof(DWORD) << HASH_BITS);
+
+		DWORD matchLimit = size - MATCH_LIMIT;
+		DWORD lengthLimit = size - LAST_LITERALS;
+
+		while(position < matchLimit)
+		{
+			DWORD sequence = read32(source + position);
+			DWORD slot = hash(sequence);
+			DWORD candidate = table[slot];
+			table[slot] = position + 1;
+
+			if(candidate == 0 || position - (candidate - 1) > MAX_OFFSET ||
+			   read32(source + candidate - 1) != sequence)
+			{
+				position++;
+				continue;
+			}
+
+			DWORD match = candidate - 1;
+
+			// extend the match backwards over literals, then forwards
+			while(position > anchor && match > 0 && source[position - 1] == source[match - 1])
+			{
+				position--;
+				match--;
+			}
+
+			DWORD length = MIN_MATCH;
+
+			while(position + length < lengthLimit && source[position + length] == source[match + length])
+			{
+				length++;
+			}
+
+			out = writeSequence(out, source + anchor, position - anchor, position - match, length);
+
+			position += length;
+			anchor = position;
+		}
+
+		delete[] table;
+	}
+
+	return writeSequence(out, source + anchor, size - anchor, 0, 0) - destination;
+}
+
+bool LZ4Block::decompress(BYTE *destination, DWORD destinationSize,
+						  const BYTE *source, DWORD sourceSize)
+{
+	const BYTE *in = source;
+	const BYTE *inEnd = source + sourceSize;
+	BYTE *out = destination;
+	BYTE *outEnd = destination + destinationSize;
+
+	while(in < inEnd)
+	{
+		BYTE token = *in++;
+		DWORD literalCount = token >> 4;
+
+		if(literalCount == 15)
+		{
+			BYTE extra;
+
+			do
+			{
+				if(in >= inEnd)
+				{
+					return false;
+				}
+
+				extra = *in++;
+				literalCount += extra;
+			} while(extra == 255);
+		}
+
+		if(literalCount > (DWORD)(inEnd - in) || literalCount > (DWORD)(outEnd - out))
+		{
+			return false;
+		}
+
+		memcpy(out, in, literalCount);
+		in += literalCount;
+		out += literalCount;
+
+		// the last sequence ends after its literals
+		if(in == inEnd)
+		{
+			break;
+		}
+
+		if(inEnd - in < 2)
+		{
+			return false;
+		}
+
+		DWORD offset = in[0] | in[1] << 8;
+		in += 2;
+		DWORD matchLength = (token & 0x0f) + MIN_MATCH;
+
+		if((token & 0x0f) == 15)
+		{
+			BYTE extra;
+
+			do
+			{
+				if(in >= inEnd)
+				{
+					return false;
+				}
+
+				extra = *in++;
+				matchLength += extra;
+			} while(extra == 255);
+		}
+
+		if(offset == 0 || offset > (DWORD)(out - destination) || matchLength > (DWORD)(outEnd - out))
+		{
+			return false;
+		}
+
+		const BYTE *match = out - offset;
+
+		// matches may overlap the bytes they produce, e.g. runs of one pixel
+		if(offset >= matchLength)
+		{
+			memcpy(out, match, matchLength);
+			out += matchLength;
+		}
+		else
+		{
+			// copy the repeating pattern in chunks that double every time,
+			// [match, out) always holds a whole number of periods
+			BYTE *end = out + matchLength;
+
+			while(out < end)
+			{
+				DWORD chunk = out - match;
+				chunk = chunk < (DWORD)(end - out) ? chunk : end - out;
+				memcpy(out, match, chunk);
+				out += chunk;
+			}
+		}
+	}
+
+	return out == outEnd;
+}
@@ -0,0 +1,56 @@
+/*
+ * LZ4Block.h
+ *
+ * A small implementation of the LZ4 block format, enough to compress assets
+ * offline and decompress them quickly at startup. The output can be read by
+ * any LZ4 decoder that understands raw blocks (LZ4_decompress_safe).
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifndef LZ4BLOCK_H_
+#define LZ4BLOCK_H_
+
+#include "ImageLoader.h"
+
+class LZ4Block
+{
+public:
+	/**
+	 * @return The most bytes compress() can produce for the given input size.
+	 */
+	static DWORD getMaxCompressedSize(DWORD size);
+
+	/**
+	 * Compresses size bytes of source into destination, which must hold at
+	 * least getMaxCompressedSize(size) bytes.
+	 * @return The size of the compressed block.
+	 */
+	static DWORD compress(BYTE *destination, const BYTE *source, DWORD size);
+
+	/**
+	 * Decompresses a block, never reading or writing out of bounds even if the
+	 * block is corrupt.
+	 * @return True if exactly destinationSize bytes were decompressed.
+	 */
+	static bool decompress(BYTE *destination, DWORD destinationSize,
+						   const BYTE *source, DWORD sourceSize);
+};
+
+#endif /* LZ4BLOCK_H_ */
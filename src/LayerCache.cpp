@@ -0,0 +1,231 @@
+/*
+ * LayerCache.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#define GL_GLEXT_PROTOTYPES
+#include <GL/glut.h>
+#include <cstdlib>
+#include <cstring>
+#include "LayerCache.h"
+#include "Sprite.h"
+#include "SoftwareRenderer.h"
+#include "Profiler.h"
+
+LayerCache::LayerCache(BYTE red, BYTE green, BYTE blue, BYTE alpha)
+{
+	clearColor[0] = red;
+	clearColor[1] = green;
+	clearColor[2] = blue;
+	clearColor[3] = alpha;
+	valid = false;
+	frameBuffer = 0;
+	texture = 0;
+	width = 0;
+	height = 0;
+	buffer = NULL;
+}
+
+LayerCache::~LayerCache()
+{
+	deleteFrameBuffer();
+	delete buffer;
+}
+
+void LayerCache::add(Sprite *sprite)
+{
+	sprites.push_back(sprite);
+	valid = false;
+}
+
+void LayerCache::invalidate()
+{
+	valid = false;
+}
+
+bool LayerCache::isStale() const
+{
+	if(!valid)
+	{
+		return true;
+	}
+
+	for(size_t i = 0; i < sprites.size(); i++)
+	{
+		if(sprites[i]->isDirty())
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool LayerCache::update(int width, int height)
+{
+	if(frameBuffer != 0 && (width != this->width || height != this->height))
+	{
+		deleteFrameBuffer();
+	}
+
+	if(frameBuffer == 0)
+	{
+		// frame buffer objects are core since OpenGL 3.0
+		const char *version = (const char *)glGetString(GL_VERSION);
+		const char *extensions = (const char *)glGetString(GL_EXTENSIONS);
+
+		if((version == NULL || atoi(version) < 3) &&
+		   (extensions == NULL || strstr(extensions, "GL_ARB_framebuffer_object") == NULL))
+		{
+			return false;
+		}
+
+		this->width = width;
+		this->height = height;
+		valid = false;
+
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		GLint previous;
+		glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous);
+
+		glGenFramebuffers(1, &frameBuffer);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, frameBuffer);
+		glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+		GLenum status = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previous);
+
+		if(status != GL_FRAMEBUFFER_COMPLETE)
+		{
+			deleteFrameBuffer();
+			return false;
+		}
+	}
+
+	if(!isStale())
+	{
+		return true;
+	}
+
+	GLint previous;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, frameBuffer);
+
+	glPushAttrib(GL_COLOR_BUFFER_BIT | GL_SCISSOR_BIT);
+	glDisable(GL_SCISSOR_TEST);
+	glClearColor(clearColor[0] / 255.0f, clearColor[1] / 255.0f, clearColor[2] / 255.0f, clearColor[3] / 255.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	batch.begin();
+
+	for(size_t i = 0; i < sprites.size(); i++)
+	{
+		batch.add(*sprites[i]);
+	}
+
+	batch.flush();
+
+	glPopAttrib();
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previous);
+
+	valid = true;
+	return true;
+}
+
+void LayerCache::update(const SoftwareRenderer &target)
+{
+	if(buffer != NULL && (buffer->getWidth() != target.getWidth() || buffer->getHeight() != target.getHeight()))
+	{
+		delete buffer;
+		buffer = NULL;
+	}
+
+	if(buffer == NULL)
+	{
+		buffer = new SoftwareRenderer(target.getWidth(), target.getHeight());
+		valid = false;
+	}
+
+	if(!isStale())
+	{
+		return;
+	}
+
+	buffer->clear(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+
+	for(size_t i = 0; i < sprites.size(); i++)
+	{
+		buffer->draw(*sprites[i]);
+	}
+
+	valid = true;
+}
+
+void LayerCache::draw() const
+{
+	Profiler::Scope scope(Profiler::LAYER_DRAW);
+
+	if(frameBuffer == 0)
+	{
+		return;
+	}
+
+	GLint previous;
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, frameBuffer);
+	glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, previous);
+
+	Profiler::countStateChanges(2);
+	Profiler::countDrawCalls(1);
+}
+
+void LayerCache::draw(SoftwareRenderer &target) const
+{
+	Profiler::Scope scope(Profiler::LAYER_DRAW);
+
+	if(buffer != NULL)
+	{
+		target.copy(*buffer);
+	}
+}
+
+void LayerCache::deleteFrameBuffer()
+{
+	if(frameBuffer != 0)
+	{
+		glDeleteFramebuffers(1, &frameBuffer);
+	}
+
+	if(texture != 0)
+	{
+		glDeleteTextures(1, &texture);
+	}
+
+	frameBuffer = 0;
+	texture = 0;
+	valid = false;
+}
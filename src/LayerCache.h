@@ -0,0 +1,118 @@
+/*
+ * LayerCache.h
+ *
+ * Keeps sprites that do not change, like the clock face, composited over the
+ * background colour in a frame buffer of their own. Every frame copies that
+ * layer into place instead of clearing and blending the sprites again, and
+ * only the moving sprites are drawn on top.
+ *
+ * With OpenGL the layer is a texture attached to a frame buffer object and is
+ * copied with glBlitFramebuffer, which respects the scissor rectangle. The
+ * SoftwareRenderer keeps it in a second SoftwareRenderer and copies it inside
+ * the clip rectangle.
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifndef LAYERCACHE_H_
+#define LAYERCACHE_H_
+
+#include <GL/glut.h>
+#include <vector>
+#include "ImageLoader.h"
+#include "SpriteBatch.h"
+
+using namespace std;
+
+class Sprite;
+class SoftwareRenderer;
+
+class LayerCache
+{
+public:
+	/**
+	 * @param red, green, blue, alpha The background the sprites are drawn
+	 *        over, the colour the frame buffer is cleared to.
+	 */
+	LayerCache(BYTE red, BYTE green, BYTE blue, BYTE alpha);
+
+	/**
+	 * Deletes the frame buffer object and its texture, if any.
+	 */
+	virtual ~LayerCache();
+
+	/**
+	 * Adds a sprite to the layer. Sprites are drawn in the order they are
+	 * added, all of them below any sprite drawn after the layer.
+	 */
+	void add(Sprite *sprite);
+
+	/**
+	 * Makes the next update() render the layer again, e.g. when the window
+	 * was resized.
+	 */
+	void invalidate();
+
+	/**
+	 * @return True if the next update() renders the layer again, because it
+	 *         was invalidated or one of its sprites was moved, turned or
+	 *         scaled since it was last drawn.
+	 */
+	bool isStale() const;
+
+	/**
+	 * Renders the layer with OpenGL at the given size if it is stale. Needs
+	 * the projection set up by reshape() for that size.
+	 * @return False if frame buffer objects are not supported, in which case
+	 *         the sprites have to be drawn every frame.
+	 */
+	bool update(int width, int height);
+
+	/**
+	 * Renders the layer with a SoftwareRenderer of the same size as the given
+	 * one if it is stale.
+	 */
+	void update(const SoftwareRenderer &target);
+
+	/**
+	 * Copies the layer into the frame buffer being drawn to, inside the
+	 * scissor rectangle if the scissor test is enabled.
+	 */
+	void draw() const;
+
+	/**
+	 * Copies the layer into the clip rectangle of the given renderer.
+	 */
+	void draw(SoftwareRenderer &target) const;
+
+private:
+	BYTE clearColor[4];
+	vector<Sprite *> sprites;
+	bool valid;
+	GLuint frameBuffer;
+	GLuint texture;
+	GLint width;
+	GLint height;
+	SpriteBatch batch;
+	SoftwareRenderer *buffer;
+
+	void deleteFrameBuffer();
+};
+
+#endif /* LAYERCACHE_H_ */
@@ -0,0 +1,243 @@
+/*
+ * PixelConvert.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <cstring>
+#include <immintrin.h>
+#include "PixelConvert.h"
+
+// swaps bytes 0 and 2 of every pixel, the same mask works on both 128 bit
+// halves of an AVX2 register
+#define SWIZZLE_MASK 15, 12, 13, 14, 11, 8, 9, 10, 7, 4, 5, 6, 3, 0, 1, 2
+
+static inline void convertPixels(BYTE *destination, const BYTE *source, LONG count)
+{
+	for(LONG i = 0; i < count; i++)
+	{
+		DWORD pixel;
+
+		// memcpy keeps unaligned rows legal, compilers turn it into a plain load
+		memcpy(&pixel, source + i * 4, 4);
+		pixel = (pixel & 0xff00ff00) | ((pixel >> 16) & 0xff) | ((pixel & 0xff) << 16);
+		memcpy(destination + i * 4, &pixel, 4);
+	}
+}
+
+static void convertRowScalar(BYTE *destination, const BYTE *source, LONG width)
+{
+	convertPixels(destination, source, width);
+}
+
+__attribute__((target("ssse3")))
+static void convertRowSSSE3(BYTE *destination, const BYTE *source, LONG width)
+{
+	const __m128i mask = _mm_set_epi8(SWIZZLE_MASK);
+	LONG i = 0;
+
+	for(; i + 4 <= width; i += 4)
+	{
+		__m128i pixels = _mm_loadu_si128((const __m128i *)(source + i * 4));
+		_mm_storeu_si128((__m128i *)(destination + i * 4), _mm_shuffle_epi8(pixels, mask));
+	}
+
+	convertPixels(destination + i * 4, source + i * 4, width - i);
+}
+
+__attribute__((target("avx2")))
+static void convertRowAVX2(BYTE *destination, const BYTE *source, LONG width)
+{
+	const __m256i mask = _mm256_set_epi8(SWIZZLE_MASK, SWIZZLE_MASK);
+	LONG i = 0;
+
+	// two registers per iteration to hide the load latency
+	for(; i + 16 <= width; i += 16)
+	{
+		__m256i first = _mm256_loadu_si256((const __m256i *)(source + i * 4));
+		__m256i second = _mm256_loadu_si256((const __m256i *)(source + i * 4 + 32));
+		_mm256_storeu_si256((__m256i *)(destination + i * 4), _mm256_shuffle_epi8(first, mask));
+		_mm256_storeu_si256((__m256i *)(destination + i * 4 + 32), _mm256_shuffle_epi8(second, mask));
+	}
+
+	for(; i + 8 <= width; i += 8)
+	{
+		__m256i pixels = _mm256_loadu_si256((const __m256i *)(source + i * 4));
+		_mm256_storeu_si256((__m256i *)(destination + i * 4), _mm256_shuffle_epi8(pixels, mask));
+	}
+
+	convertPixels(destination + i * 4, source + i * 4, width - i);
+}
+
+PixelConvert::RowFunction PixelConvert::convertRow = NULL;
+PixelConvert::InstructionSet PixelConvert::instructionSet = PixelConvert::SCALAR;
+
+void PixelConvert::bgraToRgba(BYTE *destination, const BYTE *source, LONG width, LONG height,
+							  LONG sourceStride, bool flip)
+{
+	for(LONG row = 0; row < height; row++)
+	{
+		LONG target = flip ? height - 1 - row : row;
+		bgraToRgbaRow(destination + target * width * 4, source + row * sourceStride, width);
+	}
+}
+
+void PixelConvert::bgraToRgbaRow(BYTE *destination, const BYTE *source, LONG width)
+{
+	// picked by the first call, once even if images are decoded on several threads
+	static bool selected = selectDefault();
+
+	(void)selected;
+	convertRow(destination, source, width);
+}
+
+bool PixelConvert::selectDefault()
+{
+	// unless setInstructionSet() was called before
+	if(convertRow == NULL)
+	{
+		setInstructionSet(getSupportedInstructionSet());
+	}
+
+	return true;
+}
+
+void PixelConvert::premultiplyRow(BYTE *destination, const BYTE *source, LONG width)
+{
+	for(LONG i = 0; i < width * 4; i += 4)
+	{
+		int alpha = source[i + 3];
+
+		for(int c = 0; c < 3; c++)
+		{
+			destination[i + c] = (source[i + c] * alpha + 127) / 255;
+		}
+
+		destination[i + 3] = alpha;
+	}
+}
+
+static inline BYTE getLuma(const BYTE *pixel)
+{
+	return ((66 * pixel[0] + 129 * pixel[1] + 25 * pixel[2] + 128) >> 8) + 16;
+}
+
+/**
+ * Converts a 2x2 block of pixels, or the pixels of a block at the right or
+ * bottom edge given twice.
+ */
+static inline void convertBlock(const BYTE *topLeft, const BYTE *topRight, const BYTE *bottomLeft,
+								const BYTE *bottomRight, BYTE *lumaTop, BYTE *lumaBottom, BYTE &blue, BYTE &red)
+{
+	lumaTop[0] = getLuma(topLeft);
+	lumaTop[1] = getLuma(topRight);
+	lumaBottom[0] = getLuma(bottomLeft);
+	lumaBottom[1] = getLuma(bottomRight);
+
+	// the average of the block, rounded
+	int r = (topLeft[0] + topRight[0] + bottomLeft[0] + bottomRight[0] + 2) >> 2;
+	int g = (topLeft[1] + topRight[1] + bottomLeft[1] + bottomRight[1] + 2) >> 2;
+	int b = (topLeft[2] + topRight[2] + bottomLeft[2] + bottomRight[2] + 2) >> 2;
+
+	blue = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+	red = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+}
+
+void PixelConvert::rgbaToI420(BYTE *luma, BYTE *blue, BYTE *red, const BYTE *source, LONG width, LONG height,
+							  bool flip)
+{
+	LONG chromaWidth = (width + 1) / 2;
+
+	for(LONG y = 0; y < height; y += 2)
+	{
+		// the last row counts twice when the height is odd
+		LONG next = y + 1 < height ? y + 1 : y;
+		const BYTE *top = source + (flip ? height - 1 - y : y) * width * 4;
+		const BYTE *bottom = source + (flip ? height - 1 - next : next) * width * 4;
+		BYTE *lumaTop = luma + y * width;
+		BYTE *lumaBottom = luma + next * width;
+		BYTE *blueRow = blue + y / 2 * chromaWidth;
+		BYTE *redRow = red + y / 2 * chromaWidth;
+		LONG x = 0;
+
+		for(; x + 1 < width; x += 2)
+		{
+			convertBlock(top + x * 4, top + x * 4 + 4, bottom + x * 4, bottom + x * 4 + 4,
+						 lumaTop + x, lumaBottom + x, blueRow[x / 2], redRow[x / 2]);
+		}
+
+		if(x < width)
+		{
+			// the last column counts twice when the width is odd
+			BYTE lumaPair[2][2];
+
+			convertBlock(top + x * 4, top + x * 4, bottom + x * 4, bottom + x * 4,
+						 lumaPair[0], lumaPair[1], blueRow[x / 2], redRow[x / 2]);
+			lumaTop[x] = lumaPair[0][0];
+			lumaBottom[x] = lumaPair[1][0];
+		}
+	}
+}
+
+void PixelConvert::setInstructionSet(InstructionSet instructionSet)
+{
+	InstructionSet supported = getSupportedInstructionSet();
+
+	PixelConvert::instructionSet = instructionSet < supported ? instructionSet : supported;
+
+	switch(PixelConvert::instructionSet)
+	{
+	case AVX2:
+		convertRow = convertRowAVX2;
+		break;
+	case SSSE3:
+		convertRow = convertRowSSSE3;
+		break;
+	default:
+		convertRow = convertRowScalar;
+		break;
+	}
+}
+
+PixelConvert::InstructionSet PixelConvert::getInstructionSet()
+{
+	if(convertRow == NULL)
+	{
+		setInstructionSet(getSupportedInstructionSet());
+	}
+
+	return instructionSet;
+}
+
+PixelConvert::InstructionSet PixelConvert::getSupportedInstructionSet()
+{
+	__builtin_cpu_init();
+
+	if(__builtin_cpu_supports("avx2"))
+	{
+		return AVX2;
+	}
+
+	if(__builtin_cpu_supports("ssse3"))
+	{
+		return SSSE3;
+	}
+
+	return SCALAR;
+}
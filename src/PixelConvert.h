@@ -0,0 +1,106 @@
+/*
+ * PixelConvert.h
+ *
+ * Conversion kernels turning the 32-bit BGRA rows stored in bitmaps into the
+ * tightly packed RGBA pixels OpenGL is given. Uses SSSE3 or AVX2 byte shuffles
+ * when the processor supports them, with a scalar fallback.
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifndef PIXELCONVERT_H_
+#define PIXELCONVERT_H_
+
+#include "ImageLoader.h"
+
+class PixelConvert
+{
+public:
+	enum InstructionSet
+	{
+		SCALAR,
+		SSSE3,
+		AVX2
+	};
+
+	/**
+	 * Converts BGRA pixels to RGBA and removes any padding at the end of the rows.
+	 * @param destination Receives width * height RGBA pixels without padding.
+	 * @param source The first row of BGRA pixels.
+	 * @param width Pixels per row.
+	 * @param height Number of rows.
+	 * @param sourceStride Bytes from the start of one source row to the next,
+	 *        at least width * 4.
+	 * @param flip Reverses the order of the rows, e.g. to turn a top-down bitmap
+	 *        into the bottom-up layout OpenGL expects.
+	 */
+	static void bgraToRgba(BYTE *destination, const BYTE *source, LONG width, LONG height,
+						   LONG sourceStride, bool flip);
+
+	/**
+	 * Converts a single row of BGRA pixels to RGBA. Source and destination may
+	 * be the same.
+	 */
+	static void bgraToRgbaRow(BYTE *destination, const BYTE *source, LONG width);
+
+	/**
+	 * Multiplies the colour channels of a row of 32-bit pixels by their alpha,
+	 * rounding to the nearest value. The alpha must be the fourth byte, the
+	 * order of the other three does not matter. Source and destination may be
+	 * the same.
+	 */
+	static void premultiplyRow(BYTE *destination, const BYTE *source, LONG width);
+
+	/**
+	 * Converts RGBA pixels to planar YUV 4:2:0 (I420) with the BT.601
+	 * coefficients in limited range, the layout video encoders take. Every
+	 * chroma sample is the average of a 2x2 block. Alpha is ignored.
+	 * @param luma Receives width * height samples.
+	 * @param blue, red Receive (width + 1) / 2 * (height + 1) / 2 samples each
+	 *        (U and V).
+	 * @param source width * height RGBA pixels without padding.
+	 * @param flip Reverses the order of the rows, e.g. to turn what
+	 *        glReadPixels returns into the top-down layout of video frames.
+	 */
+	static void rgbaToI420(BYTE *luma, BYTE *blue, BYTE *red, const BYTE *source, LONG width, LONG height,
+						   bool flip);
+
+	/**
+	 * Selects the kernel to use, mostly useful to compare them. By default the
+	 * best one supported by the processor is used; asking for an unsupported
+	 * one falls back to the best supported one.
+	 */
+	static void setInstructionSet(InstructionSet instructionSet);
+	static InstructionSet getInstructionSet();
+
+	/**
+	 * @return The best instruction set supported by this processor.
+	 */
+	static InstructionSet getSupportedInstructionSet();
+
+private:
+	typedef void (*RowFunction)(BYTE *destination, const BYTE *source, LONG width);
+
+	static RowFunction convertRow;
+	static InstructionSet instructionSet;
+
+	static bool selectDefault();
+};
+
+#endif /* PIXELCONVERT_H_ */
@@ -0,0 +1,342 @@
+/*
+ * Profiler.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+// timer queries are core since OpenGL 3.3 but only declared as extensions
+#define GL_GLEXT_PROTOTYPES
+
+#include <GL/glut.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "Profiler.h"
+
+// frames kept for the dump, about half an hour of frames at 60 fps
+#define MAX_FRAMES 100000
+// queries in flight, results are read this many frames later at the latest
+#define QUERY_COUNT 4
+
+static const char *sectionNames[] = { "display", "batch_draw", "layer_draw", "init_scene", "load_bmp" };
+
+vector<Profiler::Frame> Profiler::frames;
+long Profiler::framesDropped = 0;
+GLuint Profiler::queries[QUERY_COUNT];
+long Profiler::queryFrames[QUERY_COUNT];
+int Profiler::nextQuery = 0;
+int Profiler::timerQueries = -1;
+bool Profiler::queryActive = false;
+
+void Profiler::beginFrame(bool gpuTiming)
+{
+	memset(&current, 0, sizeof(current));
+	current.gpuSeconds = -1;
+	inFrame = true;
+
+	if(!gpuTiming)
+	{
+		return;
+	}
+
+	if(timerQueries < 0)
+	{
+		// timer queries are core since OpenGL 3.3
+		const char *version = (const char *)glGetString(GL_VERSION);
+		const char *extensions = (const char *)glGetString(GL_EXTENSIONS);
+		int major = 0;
+		int minor = 0;
+
+		if(version != NULL)
+		{
+			sscanf(version, "%d.%d", &major, &minor);
+		}
+
+		timerQueries = major > 3 || (major == 3 && minor >= 3) ||
+					   (extensions != NULL && strstr(extensions, "GL_ARB_timer_query") != NULL);
+
+		if(timerQueries)
+		{
+			glGenQueries(QUERY_COUNT, queries);
+
+			for(int i = 0; i < QUERY_COUNT; i++)
+			{
+				queryFrames[i] = -1;
+			}
+		}
+
+		// a query started before anything was drawn with the context reports
+		// nonsense on some drivers (e.g. Mesa llvmpipe), the first frame goes
+		// without a GPU time
+		return;
+	}
+
+	if(timerQueries)
+	{
+		// the query about to be reused has to be read first
+		if(queryFrames[nextQuery] >= 0)
+		{
+			collectQueries(true);
+		}
+
+		glBeginQuery(GL_TIME_ELAPSED, queries[nextQuery]);
+		queryActive = true;
+	}
+}
+
+void Profiler::endFrame(unsigned long bytesUploaded)
+{
+	if(!inFrame)
+	{
+		return;
+	}
+
+	long frameNumber = framesDropped + frames.size();
+
+	if(queryActive)
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+		queryFrames[nextQuery] = frameNumber;
+		nextQuery = (nextQuery + 1) % QUERY_COUNT;
+		queryActive = false;
+	}
+
+	current.bytesUploaded = bytesUploaded;
+	inFrame = false;
+
+	if(frames.size() >= MAX_FRAMES)
+	{
+		// drop the older half at once rather than one frame every frame
+		frames.erase(frames.begin(), frames.begin() + MAX_FRAMES / 2);
+		framesDropped += MAX_FRAMES / 2;
+	}
+
+	frames.push_back(current);
+
+	if(timerQueries > 0)
+	{
+		collectQueries(false);
+	}
+}
+
+void Profiler::collectQueries(bool wait)
+{
+	for(int i = 0; i < QUERY_COUNT; i++)
+	{
+		if(queryFrames[i] < 0)
+		{
+			continue;
+		}
+
+		GLuint available = GL_TRUE;
+
+		if(!wait)
+		{
+			glGetQueryObjectuiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+		}
+
+		if(!available)
+		{
+			continue;
+		}
+
+		GLuint64 nanoseconds = 0;
+		glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &nanoseconds);
+
+		long index = queryFrames[i] - framesDropped;
+
+		if(index >= 0 && index < (long)frames.size())
+		{
+			frames[index].gpuSeconds = nanoseconds / 1e9;
+		}
+
+		queryFrames[i] = -1;
+	}
+}
+
+void Profiler::countDrawCalls(unsigned int count)
+{
+	current.drawCalls += count;
+}
+
+void Profiler::countStateChanges(unsigned int count)
+{
+	current.stateChanges += count;
+}
+
+void Profiler::finish()
+{
+	if(timerQueries > 0)
+	{
+		collectQueries(true);
+	}
+}
+
+const vector<Profiler::Frame> &Profiler::getFrames()
+{
+	return frames;
+}
+
+const Profiler::Frame *Profiler::getLastCompleteFrame()
+{
+	for(size_t i = frames.size(); i > 0; i--)
+	{
+		if(frames[i - 1].gpuSeconds >= 0 || timerQueries <= 0)
+		{
+			return &frames[i - 1];
+		}
+	}
+
+	return NULL;
+}
+
+void Profiler::describe(const Frame &frame, vector<string> &lines)
+{
+	char line[128];
+
+	lines.clear();
+
+	if(frame.gpuSeconds >= 0)
+	{
+		snprintf(line, sizeof(line), "frame %.2fms cpu, %.2fms gpu", frame.cpuSeconds[DISPLAY] * 1000,
+				 frame.gpuSeconds * 1000);
+	}
+	else
+	{
+		snprintf(line, sizeof(line), "frame %.2fms cpu, gpu n/a", frame.cpuSeconds[DISPLAY] * 1000);
+	}
+
+	lines.push_back(line);
+
+	for(int i = BATCH_DRAW; i < SECTION_COUNT; i++)
+	{
+		if(frame.calls[i] > 0)
+		{
+			snprintf(line, sizeof(line), "%s %.2fms x%u", sectionNames[i], frame.cpuSeconds[i] * 1000, frame.calls[i]);
+			lines.push_back(line);
+		}
+	}
+
+	snprintf(line, sizeof(line), "%u draw calls, %u state changes", frame.drawCalls, frame.stateChanges);
+	lines.push_back(line);
+
+	snprintf(line, sizeof(line), "%lu bytes uploaded", frame.bytesUploaded);
+	lines.push_back(line);
+}
+
+bool Profiler::writeJSON(const char *fileName)
+{
+	FILE *file = fopen(fileName, "w");
+
+	if(file == NULL)
+	{
+		printf("Error: cannot write %s\n", fileName);
+		return false;
+	}
+
+	fprintf(file, "{\n  \"sections\": {");
+
+	for(int i = 0; i < SECTION_COUNT; i++)
+	{
+		fprintf(file, "%s\n    \"%s\": { \"calls\": %lu, \"cpu_ms\": %.4f }", i > 0 ? "," : "",
+				sectionNames[i], totalCalls[i], totalSeconds[i] * 1000);
+	}
+
+	fprintf(file, "\n  },\n  \"frames\": [");
+
+	for(size_t i = 0; i < frames.size(); i++)
+	{
+		const Frame &frame = frames[i];
+
+		fprintf(file, "%s\n    { \"frame\": %ld", i > 0 ? "," : "", framesDropped + (long)i);
+
+		for(int j = 0; j < SECTION_COUNT; j++)
+		{
+			fprintf(file, ", \"%s_ms\": %.4f, \"%s_calls\": %u", sectionNames[j], frame.cpuSeconds[j] * 1000,
+					sectionNames[j], frame.calls[j]);
+		}
+
+		if(frame.gpuSeconds >= 0)
+		{
+			fprintf(file, ", \"gpu_ms\": %.4f", frame.gpuSeconds * 1000);
+		}
+		else
+		{
+			fprintf(file, ", \"gpu_ms\": null");
+		}
+
+		fprintf(file, ", \"bytes_uploaded\": %lu, \"draw_calls\": %u, \"state_changes\": %u }",
+				frame.bytesUploaded, frame.drawCalls, frame.stateChanges);
+	}
+
+	fprintf(file, "\n  ]\n}\n");
+
+	return fclose(file) == 0;
+}
+
+bool Profiler::writeCSV(const char *fileName)
+{
+	FILE *file = fopen(fileName, "w");
+
+	if(file == NULL)
+	{
+		printf("Error: cannot write %s\n", fileName);
+		return false;
+	}
+
+	fprintf(file, "frame");
+
+	for(int i = 0; i < SECTION_COUNT; i++)
+	{
+		fprintf(file, ",%s_ms,%s_calls", sectionNames[i], sectionNames[i]);
+	}
+
+	fprintf(file, ",gpu_ms,bytes_uploaded,draw_calls,state_changes\n");
+
+	for(size_t i = 0; i < frames.size(); i++)
+	{
+		const Frame &frame = frames[i];
+
+		fprintf(file, "%ld", framesDropped + (long)i);
+
+		for(int j = 0; j < SECTION_COUNT; j++)
+		{
+			fprintf(file, ",%.4f,%u", frame.cpuSeconds[j] * 1000, frame.calls[j]);
+		}
+
+		// an empty field when the GPU time is unknown
+		if(frame.gpuSeconds >= 0)
+		{
+			fprintf(file, ",%.4f", frame.gpuSeconds * 1000);
+		}
+		else
+		{
+			fprintf(file, ",");
+		}
+
+		fprintf(file, ",%lu,%u,%u\n", frame.bytesUploaded, frame.drawCalls, frame.stateChanges);
+	}
+
+	return fclose(file) == 0;
+}
+
+const char *Profiler::getSectionName(Section section)
+{
+	return sectionNames[section];
+}
@@ -0,0 +1,117 @@
+/*
+ * Profiler.h
+ *
+ * Shows where the time of a frame goes. Sections of code are timed on the
+ * CPU with a Profiler::Scope, the whole frame is timed on the GPU with
+ * GL_TIME_ELAPSED queries where the driver has them, and the drawing code
+ * counts its draw calls and state changes. Every frame between beginFrame()
+ * and endFrame() becomes a record, together with the texture bytes uploaded
+ * during it, and the records can be written out as JSON or CSV.
+ *
+ * Sections also run outside of frames, e.g. loading the images before the
+ * first one. Their totals are kept for the whole run. Frames are recorded on
+ * the main thread; sections timed on other threads (e.g. the AssetLoader's
+ * workers) only count towards the totals once the main thread adds them with
+ * addThreadTimes(). The sections and their Scope come from CpuProfiler,
+ * which code built without GL uses on its own.
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <GL/glut.h>
+#include <string>
+#include <vector>
+#include "CpuProfiler.h"
+
+using namespace std;
+
+class Profiler : public CpuProfiler
+{
+public:
+	/**
+	 * Starts recording a frame. With a GL context current the frame is also
+	 * timed on the GPU if the driver supports timer queries.
+	 */
+	static void beginFrame(bool gpuTiming);
+
+	/**
+	 * Finishes the frame started by beginFrame().
+	 * @param bytesUploaded Texture bytes uploaded during the frame, from
+	 *        TextureCache::getFrameBytesUploaded().
+	 */
+	static void endFrame(unsigned long bytesUploaded);
+
+	static void countDrawCalls(unsigned int count);
+	static void countStateChanges(unsigned int count);
+
+	/**
+	 * Waits for the GPU times of all recorded frames. The GL context they
+	 * were recorded with must still be current.
+	 */
+	static void finish();
+
+	/**
+	 * @return The frames recorded so far, oldest first. Only the most recent
+	 *         ones are kept on long runs.
+	 */
+	static const vector<Frame> &getFrames();
+
+	/**
+	 * @return The latest frame whose GPU time is known, or the latest frame
+	 *         without timer queries. NULL before the first frame.
+	 */
+	static const Frame *getLastCompleteFrame();
+
+	/**
+	 * Describes a frame in a few lines of text, e.g. for an overlay.
+	 */
+	static void describe(const Frame &frame, vector<string> &lines);
+
+	/**
+	 * Writes the section totals and every recorded frame.
+	 * @return False if the file cannot be written.
+	 */
+	static bool writeJSON(const char *fileName);
+
+	/**
+	 * Writes one line per recorded frame, with a header line.
+	 * @return False if the file cannot be written.
+	 */
+	static bool writeCSV(const char *fileName);
+
+	static const char *getSectionName(Section section);
+
+private:
+	static vector<Frame> frames;
+	static long framesDropped;
+
+	// timer queries, reused round robin so reading a result rarely waits
+	static GLuint queries[];
+	static long queryFrames[];
+	static int nextQuery;
+	static int timerQueries; // -1 unknown, 0 unsupported, 1 supported
+	static bool queryActive;
+
+	static void collectQueries(bool wait);
+};
+
+#endif /* PROFILER_H_ */
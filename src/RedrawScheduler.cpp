@@ -0,0 +1,190 @@
+/*
+ * RedrawScheduler.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <GL/glut.h>
+#include <GL/glx.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <time.h>
+#include "RedrawScheduler.h"
+
+// GLUT timers fire with millisecond precision, wake up a little after the
+// boundary so the new second has really started
+static const unsigned int TIMER_SLACK = 1; // in milliseconds
+
+static double secondsSince(clockid_t clock)
+{
+	struct timespec now;
+	clock_gettime(clock, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+long long RedrawScheduler::interval = 1000000000LL;
+void (*RedrawScheduler::tickFunc)(void) = NULL;
+unsigned int RedrawScheduler::wakeups = 0;
+unsigned int RedrawScheduler::wakeupsPerSecond = 0;
+double RedrawScheduler::windowStart = 0;
+double RedrawScheduler::windowCpuStart = 0;
+double RedrawScheduler::cpuUsage = 0;
+
+void RedrawScheduler::start(double intervalMillis, void (*tick)(void))
+{
+	// in nanoseconds, so 1000 / 60 ms does not become 16 ms, i.e. 62.5 fps
+	interval = std::max(1000000LL, llround(intervalMillis * 1e6));
+	tickFunc = tick;
+
+	windowStart = secondsSince(CLOCK_MONOTONIC);
+	windowCpuStart = getCpuSeconds();
+
+	tickFunc();
+	scheduleNext();
+}
+
+bool RedrawScheduler::startVsync(void (*tick)(void))
+{
+	if(!setSwapInterval(1))
+	{
+		return false;
+	}
+
+	tickFunc = tick;
+
+	windowStart = secondsSince(CLOCK_MONOTONIC);
+	windowCpuStart = getCpuSeconds();
+
+	tickFunc();
+	glutIdleFunc(onIdle);
+
+	return true;
+}
+
+bool RedrawScheduler::setSwapInterval(int interval)
+{
+	typedef void (*SwapIntervalEXT)(Display *display, GLXDrawable drawable, int interval);
+	typedef int (*SwapInterval)(int interval);
+
+	// the same thing under three names, depending on the driver
+	SwapIntervalEXT swapIntervalEXT = (SwapIntervalEXT)glXGetProcAddressARB((const GLubyte *)"glXSwapIntervalEXT");
+	SwapInterval swapIntervalMESA = (SwapInterval)glXGetProcAddressARB((const GLubyte *)"glXSwapIntervalMESA");
+	SwapInterval swapIntervalSGI = (SwapInterval)glXGetProcAddressARB((const GLubyte *)"glXSwapIntervalSGI");
+	Display *display = glXGetCurrentDisplay();
+
+	if(display == NULL)
+	{
+		return false;
+	}
+
+	const char *extensions = glXQueryExtensionsString(display, DefaultScreen(display));
+
+	if(extensions == NULL)
+	{
+		return false;
+	}
+
+	if(swapIntervalEXT != NULL && strstr(extensions, "GLX_EXT_swap_control") != NULL)
+	{
+		swapIntervalEXT(display, glXGetCurrentDrawable(), interval);
+		return true;
+	}
+
+	if(swapIntervalMESA != NULL && strstr(extensions, "GLX_MESA_swap_control") != NULL)
+	{
+		return swapIntervalMESA(interval) == 0;
+	}
+
+	if(swapIntervalSGI != NULL && strstr(extensions, "GLX_SGI_swap_control") != NULL)
+	{
+		return swapIntervalSGI(interval) == 0;
+	}
+
+	return false;
+}
+
+void RedrawScheduler::onIdle()
+{
+	// glutSwapBuffers() blocks until the next vertical blank, which paces this
+	wakeups++;
+	updateStatistics();
+
+	tickFunc();
+}
+
+void RedrawScheduler::scheduleNext()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+
+	// the next multiple of the interval since the epoch. That keeps the ticks
+	// on whole seconds for intervals that divide or are multiples of a second,
+	// and the timer's rounding to milliseconds does not add up from one tick to
+	// the next
+	long long nanos = now.tv_sec * 1000000000LL + now.tv_nsec;
+	long long next = (nanos / interval + 1) * interval;
+	unsigned int delay = (next - nanos + 999999) / 1000000;
+
+	glutTimerFunc(delay + TIMER_SLACK, onTimer, 0);
+}
+
+void RedrawScheduler::onTimer(int value)
+{
+	wakeups++;
+	updateStatistics();
+
+	tickFunc();
+	scheduleNext();
+}
+
+void RedrawScheduler::updateStatistics()
+{
+	double now = secondsSince(CLOCK_MONOTONIC);
+	double elapsed = now - windowStart;
+
+	if(elapsed < 1.0)
+	{
+		return;
+	}
+
+	double cpu = getCpuSeconds();
+
+	wakeupsPerSecond = (unsigned int)(wakeups / elapsed + 0.5);
+	cpuUsage = (cpu - windowCpuStart) / elapsed;
+
+	wakeups = 0;
+	windowStart = now;
+	windowCpuStart = cpu;
+}
+
+unsigned int RedrawScheduler::getWakeupsPerSecond()
+{
+	return wakeupsPerSecond;
+}
+
+double RedrawScheduler::getCpuUsage()
+{
+	return cpuUsage;
+}
+
+double RedrawScheduler::getCpuSeconds()
+{
+	return secondsSince(CLOCK_PROCESS_CPUTIME_ID);
+}
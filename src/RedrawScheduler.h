@@ -0,0 +1,88 @@
+/*
+ * RedrawScheduler.h
+ *
+ * Wakes the program up only when the clock has to change instead of polling
+ * from the GLUT idle callback. Ticks are aligned to the wall clock, so with
+ * an interval of one second the program sleeps until the next second starts.
+ * A sweeping clock can instead be woken up once per refresh of the display.
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifndef REDRAWSCHEDULER_H_
+#define REDRAWSCHEDULER_H_
+
+class RedrawScheduler
+{
+public:
+	/**
+	 * Calls tick right away and then every time the wall clock crosses a multiple
+	 * of the given interval, using glutTimerFunc. A window must exist.
+	 * @param intervalMillis 1000 to tick once per second, smaller values to tick
+	 *        several times per second (e.g. 1000.0 / 60 for a sweeping second
+	 *        hand). Need not be a whole number of milliseconds.
+	 * @param tick Called on every tick, usually updates the scene and calls
+	 *        glutPostRedisplay().
+	 */
+	static void start(double intervalMillis, void (*tick)(void));
+
+	/**
+	 * Calls tick once per refresh of the display instead, for animations that
+	 * change every frame: turns vsync on so glutSwapBuffers() waits for the
+	 * vertical blank, and ticks whenever GLUT is idle. A window must exist.
+	 * @return False if the driver cannot sync to the display, in which case
+	 *         nothing is started.
+	 */
+	static bool startVsync(void (*tick)(void));
+
+	/**
+	 * @return Number of timer wakeups during the last full second.
+	 */
+	static unsigned int getWakeupsPerSecond();
+
+	/**
+	 * @return CPU time used by the process during the last full second as a
+	 *         fraction of one core, e.g. 0.01 for 1%.
+	 */
+	static double getCpuUsage();
+
+	/**
+	 * @return Total CPU time used by the process so far, in seconds.
+	 */
+	static double getCpuSeconds();
+
+private:
+	static long long interval; // nanoseconds
+	static void (*tickFunc)(void);
+
+	// statistics
+	static unsigned int wakeups;
+	static unsigned int wakeupsPerSecond;
+	static double windowStart;
+	static double windowCpuStart;
+	static double cpuUsage;
+
+	static void onTimer(int value);
+	static void onIdle();
+	static bool setSwapInterval(int interval);
+	static void scheduleNext();
+	static void updateStatistics();
+};
+
+#endif /* REDRAWSCHEDULER_H_ */
@@ -0,0 +1,1091 @@
+/*
+ * RenderService.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <GL/glut.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sstream>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "RenderService.h"
+#include "ClockWall.h"
+#include "HeadlessContext.h"
+#include "SoftwareRenderer.h"
+#include "Sprite.h"
+#include "SpriteBatch.h"
+#include "TimeZone.h"
+
+// requests with longer headers are refused
+#define MAX_REQUEST_SIZE 8192
+#define SECONDS_PER_DAY (24 * 60 * 60)
+
+static double now()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+static void setNonBlocking(int fd)
+{
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+/**
+ * Decodes %XX escapes and + in a query string.
+ */
+static string decodeURL(const string &text)
+{
+	string decoded;
+
+	for(size_t i = 0; i < text.size(); i++)
+	{
+		if(text[i] == '%' && i + 2 < text.size() && isxdigit((unsigned char)text[i + 1]) &&
+		   isxdigit((unsigned char)text[i + 2]))
+		{
+			decoded += (char)strtol(text.substr(i + 1, 2).c_str(), NULL, 16);
+			i += 2;
+		}
+		else
+		{
+			decoded += text[i] == '+' ? ' ' : text[i];
+		}
+	}
+
+	return decoded;
+}
+
+static const char *getStatusText(int status)
+{
+	switch(status)
+	{
+	case 200:
+		return "OK";
+	case 400:
+		return "Bad Request";
+	case 404:
+		return "Not Found";
+	case 405:
+		return "Method Not Allowed";
+	case 431:
+		return "Request Header Fields Too Large";
+	case 503:
+		return "Service Unavailable";
+	default:
+		return "Internal Server Error";
+	}
+}
+
+bool RenderService::Key::operator<(const Key &other) const
+{
+	for(int i = 0; i < 3; i++)
+	{
+		if(rotations[i] != other.rotations[i])
+		{
+			return rotations[i] < other.rotations[i];
+		}
+	}
+
+	if(width != other.width)
+	{
+		return width < other.width;
+	}
+
+	if(height != other.height)
+	{
+		return height < other.height;
+	}
+
+	return skin < other.skin;
+}
+
+RenderService::RenderService(int threads, bool software, int maxWidth, int maxHeight, size_t cacheBytes,
+							 int maxPending)
+{
+	// there is a single GL context
+	threadCount = software ? max(1, threads) : 1;
+	this->software = software;
+	this->maxWidth = maxWidth;
+	this->maxHeight = maxHeight;
+	this->maxPending = max(1, maxPending);
+	listenFd = -1;
+	stopRequested = 0;
+	nextConnection = 0;
+	this->cacheBytes = 0;
+	cacheLimit = cacheBytes;
+	workersStarted = 0;
+	workersFailed = false;
+	stopping = false;
+	requests = 0;
+	hits = 0;
+	misses = 0;
+	joined = 0;
+	rejected = 0;
+	renders = 0;
+	batches = 0;
+	renderSeconds = 0;
+
+	if(pipe(wakePipe) != 0)
+	{
+		perror("Error");
+		wakePipe[0] = -1;
+		wakePipe[1] = -1;
+	}
+	else
+	{
+		setNonBlocking(wakePipe[0]);
+		setNonBlocking(wakePipe[1]);
+	}
+}
+
+RenderService::~RenderService()
+{
+	while(!connections.empty())
+	{
+		close(connections.begin()->first);
+	}
+
+	for(map<Key, Job *>::iterator it = rendering.begin(); it != rendering.end(); ++it)
+	{
+		delete it->second;
+	}
+
+	if(listenFd >= 0)
+	{
+		::close(listenFd);
+	}
+
+	if(!socketPath.empty())
+	{
+		unlink(socketPath.c_str());
+	}
+
+	if(wakePipe[0] >= 0)
+	{
+		::close(wakePipe[0]);
+		::close(wakePipe[1]);
+	}
+}
+
+void RenderService::addSkin(const string &name, Sprite *const sprites[4])
+{
+	skinNames.push_back(name);
+	skins.insert(skins.end(), sprites, sprites + 4);
+}
+
+bool RenderService::listen(const string &address)
+{
+	if(address.find('/') != string::npos)
+	{
+		struct sockaddr_un local;
+		struct stat status;
+
+		if(address.size() >= sizeof(local.sun_path))
+		{
+			printf("Error: the socket path %s is too long\n", address.c_str());
+			return false;
+		}
+
+		// a socket left behind by an earlier run
+		if(stat(address.c_str(), &status) == 0 && S_ISSOCK(status.st_mode))
+		{
+			unlink(address.c_str());
+		}
+
+		memset(&local, 0, sizeof(local));
+		local.sun_family = AF_UNIX;
+		strcpy(local.sun_path, address.c_str());
+
+		listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+		if(listenFd < 0 || bind(listenFd, (struct sockaddr *)&local, sizeof(local)) != 0)
+		{
+			perror(address.c_str());
+			return false;
+		}
+
+		socketPath = address;
+	}
+	else
+	{
+		size_t colon = address.rfind(':');
+		string host = colon != string::npos ? address.substr(0, colon) : "127.0.0.1";
+		int port = atoi(address.c_str() + (colon != string::npos ? colon + 1 : 0));
+		struct sockaddr_in local;
+		int reuse = 1;
+
+		memset(&local, 0, sizeof(local));
+		local.sin_family = AF_INET;
+		local.sin_port = htons(port);
+
+		if(port <= 0 || port > 65535 || inet_pton(AF_INET, host.c_str(), &local.sin_addr) != 1)
+		{
+			printf("Error: cannot listen on %s, expected a path, a port or host:port\n", address.c_str());
+			return false;
+		}
+
+		listenFd = socket(AF_INET, SOCK_STREAM, 0);
+
+		if(listenFd >= 0)
+		{
+			setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+		}
+
+		if(listenFd < 0 || bind(listenFd, (struct sockaddr *)&local, sizeof(local)) != 0)
+		{
+			perror(address.c_str());
+			return false;
+		}
+	}
+
+	if(::listen(listenFd, SOMAXCONN) != 0)
+	{
+		perror(address.c_str());
+		return false;
+	}
+
+	setNonBlocking(listenFd);
+
+	return true;
+}
+
+void RenderService::stop()
+{
+	stopRequested = 1;
+
+	// only async signal safe calls from here on
+	if(wakePipe[1] >= 0 && write(wakePipe[1], "", 1) < 0)
+	{
+		// the pipe is full, poll() wakes up anyway
+	}
+}
+
+bool RenderService::run()
+{
+	if(listenFd < 0 || wakePipe[0] < 0 || skins.empty())
+	{
+		return false;
+	}
+
+	// the copies touch TextureCache, which only this thread may
+	for(int i = 0; i < threadCount; i++)
+	{
+		Worker *worker = new Worker();
+
+		worker->renderer = NULL;
+		worker->context = NULL;
+		worker->spriteBatch = NULL;
+
+		for(size_t j = 0; j < skins.size(); j++)
+		{
+			worker->sprites.push_back(new Sprite(*skins[j]));
+		}
+
+		workers.push_back(worker);
+	}
+
+	for(int i = 0; i < threadCount; i++)
+	{
+		workers[i]->runner = thread(&RenderService::work, this, workers[i]);
+	}
+
+	{
+		unique_lock<mutex> guard(lock);
+
+		while(workersStarted < threadCount && !workersFailed)
+		{
+			workerStarted.wait(guard);
+		}
+	}
+
+	vector<struct pollfd> fds;
+	vector<long> ids;
+
+	while(!stopRequested && !workersFailed)
+	{
+		struct pollfd listening = { listenFd, POLLIN, 0 };
+		struct pollfd woken = { wakePipe[0], POLLIN, 0 };
+
+		fds.assign(1, listening);
+		fds.push_back(woken);
+		ids.assign(2, -1);
+
+		for(map<long, Connection>::iterator it = connections.begin(); it != connections.end(); ++it)
+		{
+			const Connection &connection = it->second;
+			struct pollfd fd = { connection.fd, 0, 0 };
+
+			if(connection.body != NULL || !connection.header.empty())
+			{
+				fd.events = POLLOUT;
+			}
+			else if(!connection.waiting)
+			{
+				fd.events = POLLIN;
+			}
+
+			fds.push_back(fd);
+			ids.push_back(it->first);
+		}
+
+		if(poll(&fds[0], fds.size(), -1) < 0)
+		{
+			if(errno != EINTR)
+			{
+				perror("Error");
+				break;
+			}
+
+			continue;
+		}
+
+		if(fds[1].revents != 0)
+		{
+			char buffer[64];
+
+			while(read(wakePipe[0], buffer, sizeof(buffer)) > 0)
+			{
+			}
+
+			finishJobs();
+		}
+
+		for(size_t i = 2; i < fds.size(); i++)
+		{
+			bool open = true;
+
+			// answering a finished render may have closed it already
+			if(connections.count(ids[i]) == 0)
+			{
+				continue;
+			}
+
+			if(fds[i].revents & (POLLERR | POLLNVAL))
+			{
+				open = false;
+			}
+			else if(fds[i].revents & POLLOUT)
+			{
+				open = send(ids[i]);
+			}
+			else if(fds[i].revents & (POLLIN | POLLHUP))
+			{
+				open = receive(ids[i]);
+			}
+
+			if(!open)
+			{
+				close(ids[i]);
+			}
+		}
+
+		if(fds[0].revents & POLLIN)
+		{
+			accept();
+		}
+	}
+
+	{
+		unique_lock<mutex> guard(lock);
+		stopping = true;
+		jobQueued.notify_all();
+	}
+
+	for(size_t i = 0; i < workers.size(); i++)
+	{
+		workers[i]->runner.join();
+
+		for(size_t j = 0; j < workers[i]->sprites.size(); j++)
+		{
+			delete workers[i]->sprites[j];
+		}
+
+		delete workers[i];
+	}
+
+	workers.clear();
+
+	// jobs nobody will render any more
+	for(size_t i = 0; i < queued.size(); i++)
+	{
+		rendering.erase(queued[i]->key);
+		delete queued[i];
+	}
+
+	queued.clear();
+	finishJobs();
+
+	return !workersFailed;
+}
+
+bool RenderService::startRenderer(Worker *worker)
+{
+	if(software)
+	{
+		return true;
+	}
+
+	// the context is current on the thread creating it
+	worker->context = new HeadlessContext(maxWidth, maxHeight);
+
+	if(!worker->context->isValid())
+	{
+		return false;
+	}
+
+	// the state init() in main.cpp sets up
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glClearColor(1.0, 1.0, 1.0, 0.0);
+	glShadeModel(GL_FLAT);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+	worker->spriteBatch = new SpriteBatch();
+
+	return true;
+}
+
+void RenderService::work(Worker *worker)
+{
+	bool started = startRenderer(worker);
+
+	{
+		unique_lock<mutex> guard(lock);
+
+		if(started)
+		{
+			workersStarted++;
+		}
+		else
+		{
+			workersFailed = true;
+		}
+
+		workerStarted.notify_all();
+	}
+
+	vector<Job *> batch;
+	vector<BYTE> pixels;
+
+	while(started)
+	{
+		batch.clear();
+
+		{
+			unique_lock<mutex> guard(lock);
+
+			while(queued.empty() && !stopping)
+			{
+				jobQueued.wait(guard);
+			}
+
+			if(stopping)
+			{
+				break;
+			}
+
+			while(!queued.empty() && batch.size() < RENDER_BATCH_SIZE)
+			{
+				batch.push_back(queued.front());
+				queued.pop_front();
+			}
+		}
+
+		// images of the same size and skin one after another, so the frame
+		// buffer or the viewport only changes between groups
+		for(size_t i = 1; i < batch.size(); i++)
+		{
+			for(size_t j = i; j > 0; j--)
+			{
+				const Key &a = batch[j - 1]->key;
+				const Key &b = batch[j]->key;
+
+				if(a.skin < b.skin || (a.skin == b.skin && (a.width < b.width ||
+				   (a.width == b.width && a.height <= b.height))))
+				{
+					break;
+				}
+
+				swap(batch[j - 1], batch[j]);
+			}
+		}
+
+		double start = now();
+
+		for(size_t i = 0; i < batch.size(); i++)
+		{
+			vector<BYTE> *image = new vector<BYTE>();
+
+			render(worker, batch[i]->key, pixels);
+			ImageLoader::encodeBMP(batch[i]->key.width, batch[i]->key.height, &pixels[0], *image);
+			batch[i]->image = Image(image);
+		}
+
+		{
+			unique_lock<mutex> guard(lock);
+
+			renders += batch.size();
+			batches++;
+			renderSeconds += now() - start;
+			finished.insert(finished.end(), batch.begin(), batch.end());
+		}
+
+		if(write(wakePipe[1], "", 1) < 0)
+		{
+			// the pipe is full, the IO thread wakes up anyway
+		}
+	}
+
+	// the vertex buffer goes with the context
+	delete worker->spriteBatch;
+	delete worker->renderer;
+	delete worker->context;
+}
+
+void RenderService::render(Worker *worker, const Key &key, vector<BYTE> &pixels)
+{
+	Sprite **sprites = &worker->sprites[key.skin * 4];
+	const ImageLoader *face = sprites[0]->getImage();
+	// the face fills the image
+	GLfloat scale = (GLfloat)min(key.width, key.height) / max(face->getWidth(), face->getHeight());
+
+	for(int i = 0; i < 4; i++)
+	{
+		sprites[i]->setScale(scale, scale);
+
+		if(i > 0)
+		{
+			sprites[i]->setRotation(*key.rotations[i - 1]);
+		}
+	}
+
+	pixels.resize(key.width * key.height * 4);
+
+	if(software)
+	{
+		if(worker->renderer == NULL || worker->renderer->getWidth() != key.width ||
+		   worker->renderer->getHeight() != key.height)
+		{
+			delete worker->renderer;
+			worker->renderer = new SoftwareRenderer(key.width, key.height);
+		}
+
+		// same colour as glClearColor in init()
+		worker->renderer->clear(255, 255, 255, 0);
+
+		for(int i = 0; i < 4; i++)
+		{
+			worker->renderer->draw(*sprites[i]);
+		}
+
+		memcpy(&pixels[0], worker->renderer->getPixels(), pixels.size());
+		return;
+	}
+
+	// the bottom left corner of the surface, set up like reshape() in main.cpp
+	glViewport(0, 0, key.width, key.height);
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glOrtho(-key.width/2, key.width/2, -key.height/2, key.height/2, -1.0, 1.0);
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	// the same quads as the headless clock draws, Sprite::draw() rounds the
+	// corners to whole pixels
+	worker->spriteBatch->begin();
+
+	for(int i = 0; i < 4; i++)
+	{
+		worker->spriteBatch->add(*sprites[i]);
+	}
+
+	worker->spriteBatch->flush();
+
+	glReadPixels(0, 0, key.width, key.height, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]);
+}
+
+void RenderService::accept()
+{
+	for(;;)
+	{
+		int fd = ::accept(listenFd, NULL, NULL);
+
+		if(fd < 0)
+		{
+			return;
+		}
+
+		setNonBlocking(fd);
+
+		Connection &connection = connections[nextConnection++];
+		connection.fd = fd;
+		connection.sent = 0;
+		connection.waiting = false;
+		connection.keepAlive = true;
+	}
+}
+
+void RenderService::close(long id)
+{
+	map<long, Connection>::iterator it = connections.find(id);
+
+	if(it != connections.end())
+	{
+		::close(it->second.fd);
+		connections.erase(it);
+	}
+}
+
+bool RenderService::receive(long id)
+{
+	Connection &connection = connections[id];
+	char buffer[4096];
+
+	for(;;)
+	{
+		ssize_t count = recv(connection.fd, buffer, sizeof(buffer), 0);
+
+		if(count > 0)
+		{
+			connection.input.append(buffer, count);
+			continue;
+		}
+
+		if(count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		{
+			break;
+		}
+
+		// closed by the client or failed
+		return false;
+	}
+
+	handleInput(id);
+
+	return true;
+}
+
+bool RenderService::send(long id)
+{
+	Connection &connection = connections[id];
+
+	while(!connection.header.empty() || connection.body != NULL)
+	{
+		struct iovec parts[2];
+		size_t headerLeft = connection.sent < connection.header.size() ? connection.header.size() - connection.sent : 0;
+		size_t bodyDone = connection.sent - (connection.header.size() - headerLeft);
+		int count = 0;
+
+		if(headerLeft > 0)
+		{
+			parts[count].iov_base = (void *)(connection.header.data() + connection.sent);
+			parts[count].iov_len = headerLeft;
+			count++;
+		}
+
+		if(connection.body != NULL && bodyDone < connection.body->size())
+		{
+			parts[count].iov_base = (void *)(&(*connection.body)[0] + bodyDone);
+			parts[count].iov_len = connection.body->size() - bodyDone;
+			count++;
+		}
+
+		if(count == 0)
+		{
+			// all sent
+			connection.header.clear();
+			connection.body.reset();
+			connection.sent = 0;
+
+			if(!connection.keepAlive)
+			{
+				return false;
+			}
+
+			// requests sent without waiting for this response
+			handleInput(id);
+			return true;
+		}
+
+		struct msghdr message;
+		memset(&message, 0, sizeof(message));
+		message.msg_iov = parts;
+		message.msg_iovlen = count;
+
+		// no SIGPIPE when the client went away
+		ssize_t sent = sendmsg(connection.fd, &message, MSG_NOSIGNAL);
+
+		if(sent < 0)
+		{
+			return errno == EAGAIN || errno == EWOULDBLOCK;
+		}
+
+		connection.sent += sent;
+	}
+
+	return true;
+}
+
+void RenderService::handleInput(long id)
+{
+	Connection &connection = connections[id];
+
+	if(connection.waiting || !connection.header.empty())
+	{
+		return;
+	}
+
+	size_t end = connection.input.find("\r\n\r\n");
+
+	if(end == string::npos)
+	{
+		if(connection.input.size() > MAX_REQUEST_SIZE)
+		{
+			connection.keepAlive = false;
+			respond(id, 431, "request too large\n");
+		}
+
+		return;
+	}
+
+	string request = connection.input.substr(0, end);
+	connection.input.erase(0, end + 4);
+
+	istringstream lines(request);
+	string line, method, target, version;
+
+	getline(lines, line);
+	istringstream(line) >> method >> target >> version;
+
+	// HTTP/1.1 keeps the connection open unless told otherwise, 1.0 the
+	// other way round
+	connection.keepAlive = version == "HTTP/1.1";
+
+	while(getline(lines, line))
+	{
+		transform(line.begin(), line.end(), line.begin(), ::tolower);
+
+		if(line.compare(0, 11, "connection:") == 0)
+		{
+			connection.keepAlive = line.find("keep-alive") != string::npos ||
+								   (connection.keepAlive && line.find("close") == string::npos);
+		}
+	}
+
+	requests++;
+
+	if(method != "GET")
+	{
+		connection.keepAlive = false;
+		respond(id, 405, "only GET is supported\n");
+		return;
+	}
+
+	size_t question = target.find('?');
+	string path = target.substr(0, question);
+	map<string, string> parameters;
+
+	if(question != string::npos)
+	{
+		istringstream query(target.substr(question + 1));
+		string pair;
+
+		while(getline(query, pair, '&'))
+		{
+			size_t equals = pair.find('=');
+
+			if(equals != string::npos)
+			{
+				parameters[decodeURL(pair.substr(0, equals))] = decodeURL(pair.substr(equals + 1));
+			}
+		}
+	}
+
+	if(path == "/clock")
+	{
+		handleClock(id, parameters);
+	}
+	else if(path == "/stats")
+	{
+		string stats = getStats();
+		respond(id, 200, "application/json", Image(new vector<BYTE>(stats.begin(), stats.end())));
+	}
+	else
+	{
+		respond(id, 404, "try /clock?time=unix-seconds&zone=Europe/Paris&size=256x256\n");
+	}
+}
+
+void RenderService::handleClock(long id, const map<string, string> &parameters)
+{
+	const ImageLoader *face = skins[0]->getImage();
+	Key key;
+	time_t unixTime = time(NULL);
+	// the system's zone
+	const TimeZone *zone = TimeZone::get("");
+
+	key.width = min(maxWidth, (int)face->getWidth());
+	key.height = min(maxHeight, (int)face->getHeight());
+	key.skin = 0;
+
+	for(map<string, string>::const_iterator it = parameters.begin(); it != parameters.end(); ++it)
+	{
+		const string &value = it->second;
+
+		if(it->first == "time")
+		{
+			char *end;
+			unixTime = strtol(value.c_str(), &end, 10);
+
+			if(value.empty() || *end != '\0')
+			{
+				respond(id, 400, "time is in seconds since 1970\n");
+				return;
+			}
+		}
+		else if(it->first == "zone")
+		{
+			// names of the zoneinfo directory or POSIX TZ strings, never files
+			if(value.size() > 64 || value.find_first_not_of("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"
+															 "0123456789/_+-:,.<>") != string::npos)
+			{
+				respond(id, 400, "not a timezone\n");
+				return;
+			}
+
+			zone = TimeZone::find(value);
+
+			if(zone == NULL)
+			{
+				respond(id, 400, "unknown timezone\n");
+				return;
+			}
+		}
+		else if(it->first == "size")
+		{
+			int width, height;
+			char extra;
+			int count = sscanf(value.c_str(), "%dx%d%c", &width, &height, &extra);
+
+			if(count == 1)
+			{
+				height = width;
+			}
+
+			if((count != 1 && count != 2) || width < 1 || height < 1 || width > maxWidth || height > maxHeight)
+			{
+				char message[64];
+				snprintf(message, sizeof(message), "size is WxH, at most %dx%d\n", maxWidth, maxHeight);
+				respond(id, 400, message);
+				return;
+			}
+
+			key.width = width;
+			key.height = height;
+		}
+		else if(it->first == "skin")
+		{
+			vector<string>::iterator skin = find(skinNames.begin(), skinNames.end(), value);
+
+			if(skin == skinNames.end())
+			{
+				respond(id, 404, "no such skin\n");
+				return;
+			}
+
+			key.skin = skin - skinNames.begin();
+		}
+	}
+
+	long seconds = (unixTime + zone->getOffset(unixTime)) % SECONDS_PER_DAY;
+
+	if(seconds < 0)
+	{
+		seconds += SECONDS_PER_DAY;
+	}
+
+	ClockWall::getRotations(seconds / 3600, seconds / 60 % 60, seconds % 60, key.rotations);
+
+	Image image = lookup(key);
+
+	if(image != NULL)
+	{
+		hits++;
+		respond(id, 200, "image/bmp", image, "hit");
+		return;
+	}
+
+	map<Key, Job *>::iterator running = rendering.find(key);
+
+	if(running != rendering.end())
+	{
+		joined++;
+		running->second->waiters.push_back(id);
+		connections[id].waiting = true;
+		return;
+	}
+
+	if((int)rendering.size() >= maxPending)
+	{
+		rejected++;
+		respond(id, 503, "too many images queued, try again later\n");
+		return;
+	}
+
+	Job *job = new Job();
+	job->key = key;
+	job->waiters.push_back(id);
+	rendering[key] = job;
+	connections[id].waiting = true;
+	misses++;
+
+	unique_lock<mutex> guard(lock);
+	queued.push_back(job);
+	jobQueued.notify_one();
+}
+
+void RenderService::finishJobs()
+{
+	deque<Job *> done;
+
+	{
+		unique_lock<mutex> guard(lock);
+		done.swap(finished);
+	}
+
+	for(size_t i = 0; i < done.size(); i++)
+	{
+		Job *job = done[i];
+
+		store(job->key, job->image);
+		rendering.erase(job->key);
+
+		for(size_t j = 0; j < job->waiters.size(); j++)
+		{
+			map<long, Connection>::iterator it = connections.find(job->waiters[j]);
+
+			// the client may have hung up in the meantime
+			if(it != connections.end())
+			{
+				it->second.waiting = false;
+				respond(job->waiters[j], 200, "image/bmp", job->image, "miss");
+			}
+		}
+
+		delete job;
+	}
+}
+
+void RenderService::respond(long id, int status, const string &text)
+{
+	respond(id, status, "text/plain", Image(new vector<BYTE>(text.begin(), text.end())));
+}
+
+void RenderService::respond(long id, int status, const string &type, Image body, const char *cacheState)
+{
+	Connection &connection = connections[id];
+	ostringstream header;
+
+	header << "HTTP/1.1 " << status << " " << getStatusText(status) << "\r\n"
+		   << "Content-Type: " << type << "\r\n"
+		   << "Content-Length: " << body->size() << "\r\n";
+
+	if(cacheState != NULL)
+	{
+		header << "X-Cache: " << cacheState << "\r\n";
+	}
+
+	header << "Connection: " << (connection.keepAlive ? "keep-alive" : "close") << "\r\n\r\n";
+
+	connection.header = header.str();
+	connection.body = body;
+	connection.sent = 0;
+
+	// most responses fit into the socket buffer right away
+	if(!send(id))
+	{
+		close(id);
+	}
+}
+
+RenderService::Image RenderService::lookup(const Key &key)
+{
+	map<Key, list<CacheEntry>::iterator>::iterator found = cacheIndex.find(key);
+
+	if(found == cacheIndex.end())
+	{
+		return Image();
+	}
+
+	// now the most recently used
+	cache.splice(cache.begin(), cache, found->second);
+
+	return found->second->image;
+}
+
+void RenderService::store(const Key &key, Image image)
+{
+	if(cacheIndex.count(key) > 0 || image->size() > cacheLimit)
+	{
+		return;
+	}
+
+	CacheEntry entry = { key, image };
+
+	cache.push_front(entry);
+	cacheIndex[key] = cache.begin();
+	cacheBytes += image->size();
+
+	while(cacheBytes > cacheLimit)
+	{
+		cacheBytes -= cache.back().image->size();
+		cacheIndex.erase(cache.back().key);
+		cache.pop_back();
+	}
+}
+
+string RenderService::getStats()
+{
+	ostringstream stats;
+	unique_lock<mutex> guard(lock);
+
+	stats << "{ \"requests\": " << requests << ", \"hits\": " << hits << ", \"misses\": " << misses
+		  << ", \"joined\": " << joined << ", \"rejected\": " << rejected << ", \"renders\": " << renders
+		  << ", \"batches\": " << batches << ", \"render_ms\": " << renderSeconds * 1000
+		  << ", \"cached_images\": " << cache.size() << ", \"cached_bytes\": " << cacheBytes
+		  << ", \"connections\": " << connections.size() << " }\n";
+
+	return stats.str();
+}
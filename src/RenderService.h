@@ -0,0 +1,243 @@
+/*
+ * RenderService.h
+ *
+ * Serves images of the clock over HTTP on a Unix socket or a port of the
+ * loopback interface, for dashboards that want "the clock at time T in zone
+ * Z, S pixels wide" without opening a window per image:
+ *
+ *   GET /clock?time=1700000000&zone=Europe/Paris&size=256x256&skin=default
+ *   GET /stats
+ *
+ * All parameters are optional: the time defaults to now, the zone to the
+ * system's, the size to that of the clock face and the skin to the first one
+ * added. Images come back as 32-bit bitmaps.
+ *
+ * A clock has far fewer faces than there are requests for it: the hands only
+ * take 43200 positions, so every image is kept in an LRU cache keyed by the
+ * positions of its hands (which sums up the time and the zone), its size and
+ * its skin. Requests that miss the cache are queued for the render threads,
+ * which take several at a time and draw those of the same size and skin
+ * together; requests for an image already being rendered wait for that one.
+ * At most maxPending images are queued, requests beyond that are turned away
+ * with "503 Service Unavailable" rather than piling up.
+ *
+ * Connections are handled by poll() on the thread calling run(), which also
+ * owns the cache, so only the queues between it and the render threads are
+ * locked.
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifndef RENDERSERVICE_H_
+#define RENDERSERVICE_H_
+
+#include <condition_variable>
+#include <csignal>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ImageLoader.h"
+
+using namespace std;
+
+class Sprite;
+class SoftwareRenderer;
+class SpriteBatch;
+class HeadlessContext;
+struct Rotation;
+
+// misses a render thread takes off the queue at once
+#define RENDER_BATCH_SIZE 16
+
+class RenderService
+{
+public:
+	/**
+	 * @param threads Render threads. OpenGL renders on a single thread, every
+	 *        thread of the software renderer has a frame buffer of its own.
+	 * @param software Renders on the CPU instead of with an EGL context.
+	 * @param maxWidth, maxHeight The largest image served, the size of the
+	 *        OpenGL surface.
+	 * @param cacheBytes Memory for the images kept in the cache.
+	 * @param maxPending Images queued for rendering at most.
+	 */
+	RenderService(int threads, bool software, int maxWidth, int maxHeight, size_t cacheBytes, int maxPending);
+
+	/**
+	 * Closes the socket and all connections.
+	 */
+	virtual ~RenderService();
+
+	/**
+	 * Adds images to draw the clock with, chosen with skin=name. The first
+	 * skin added is the default one.
+	 * @param sprites The face and the hours, minutes and seconds hands, with
+	 *        their pivots set up and placed at (0, 0). Every render thread
+	 *        draws copies of them; they must stay until run() returns.
+	 */
+	void addSkin(const string &name, Sprite *const sprites[4]);
+
+	/**
+	 * Opens the socket.
+	 * @param address The path of a Unix socket (anything with a /), or a TCP
+	 *        port, "port" for the loopback interface or "host:port".
+	 * @return False if the socket cannot be opened.
+	 */
+	bool listen(const string &address);
+
+	/**
+	 * Starts the render threads and serves requests until stop() is called.
+	 * @return False if the render threads cannot start, e.g. without EGL.
+	 */
+	bool run();
+
+	/**
+	 * Makes run() return. May be called from another thread or a signal
+	 * handler.
+	 */
+	void stop();
+
+	/**
+	 * @return The request counts and render times so far, as JSON.
+	 */
+	string getStats();
+
+private:
+	// what an image shows, everything else about a request is irrelevant
+	struct Key
+	{
+		const Rotation *rotations[3];
+		int width;
+		int height;
+		int skin;
+
+		bool operator<(const Key &other) const;
+	};
+
+	typedef shared_ptr<const vector<BYTE> > Image;
+
+	struct Job
+	{
+		Key key;
+		// connections waiting for the image
+		vector<long> waiters;
+		Image image;
+	};
+
+	struct Connection
+	{
+		int fd;
+		string input;
+		// the response being sent, header first
+		string header;
+		Image body;
+		size_t sent;
+		// a request is waiting for its image
+		bool waiting;
+		bool keepAlive;
+	};
+
+	struct CacheEntry
+	{
+		Key key;
+		Image image;
+	};
+
+	struct Worker
+	{
+		thread runner;
+		// four per skin
+		vector<Sprite *> sprites;
+		SoftwareRenderer *renderer;
+		HeadlessContext *context;
+		SpriteBatch *spriteBatch;
+	};
+
+	int threadCount;
+	bool software;
+	int maxWidth;
+	int maxHeight;
+	int maxPending;
+	vector<string> skinNames;
+	vector<Sprite *> skins;
+
+	int listenFd;
+	string socketPath;
+	// written to by stop() and by the render threads to wake up poll()
+	int wakePipe[2];
+	volatile sig_atomic_t stopRequested;
+
+	// only used by the thread calling run()
+	map<long, Connection> connections;
+	long nextConnection;
+	map<Key, Job *> rendering;
+	list<CacheEntry> cache; // most recently used first
+	map<Key, list<CacheEntry>::iterator> cacheIndex;
+	size_t cacheBytes;
+	size_t cacheLimit;
+
+	// shared with the render threads
+	mutex lock;
+	condition_variable jobQueued;
+	condition_variable workerStarted;
+	deque<Job *> queued;
+	deque<Job *> finished;
+	vector<Worker *> workers;
+	int workersStarted;
+	bool workersFailed;
+	bool stopping;
+
+	// counters
+	unsigned long requests;
+	unsigned long hits;
+	unsigned long misses;
+	unsigned long joined; // misses that waited for an image already queued
+	unsigned long rejected;
+	unsigned long renders;
+	unsigned long batches;
+	double renderSeconds;
+
+	void work(Worker *worker);
+	bool startRenderer(Worker *worker);
+	void render(Worker *worker, const Key &key, vector<BYTE> &pixels);
+
+	void accept();
+	bool receive(long id);
+	bool send(long id);
+	void close(long id);
+	void handleInput(long id);
+	void handleClock(long id, const map<string, string> &parameters);
+	void respond(long id, int status, const string &type, Image body, const char *cacheState = NULL);
+	void respond(long id, int status, const string &text);
+	void finishJobs();
+
+	Image lookup(const Key &key);
+	void store(const Key &key, Image image);
+
+	// the threads cannot be copied along with the service
+	RenderService(const RenderService &other);
+	RenderService &operator=(const RenderService &other);
+};
+
+#endif /* RENDERSERVICE_H_ */
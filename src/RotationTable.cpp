@@ -0,0 +1,83 @@
+/*
+ * RotationTable.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include "RotationTable.h"
+
+#define HALF_PI 1.57079632679489661923
+
+/**
+ * Taylor series of sine and cosine, accurate to double precision for
+ * 0 <= x < pi/2, the only range the tables need. std::sin() and std::cos()
+ * cannot be used in constant expressions.
+ */
+static constexpr double sineOf(double x)
+{
+	double term = x;
+	double sum = x;
+
+	for(int n = 1; n < 12; n++)
+	{
+		term *= -x * x / ((2 * n) * (2 * n + 1));
+		sum += term;
+	}
+
+	return sum;
+}
+
+static constexpr double cosineOf(double x)
+{
+	double term = 1;
+	double sum = 1;
+
+	for(int n = 1; n < 12; n++)
+	{
+		term *= -x * x / ((2 * n - 1) * (2 * n));
+		sum += term;
+	}
+
+	return sum;
+}
+
+template<int POSITIONS>
+constexpr RotationTable<POSITIONS>::RotationTable() : rotations()
+{
+	for(int i = 0; i < POSITIONS; i++)
+	{
+		// split the clockwise angle into whole quarter turns and the rest, so
+		// the quarter hours come out exact
+		int quarter = (long)i * 4 / POSITIONS;
+		double x = ((long)i * 4 % POSITIONS) * HALF_PI / POSITIONS;
+		double sine = sineOf(x);
+		double cosine = cosineOf(x);
+		double clockwiseCos[4] = { cosine, -sine, -cosine, sine };
+		double clockwiseSin[4] = { sine, cosine, -sine, -cosine };
+
+		rotations[i].degrees = -360.0 * i / POSITIONS;
+		rotations[i].cosAngle = clockwiseCos[quarter];
+		// turning clockwise is a negative angle
+		rotations[i].sinAngle = -clockwiseSin[quarter];
+	}
+}
+
+constexpr RotationTable<60> secondRotations;
+constexpr RotationTable<720> minuteRotations;
+constexpr RotationTable<43200> hourRotations;
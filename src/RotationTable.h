@@ -0,0 +1,83 @@
+/*
+ * RotationTable.h
+ *
+ * The cosine and sine of every position a clock hand can point at, computed
+ * at compile time: 60 positions for the seconds hand, 720 for the minutes
+ * hand (one every 5 seconds) and 43200 for the hours hand (one every second
+ * of 12 hours). Hands take their rotation from these tables so turning them
+ * needs no trigonometry at run time. Positions count clockwise from 12 o'clock.
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifndef ROTATIONTABLE_H_
+#define ROTATIONTABLE_H_
+
+#include <GL/glut.h>
+
+/**
+ * A rotation about the origin. The angle is counter-clockwise in degrees like
+ * Sprite::setAngle() takes it, so clockwise positions have negative angles.
+ */
+struct Rotation
+{
+	GLfloat degrees;
+	GLfloat cosAngle;
+	GLfloat sinAngle;
+};
+
+template<int POSITIONS>
+class RotationTable
+{
+public:
+	constexpr RotationTable();
+
+	/**
+	 * @return The rotation of the given position, any integer is wrapped
+	 *         around the circle.
+	 */
+	const Rotation &operator[](long position) const
+	{
+		position %= POSITIONS;
+
+		return rotations[position < 0 ? position + POSITIONS : position];
+	}
+
+	/**
+	 * @return The position closest to the given fraction of a turn.
+	 */
+	const Rotation &nearest(double turns) const
+	{
+		return (*this)[(long)(turns * POSITIONS + (turns < 0 ? -0.5 : 0.5))];
+	}
+
+	static const int positions = POSITIONS;
+
+private:
+	Rotation rotations[POSITIONS];
+};
+
+// the second hand at every second of a minute
+extern const RotationTable<60> secondRotations;
+// the minute hand every 5 seconds of an hour
+extern const RotationTable<720> minuteRotations;
+// the hour hand at every second of 12 hours
+extern const RotationTable<43200> hourRotations;
+
+#endif /* ROTATIONTABLE_H_ */
@@ -0,0 +1,540 @@
+/*
+ * SoftwareRenderer.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+#include "SoftwareRenderer.h"
+#include "Sprite.h"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// All inner loops implement the same fixed point arithmetic:
+//
+//   bilinear filter, 8 bit weights, rounded after each direction
+//     h0 = (p00 * (256 - fx) + p01 * fx + 128) >> 8
+//     h1 = (p10 * (256 - fx) + p11 * fx + 128) >> 8
+//     c  = (h0 * (256 - fy) + h1 * fy + 128) >> 8
+//
+//   blending (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA), on every channel
+//     dst = div255(c * a + dst * (255 - a))
+//   or for premultiplied textures (GL_ONE, GL_ONE_MINUS_SRC_ALPHA), where
+//   c <= a holds before and after filtering
+//     dst = div255(c * 255 + dst * (255 - a))
+//
+// Every intermediate value fits in an unsigned 16 bit integer, which lets the
+// SIMD versions work on 16 bit lanes holding one channel each.
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * One horizontal run of pixels covered by a sprite.
+ * Texture coordinates are in texels and already shifted by half a texel, so
+ * the integer part is the index of the top left texel of the 2x2 footprint.
+ */
+struct TexturedSpan
+{
+	BYTE *target;
+	int count;
+	// pixels before this one are clipped away. They are still counted so the
+	// texture coordinates of the others match the unclipped span exactly.
+	int first;
+	float s;
+	float t;
+	float ds;
+	float dt;
+	// bottom row of the texture, rows texStride pixels apart (negative when
+	// the image is stored top row first)
+	const BYTE *texels;
+	int texStride;
+	int texWidth;
+	int texHeight;
+	// the texels are BGRA instead of RGBA
+	bool swapRedBlue;
+	// the colours are already multiplied by alpha
+	bool premultiplied;
+};
+
+typedef void (*SpanFunction)(const TexturedSpan &span);
+
+// rounded division by 255, exact for 0 <= x <= 255 * 255
+static inline int div255(int x)
+{
+	return (x + 128 + ((x + 128) >> 8)) >> 8;
+}
+
+static inline void computeFootprint(const TexturedSpan &span, int i, int &x0, int &x1,
+									int &y0, int &y1, int &fx, int &fy)
+{
+	float s = span.s + i * span.ds;
+	float t = span.t + i * span.dt;
+	float floorS = floorf(s);
+	float floorT = floorf(t);
+
+	x0 = (int)floorS;
+	y0 = (int)floorT;
+	fx = min((int)((s - floorS) * 256.0f), 255);
+	fy = min((int)((t - floorT) * 256.0f), 255);
+
+	// clamp to edge, the default wrap mode of texture rectangles
+	x1 = min(max(x0 + 1, 0), span.texWidth - 1);
+	y1 = min(max(y0 + 1, 0), span.texHeight - 1);
+	x0 = min(max(x0, 0), span.texWidth - 1);
+	y0 = min(max(y0, 0), span.texHeight - 1);
+}
+
+static inline void drawPixelScalar(const TexturedSpan &span, int i)
+{
+	int x0, x1, y0, y1, fx, fy;
+	computeFootprint(span, i, x0, x1, y0, y1, fx, fy);
+
+	const BYTE *p00 = span.texels + (y0 * span.texStride + x0) * 4;
+	const BYTE *p01 = span.texels + (y0 * span.texStride + x1) * 4;
+	const BYTE *p10 = span.texels + (y1 * span.texStride + x0) * 4;
+	const BYTE *p11 = span.texels + (y1 * span.texStride + x1) * 4;
+	BYTE *dst = span.target + i * 4;
+	int color[4];
+
+	for(int c = 0; c < 4; c++)
+	{
+		int h0 = (p00[c] * (256 - fx) + p01[c] * fx + 128) >> 8;
+		int h1 = (p10[c] * (256 - fx) + p11[c] * fx + 128) >> 8;
+		color[c] = (h0 * (256 - fy) + h1 * fy + 128) >> 8;
+	}
+
+	if(span.swapRedBlue)
+	{
+		swap(color[0], color[2]);
+	}
+
+	int alpha = color[3];
+	int scale = span.premultiplied ? 255 : alpha;
+
+	for(int c = 0; c < 4; c++)
+	{
+		dst[c] = div255(color[c] * scale + dst[c] * (255 - alpha));
+	}
+}
+
+static void drawSpanScalar(const TexturedSpan &span)
+{
+	for(int i = span.first; i < span.count; i++)
+	{
+		drawPixelScalar(span, i);
+	}
+}
+
+// two pixels per iteration, one channel per 16 bit lane
+static void drawSpanSSE2(const TexturedSpan &span)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i rounding = _mm_set1_epi16(128);
+	const __m128i full = _mm_set1_epi16(256);
+	const __m128i opaque = _mm_set1_epi16(255);
+	const int *texels = (const int *)span.texels;
+	int i = span.first;
+
+	for(; i + 2 <= span.count; i += 2)
+	{
+		int x0[2], x1[2], y0[2], y1[2], fx[2], fy[2];
+
+		computeFootprint(span, i, x0[0], x1[0], y0[0], y1[0], fx[0], fy[0]);
+		computeFootprint(span, i + 1, x0[1], x1[1], y0[1], y1[1], fx[1], fy[1]);
+
+		__m128i p00 = _mm_unpacklo_epi8(_mm_set_epi32(0, 0,
+			texels[y0[1] * span.texStride + x0[1]], texels[y0[0] * span.texStride + x0[0]]), zero);
+		__m128i p01 = _mm_unpacklo_epi8(_mm_set_epi32(0, 0,
+			texels[y0[1] * span.texStride + x1[1]], texels[y0[0] * span.texStride + x1[0]]), zero);
+		__m128i p10 = _mm_unpacklo_epi8(_mm_set_epi32(0, 0,
+			texels[y1[1] * span.texStride + x0[1]], texels[y1[0] * span.texStride + x0[0]]), zero);
+		__m128i p11 = _mm_unpacklo_epi8(_mm_set_epi32(0, 0,
+			texels[y1[1] * span.texStride + x1[1]], texels[y1[0] * span.texStride + x1[0]]), zero);
+
+		__m128i wx = _mm_set_epi16(fx[1], fx[1], fx[1], fx[1], fx[0], fx[0], fx[0], fx[0]);
+		__m128i wy = _mm_set_epi16(fy[1], fy[1], fy[1], fy[1], fy[0], fy[0], fy[0], fy[0]);
+		__m128i iwx = _mm_sub_epi16(full, wx);
+		__m128i iwy = _mm_sub_epi16(full, wy);
+
+		__m128i h0 = _mm_add_epi16(_mm_mullo_epi16(p00, iwx), _mm_mullo_epi16(p01, wx));
+		__m128i h1 = _mm_add_epi16(_mm_mullo_epi16(p10, iwx), _mm_mullo_epi16(p11, wx));
+		h0 = _mm_srli_epi16(_mm_add_epi16(h0, rounding), 8);
+		h1 = _mm_srli_epi16(_mm_add_epi16(h1, rounding), 8);
+
+		__m128i color = _mm_add_epi16(_mm_mullo_epi16(h0, iwy), _mm_mullo_epi16(h1, wy));
+		color = _mm_srli_epi16(_mm_add_epi16(color, rounding), 8);
+
+		if(span.swapRedBlue)
+		{
+			color = _mm_shufflehi_epi16(_mm_shufflelo_epi16(color, _MM_SHUFFLE(3, 0, 1, 2)),
+										_MM_SHUFFLE(3, 0, 1, 2));
+		}
+
+		// copy the alpha of each pixel to all four of its lanes
+		__m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(color, _MM_SHUFFLE(3, 3, 3, 3)),
+											_MM_SHUFFLE(3, 3, 3, 3));
+
+		BYTE *target = span.target + i * 4;
+		__m128i dst = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)target), zero);
+
+		__m128i scale = span.premultiplied ? opaque : alpha;
+		__m128i blended = _mm_add_epi16(_mm_mullo_epi16(color, scale),
+										_mm_mullo_epi16(dst, _mm_sub_epi16(opaque, alpha)));
+		blended = _mm_add_epi16(blended, rounding);
+		blended = _mm_srli_epi16(_mm_add_epi16(blended, _mm_srli_epi16(blended, 8)), 8);
+
+		_mm_storel_epi64((__m128i *)target, _mm_packus_epi16(blended, zero));
+	}
+
+	for(; i < span.count; i++)
+	{
+		drawPixelScalar(span, i);
+	}
+}
+
+// four pixels per iteration, texels fetched with gathers
+__attribute__((target("avx2")))
+static void drawSpanAVX2(const TexturedSpan &span)
+{
+	const __m256i rounding = _mm256_set1_epi16(128);
+	const __m256i full = _mm256_set1_epi16(256);
+	const __m256i opaque = _mm256_set1_epi16(255);
+	const __m128i maxWeight = _mm_set1_epi32(255);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i maxX = _mm_set1_epi32(span.texWidth - 1);
+	const __m128i maxY = _mm_set1_epi32(span.texHeight - 1);
+	const __m128i one = _mm_set1_epi32(1);
+	const __m128i stride = _mm_set1_epi32(span.texStride);
+	// replicates the low byte of every 32 bit lane four times
+	const __m128i spread = _mm_set_epi8(12, 12, 12, 12, 8, 8, 8, 8, 4, 4, 4, 4, 0, 0, 0, 0);
+	const __m128 scale = _mm_set1_ps(256.0f);
+	const __m128 ds = _mm_set1_ps(span.ds);
+	const __m128 dt = _mm_set1_ps(span.dt);
+	const int *texels = (const int *)span.texels;
+	int i = span.first;
+
+	for(; i + 4 <= span.count; i += 4)
+	{
+		__m128 index = _mm_set_ps(i + 3, i + 2, i + 1, i);
+		__m128 s = _mm_add_ps(_mm_set1_ps(span.s), _mm_mul_ps(index, ds));
+		__m128 t = _mm_add_ps(_mm_set1_ps(span.t), _mm_mul_ps(index, dt));
+		__m128 floorS = _mm_floor_ps(s);
+		__m128 floorT = _mm_floor_ps(t);
+
+		__m128i fx = _mm_min_epi32(_mm_cvttps_epi32(_mm_mul_ps(_mm_sub_ps(s, floorS), scale)), maxWeight);
+		__m128i fy = _mm_min_epi32(_mm_cvttps_epi32(_mm_mul_ps(_mm_sub_ps(t, floorT), scale)), maxWeight);
+
+		__m128i x0 = _mm_cvttps_epi32(floorS);
+		__m128i y0 = _mm_cvttps_epi32(floorT);
+		__m128i x1 = _mm_min_epi32(_mm_max_epi32(_mm_add_epi32(x0, one), zero), maxX);
+		__m128i y1 = _mm_min_epi32(_mm_max_epi32(_mm_add_epi32(y0, one), zero), maxY);
+		x0 = _mm_min_epi32(_mm_max_epi32(x0, zero), maxX);
+		y0 = _mm_min_epi32(_mm_max_epi32(y0, zero), maxY);
+
+		__m128i row0 = _mm_mullo_epi32(y0, stride);
+		__m128i row1 = _mm_mullo_epi32(y1, stride);
+
+		__m256i p00 = _mm256_cvtepu8_epi16(_mm_i32gather_epi32(texels, _mm_add_epi32(row0, x0), 4));
+		__m256i p01 = _mm256_cvtepu8_epi16(_mm_i32gather_epi32(texels, _mm_add_epi32(row0, x1), 4));
+		__m256i p10 = _mm256_cvtepu8_epi16(_mm_i32gather_epi32(texels, _mm_add_epi32(row1, x0), 4));
+		__m256i p11 = _mm256_cvtepu8_epi16(_mm_i32gather_epi32(texels, _mm_add_epi32(row1, x1), 4));
+
+		__m256i wx = _mm256_cvtepu8_epi16(_mm_shuffle_epi8(fx, spread));
+		__m256i wy = _mm256_cvtepu8_epi16(_mm_shuffle_epi8(fy, spread));
+		__m256i iwx = _mm256_sub_epi16(full, wx);
+		__m256i iwy = _mm256_sub_epi16(full, wy);
+
+		__m256i h0 = _mm256_add_epi16(_mm256_mullo_epi16(p00, iwx), _mm256_mullo_epi16(p01, wx));
+		__m256i h1 = _mm256_add_epi16(_mm256_mullo_epi16(p10, iwx), _mm256_mullo_epi16(p11, wx));
+		h0 = _mm256_srli_epi16(_mm256_add_epi16(h0, rounding), 8);
+		h1 = _mm256_srli_epi16(_mm256_add_epi16(h1, rounding), 8);
+
+		__m256i color = _mm256_add_epi16(_mm256_mullo_epi16(h0, iwy), _mm256_mullo_epi16(h1, wy));
+		color = _mm256_srli_epi16(_mm256_add_epi16(color, rounding), 8);
+
+		if(span.swapRedBlue)
+		{
+			color = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(color, _MM_SHUFFLE(3, 0, 1, 2)),
+										   _MM_SHUFFLE(3, 0, 1, 2));
+		}
+
+		__m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(color, _MM_SHUFFLE(3, 3, 3, 3)),
+											   _MM_SHUFFLE(3, 3, 3, 3));
+
+		BYTE *target = span.target + i * 4;
+		__m256i dst = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)target));
+
+		__m256i scale = span.premultiplied ? opaque : alpha;
+		__m256i blended = _mm256_add_epi16(_mm256_mullo_epi16(color, scale),
+										   _mm256_mullo_epi16(dst, _mm256_sub_epi16(opaque, alpha)));
+		blended = _mm256_add_epi16(blended, rounding);
+		blended = _mm256_srli_epi16(_mm256_add_epi16(blended, _mm256_srli_epi16(blended, 8)), 8);
+
+		// packing works within each 128 bit half, put the two halves back together
+		__m256i packed = _mm256_packus_epi16(blended, _mm256_setzero_si256());
+		packed = _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+
+		_mm_storeu_si128((__m128i *)target, _mm256_castsi256_si128(packed));
+	}
+
+	for(; i < span.count; i++)
+	{
+		drawPixelScalar(span, i);
+	}
+}
+
+SoftwareRenderer::SoftwareRenderer(int width, int height)
+{
+	this->width = width;
+	this->height = height;
+	pixels = new BYTE[width * height * 4];
+	memset(pixels, 0, width * height * 4);
+	instructionSet = getSupportedInstructionSet();
+	resetClipRect();
+}
+
+SoftwareRenderer::~SoftwareRenderer()
+{
+	delete[] pixels;
+}
+
+void SoftwareRenderer::clear(BYTE red, BYTE green, BYTE blue, BYTE alpha)
+{
+	BYTE color[4] = { red, green, blue, alpha };
+
+	for(int row = clipBottom; row < clipTop; row++)
+	{
+		BYTE *target = pixels + row * width * 4;
+
+		for(int i = clipLeft; i < clipRight; i++)
+		{
+			memcpy(target + i * 4, color, 4);
+		}
+	}
+}
+
+void SoftwareRenderer::setClipRect(int x, int y, int width, int height)
+{
+	clipLeft = max(0, x);
+	clipBottom = max(0, y);
+	clipRight = max(clipLeft, min(this->width, x + width));
+	clipTop = max(clipBottom, min(this->height, y + height));
+}
+
+void SoftwareRenderer::resetClipRect()
+{
+	setClipRect(0, 0, width, height);
+}
+
+void SoftwareRenderer::copy(const SoftwareRenderer &source)
+{
+	if(source.width != width || source.height != height || clipLeft >= clipRight)
+	{
+		return;
+	}
+
+	for(int row = clipBottom; row < clipTop; row++)
+	{
+		int offset = (row * width + clipLeft) * 4;
+		memcpy(pixels + offset, source.pixels + offset, (clipRight - clipLeft) * 4);
+	}
+}
+
+void SoftwareRenderer::draw(const Sprite &sprite)
+{
+	const ImageLoader *image = sprite.getImage();
+
+	if(image == NULL || image->getPixelData() == NULL || image->getWidth() <= 0 || image->getHeight() <= 0)
+	{
+		return;
+	}
+
+	GLfloat corners[8];
+	GLfloat texCoords[8];
+
+	sprite.getQuad(corners, texCoords);
+
+	// the quad spans the image along (corner 3 - corner 0) and (corner 1 - corner 0)
+	float originX = corners[0];
+	float originY = corners[1];
+	float uX = corners[6] - originX;
+	float uY = corners[7] - originY;
+	float vX = corners[2] - originX;
+	float vY = corners[3] - originY;
+	float determinant = uX * vY - uY * vX;
+
+	if(determinant == 0)
+	{
+		return;
+	}
+
+	// world coordinates of the frame buffer, matching glOrtho in reshape()
+	float left = -(width / 2);
+	float bottom = -(height / 2);
+	float pixelWidth = (float)(width / 2 - -(width / 2)) / width;
+	float pixelHeight = (float)(height / 2 - -(height / 2)) / height;
+
+	// (a, b) is the position inside the quad, both in [0, 1)
+	// a = (dx * vY - dy * vX) / determinant
+	// b = (dy * uX - dx * uY) / determinant
+	float daPerPixel = vY / determinant * pixelWidth;
+	float dbPerPixel = -uY / determinant * pixelWidth;
+
+	float minY = min(min(corners[1], corners[3]), min(corners[5], corners[7]));
+	float maxY = max(max(corners[1], corners[3]), max(corners[5], corners[7]));
+	int firstRow = max(clipBottom, (int)floor((minY - bottom) / pixelHeight));
+	int lastRow = min(clipTop - 1, (int)ceil((maxY - bottom) / pixelHeight));
+
+	TexturedSpan span;
+	// sample the mip level of about the size the sprite is drawn at
+	int level = sprite.getMipLevel();
+	LONG levelStride = image->getMipStride(level);
+
+	span.texWidth = image->getMipWidth(level);
+	span.texHeight = image->getMipHeight(level);
+	// levels keep the row order of the image, start at the bottom row
+	span.texels = image->getMipLevel(level) + (image->isFlipped() ? (span.texHeight - 1) * levelStride : 0);
+	span.texStride = (image->isFlipped() ? -levelStride : levelStride) / 4;
+	span.swapRedBlue = image->getFormat() == ImageLoader::FORMAT_BGRA;
+	span.premultiplied = image->isPremultiplied();
+	span.ds = daPerPixel * span.texWidth;
+	span.dt = dbPerPixel * span.texHeight;
+
+	SpanFunction drawSpan = drawSpanScalar;
+
+	if(instructionSet == AVX2)
+	{
+		drawSpan = drawSpanAVX2;
+	}
+	else if(instructionSet == SSE2)
+	{
+		drawSpan = drawSpanSSE2;
+	}
+
+	for(int row = firstRow; row <= lastRow; row++)
+	{
+		float dx = left + 0.5f * pixelWidth - originX;
+		float dy = bottom + (row + 0.5f) * pixelHeight - originY;
+
+		// position of the centre of the first pixel in the row
+		float a = (dx * vY - dy * vX) / determinant;
+		float b = (dy * uX - dx * uY) / determinant;
+
+		// the pixels where both a and b are in [0, 1)
+		float start = 0;
+		float end = width;
+
+		if(!clipSpan(a, daPerPixel, start, end) || !clipSpan(b, dbPerPixel, start, end))
+		{
+			continue;
+		}
+
+		int first = max(0, (int)ceil(start));
+		int last = min(clipRight, (int)ceil(end));
+
+		if(max(first, clipLeft) >= last)
+		{
+			continue;
+		}
+
+		span.target = pixels + (row * width + first) * 4;
+		span.count = last - first;
+		span.first = max(0, clipLeft - first);
+		// shift by half a texel so the integer part is the top left texel
+		span.s = (a + first * daPerPixel) * span.texWidth - 0.5f;
+		span.t = (b + first * dbPerPixel) * span.texHeight - 0.5f;
+
+		drawSpan(span);
+	}
+}
+
+bool SoftwareRenderer::clipSpan(float value, float step, float &start, float &end)
+{
+	// value + i * step must be in [0, 1)
+	if(step == 0)
+	{
+		return value >= 0 && value < 1;
+	}
+
+	float zeroAt = -value / step;
+	float oneAt = (1 - value) / step;
+
+	if(step > 0)
+	{
+		start = max(start, zeroAt);
+		end = min(end, oneAt);
+	}
+	else
+	{
+		start = max(start, oneAt);
+		end = min(end, zeroAt);
+	}
+
+	return start < end;
+}
+
+BYTE *SoftwareRenderer::getPixels() const
+{
+	return pixels;
+}
+
+bool SoftwareRenderer::saveBMP(const char *fileName) const
+{
+	return ImageLoader::saveBMP(fileName, width, height, pixels);
+}
+
+int SoftwareRenderer::getWidth() const
+{
+	return width;
+}
+
+int SoftwareRenderer::getHeight() const
+{
+	return height;
+}
+
+void SoftwareRenderer::setInstructionSet(InstructionSet instructionSet)
+{
+	this->instructionSet = min(instructionSet, getSupportedInstructionSet());
+}
+
+SoftwareRenderer::InstructionSet SoftwareRenderer::getInstructionSet() const
+{
+	return instructionSet;
+}
+
+SoftwareRenderer::InstructionSet SoftwareRenderer::getSupportedInstructionSet()
+{
+	__builtin_cpu_init();
+
+	if(__builtin_cpu_supports("avx2"))
+	{
+		return AVX2;
+	}
+
+	if(__builtin_cpu_supports("sse2"))
+	{
+		return SSE2;
+	}
+
+	return SCALAR;
+}
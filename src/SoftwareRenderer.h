@@ -0,0 +1,129 @@
+/*
+ * SoftwareRenderer.h
+ *
+ * Draws sprites into a 32-bit RGBA frame buffer in memory without OpenGL.
+ * Sprites are rendered the way Sprite::draw() renders them through GL:
+ * pivoted, scaled and rotated quads with bilinear filtering, blended with
+ * GL_SRC_ALPHA / GL_ONE_MINUS_SRC_ALPHA. The coordinate system is the one set
+ * up by reshape() in main.cpp, with (0, 0) in the middle of the frame buffer.
+ *
+ * The inner loops use AVX2 or SSE2 when the processor supports them. All code
+ * paths produce exactly the same pixels, so the renderer can also be used as
+ * a reference to compare GL output against.
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifndef SOFTWARERENDERER_H_
+#define SOFTWARERENDERER_H_
+
+#include "ImageLoader.h"
+
+class Sprite;
+
+class SoftwareRenderer
+{
+public:
+	enum InstructionSet
+	{
+		SCALAR,
+		SSE2,
+		AVX2
+	};
+
+	/**
+	 * Creates a frame buffer of the given size, cleared to transparent black.
+	 */
+	SoftwareRenderer(int width, int height);
+	virtual ~SoftwareRenderer();
+
+	/**
+	 * Fills the clip rectangle with the given colour.
+	 */
+	void clear(BYTE red, BYTE green, BYTE blue, BYTE alpha);
+
+	/**
+	 * Limits clear() and draw() to a rectangle of pixels, with (0, 0) at the
+	 * bottom left corner like glScissor. Pixels outside are left untouched.
+	 */
+	void setClipRect(int x, int y, int width, int height);
+
+	/**
+	 * Lets clear() and draw() cover the whole frame buffer again.
+	 */
+	void resetClipRect();
+
+	/**
+	 * Copies the pixels inside the clip rectangle from another frame buffer of
+	 * the same size, e.g. a cached layer of sprites that do not move.
+	 */
+	void copy(const SoftwareRenderer &source);
+
+	/**
+	 * Composites the sprite over the frame buffer with its current position,
+	 * pivot, scale and angle, inside the clip rectangle.
+	 */
+	void draw(const Sprite &sprite);
+
+	/**
+	 * @return width * height RGBA pixels, bottom row first like glReadPixels.
+	 */
+	BYTE *getPixels() const;
+
+	/**
+	 * Writes the frame buffer to a 32-bit bitmap.
+	 * @return True on success false on failure
+	 */
+	bool saveBMP(const char *fileName) const;
+
+	int getWidth() const;
+	int getHeight() const;
+
+	/**
+	 * Selects the inner loop to use. By default the best one supported by the
+	 * processor is picked; asking for an unsupported one falls back to the
+	 * best supported one.
+	 */
+	void setInstructionSet(InstructionSet instructionSet);
+	InstructionSet getInstructionSet() const;
+
+	/**
+	 * @return The best instruction set supported by this processor.
+	 */
+	static InstructionSet getSupportedInstructionSet();
+
+private:
+	BYTE *pixels;
+	int width;
+	int height;
+	InstructionSet instructionSet;
+	// clip rectangle, right and top are exclusive
+	int clipLeft;
+	int clipBottom;
+	int clipRight;
+	int clipTop;
+
+	/**
+	 * Narrows [start, end) to the pixels i where value + i * step is in [0, 1).
+	 * @return False if no pixel is left.
+	 */
+	static bool clipSpan(float value, float step, float &start, float &end);
+};
+
+#endif /* SOFTWARERENDERER_H_ */
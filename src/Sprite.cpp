@@ -24,8 +24,13 @@
 #include <GL/glut.h>
 #include <iostream>
 #include <cstring>
+#include <cmath>
 #include "Sprite.h"
 #include "ImageLoader.h"
+#include "TextureCache.h"
+#include "RotationTable.h"
+#include "Profiler.h"
+#include "AlphaMask.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 // implementation is based on this article:
@@ -34,30 +39,139 @@
 
 Sprite::Sprite(string filename)
 {
-	image = new ImageLoader(filename.c_str());
+	this->filename = filename;
+	image = TextureCache::acquire(filename);
+	textureID = 0;
+	regionX = 0;
+	regionY = 0;
+	textureWidth = image != NULL ? image->getWidth() : 0;
+	textureHeight = image != NULL ? image->getHeight() : 0;
+	// images stored top row first end up upside down in their own texture
+	flipTexture = image != NULL && image->isFlipped();
+	premultiplied = image != NULL && image->isPremultiplied();
+	sceneInitialized = false;
 	angle = 0;
+	cosAngle = 1;
+	sinAngle = 0;
 	x = 0.0;
 	y = 0.0;
-	setPivot(0.0, 0.0);
+	pivotX = 0.0;
+	pivotY = 0.0;
 	setScale(1.0, 1.0);
+	// nothing is on screen yet
+	dirty = true;
+	cleanBounds.left = 0;
+	cleanBounds.bottom = 0;
+	cleanBounds.right = -1;
+	cleanBounds.top = -1;
+
+	// images from an asset pack know where their pivot is
+	if(image != NULL && image->hasPivot())
+	{
+		setPivot(image->getPivotX(), image->getPivotY());
+	}
+	else
+	{
+		setPivot(0.0, 0.0);
+	}
+}
+
+Sprite::Sprite(const Sprite &other)
+{
+	filename = other.filename;
+	// adds a reference, the image is already loaded
+	image = TextureCache::acquire(filename);
+	textureID = other.textureID;
+	regionX = other.regionX;
+	regionY = other.regionY;
+	textureWidth = other.textureWidth;
+	textureHeight = other.textureHeight;
+	flipTexture = other.flipTexture;
+	premultiplied = other.premultiplied;
+	sceneInitialized = other.sceneInitialized;
+	angle = other.angle;
+	cosAngle = other.cosAngle;
+	sinAngle = other.sinAngle;
+	x = other.x;
+	y = other.y;
+	pivotX = other.pivotX;
+	pivotY = other.pivotY;
+	scaleX = other.scaleX;
+	scaleY = other.scaleY;
+	updateTransform();
+	// the copy has not been drawn anywhere yet
+	dirty = true;
+	cleanBounds.left = 0;
+	cleanBounds.bottom = 0;
+	cleanBounds.right = -1;
+	cleanBounds.top = -1;
 }
 
 Sprite::~Sprite()
 {
-	delete image;
+	TextureCache::release(filename);
 }
 
-void Sprite::rotate(GLint degrees)
+void Sprite::rotate(GLfloat degrees)
 {
-	angle += degrees;
+	setAngle(angle + degrees);
 }
 
-void Sprite::setAngle(GLint angle)
+void Sprite::setAngle(GLfloat angle)
 {
+	if(angle == this->angle)
+	{
+		return;
+	}
+
+	// the only trigonometry, once per change rather than every time the
+	// sprite is drawn
+	GLfloat radians = angle * M_PI / 180.0;
+
 	this->angle = angle;
+	cosAngle = cos(radians);
+	sinAngle = sin(radians);
+	updateTransform();
+	dirty = true;
 }
 
-GLint Sprite::getAngle() const
+void Sprite::setRotation(const Rotation &rotation)
+{
+	if(rotation.degrees == angle && rotation.cosAngle == cosAngle && rotation.sinAngle == sinAngle)
+	{
+		return;
+	}
+
+	angle = rotation.degrees;
+	cosAngle = rotation.cosAngle;
+	sinAngle = rotation.sinAngle;
+	updateTransform();
+	dirty = true;
+}
+
+void Sprite::getTransform(GLfloat transform[6]) const
+{
+	memcpy(transform, this->transform, sizeof(this->transform));
+}
+
+void Sprite::updateTransform()
+{
+	GLfloat transX;
+	GLfloat transY;
+
+	getTranslation(transX, transY);
+
+	// translate * scale * rotate, what glTranslatef(), glScalef() and
+	// glRotatef() used to do to the modelview matrix in draw()
+	transform[0] = scaleX * cosAngle;
+	transform[1] = scaleY * sinAngle;
+	transform[2] = -scaleX * sinAngle;
+	transform[3] = scaleY * cosAngle;
+	transform[4] = transX;
+	transform[5] = transY;
+}
+
+GLfloat Sprite::getAngle() const
 {
 	return angle;
 }
@@ -100,6 +214,7 @@ void Sprite::disable2D()
 
 void Sprite::initScene()
 {
+	Profiler::Scope scope(Profiler::INIT_SCENE);
 
 	// Disable lighting
 	glDisable( GL_LIGHTING );
@@ -113,30 +228,24 @@ void Sprite::initScene()
 	// Disable depth testing
 	glDisable( GL_DEPTH_TEST );
 
-	// Is the extension supported on this driver/card?
-	if( !isExtensionSupported( "GL_ARB_texture_rectangle" ) )
+	// Is the extension supported on this driver/card? Unlike texture rectangles,
+	// 2D textures of any size can have mipmaps
+	if( !isExtensionSupported( "GL_ARB_texture_non_power_of_two" ) )
 	{
-		cout << "ERROR: Texture rectangles not supported on this video card!" << endl;
+		cout << "ERROR: Non power of two textures not supported on this video card!" << endl;
 		exit(-1);
 	}
 
-	// NOTE: If your comp doesn't support GL_NV_texture_rectangle, you can try
-	// using GL_EXT_texture_rectangle if you want, it should work fine.
+	glEnable( GL_TEXTURE_2D );
 
-	// Enable the texture rectangle extension
-	glEnable( GL_TEXTURE_RECTANGLE_ARB );
-
-	// Generate one texture ID
-	glGenTextures( 1, &textureID );
-	// Bind the texture using GL_TEXTURE_RECTANGLE_NV
-	glBindTexture( GL_TEXTURE_RECTANGLE_ARB, textureID );
-	// Enable bilinear filtering on this texture
-	glTexParameteri( GL_TEXTURE_RECTANGLE_ARB, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
-	glTexParameteri( GL_TEXTURE_RECTANGLE_ARB, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+	// The texture is shared with every other sprite using the same image and
+	// only uploaded the first time any of them is drawn
+	if( textureID == 0 )
+	{
+		textureID = TextureCache::getTexture( filename );
+	}
 
-	// Write the 32-bit RGBA texture buffer to video memory
-	glTexImage2D( GL_TEXTURE_RECTANGLE_ARB, 0, GL_RGBA, image->getWidth(), image->getHeight(),
-				  0, GL_RGBA, GL_UNSIGNED_BYTE, image->getPixelData() );
+	sceneInitialized = true;
 }
 
 GLfloat Sprite::getPivotX() const
@@ -159,6 +268,9 @@ void Sprite::setPivot(GLfloat pivotX, GLfloat pivotY)
 
 	x += deltaPivotX * image->getWidth();
 	y += deltaPivotY * image->getHeight();
+	// the quad is placed around the pivot
+	updateTransform();
+	dirty = true;
 }
 
 void Sprite::setPivot(const Sprite &obj)
@@ -226,42 +338,34 @@ bool Sprite::isExtensionSupported(const char *extension) const
 
 void Sprite::draw()
 {
-	initScene();
+	if(!sceneInitialized)
+	{
+		initScene();
+	}
 
 	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
+	glBlendFunc(premultiplied ? GL_ONE : GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	glEnable(GL_TEXTURE_2D);
 
 	// Set the primitive color to white
 	glColor3f(1.0f, 1.0f, 1.0f);
 	// Bind the texture to the polygons
-	glBindTexture(GL_TEXTURE_RECTANGLE_ARB, textureID);
+	glBindTexture(GL_TEXTURE_2D, textureID);
 
 	glPushMatrix();
 
-	GLfloat transX = 1;
-	GLfloat transY = 1;
+	GLfloat matrix[16] = {
+		transform[0], transform[1], 0, 0,
+		transform[2], transform[3], 0, 0,
+		0, 0, 1, 0,
+		transform[4], transform[5], 0, 1
+	};
 
-	if(x != 0.0)
-	{
-		transX = x;
-	}
-
-	if(y != 0.0)
-	{
-		transY = y;
-	}
-
-	glLoadIdentity();
-	glTranslatef(transX, transY, 0);
-	glScalef(scaleX, scaleY, 1.0);
-	glRotatef(angle, 0.0, 0.0, 1.0);
+	glLoadMatrixf(matrix);
 
 	// Render a quad
-	// Instead of the using (s,t) coordinates, with the  GL_NV_texture_rectangle
-	// extension, you need to use the actual dimensions of the texture.
-	// This makes using 2D sprites for games and emulators much easier now
-	// that you won't have to convert :)
+	// The (s,t) coordinates go from 0 to 1 across the whole texture, which may
+	// be an atlas holding more than this sprite.
 	//
 	// convert the coordinates so that the bottom left corner changes to
 	// (0, 0) -> (1, 1) and the top right corner changes from (1, 1) -> (0, 0)
@@ -269,37 +373,245 @@ void Sprite::draw()
 	// in the world coordinates to do the rotation and scaling. This mapping is done in
 	// order to make implementation simpler in this class and let the caller keep using
 	// the standard OpenGL coordinates system (bottom left corner at (0, 0))
+	GLfloat texCoords[8];
+
+	getTexCoords(texCoords);
+
 	glBegin(GL_QUADS);
-		glTexCoord2i(0, 0);
+		glTexCoord2f(texCoords[0], texCoords[1]);
 		glVertex2i(-pivotX * image->getWidth(), -pivotY * image->getHeight());
 
-		glTexCoord2i(0, image->getHeight());
+		glTexCoord2f(texCoords[2], texCoords[3]);
 		glVertex2i(-pivotX * image->getWidth(), (1 - pivotY) * image->getHeight());
 
-		glTexCoord2i(image->getWidth(), image->getHeight());
+		glTexCoord2f(texCoords[4], texCoords[5]);
 		glVertex2i( (1 - pivotX) * image->getWidth(), (1 - pivotY) * image->getHeight());
 
-		glTexCoord2i(image->getWidth(), 0);
+		glTexCoord2f(texCoords[6], texCoords[7]);
 		glVertex2i( (1 - pivotX) * image->getWidth(), -pivotY * image->getHeight());
 	glEnd();
 
 	glPopMatrix();
+
+	// the blend function and the texture
+	Profiler::countStateChanges(2);
+	Profiler::countDrawCalls(1);
+}
+
+void Sprite::getTranslation(GLfloat &transX, GLfloat &transY) const
+{
+	transX = 1;
+	transY = 1;
+
+	if(x != 0.0)
+	{
+		transX = x;
+	}
+
+	if(y != 0.0)
+	{
+		transY = y;
+	}
+}
+
+void Sprite::getTexCoords(GLfloat texCoords[8]) const
+{
+	GLfloat left = (GLfloat)regionX / textureWidth;
+	GLfloat right = (GLfloat)(regionX + image->getWidth()) / textureWidth;
+	GLfloat bottom = (GLfloat)regionY / textureHeight;
+	GLfloat top = (GLfloat)(regionY + image->getHeight()) / textureHeight;
+
+	if(flipTexture)
+	{
+		swap(bottom, top);
+	}
+
+	texCoords[0] = left;  texCoords[1] = bottom;
+	texCoords[2] = left;  texCoords[3] = top;
+	texCoords[4] = right; texCoords[5] = top;
+	texCoords[6] = right; texCoords[7] = bottom;
+}
+
+void Sprite::getQuad(GLfloat vertices[8], GLfloat texCoords[8]) const
+{
+	GLfloat width = image->getWidth();
+	GLfloat height = image->getHeight();
+
+	// same corners as the quad in draw(), in the same order
+	GLfloat left = -pivotX * width;
+	GLfloat right = (1 - pivotX) * width;
+	GLfloat bottom = -pivotY * height;
+	GLfloat top = (1 - pivotY) * height;
+
+	GLfloat localX[4] = { left, left, right, right };
+	GLfloat localY[4] = { bottom, top, top, bottom };
+
+	getTexCoords(texCoords);
+
+	// apply the same transform on the CPU that draw() loads into the matrix stack
+	for(int i = 0; i < 4; i++)
+	{
+		vertices[i * 2] = transform[0] * localX[i] + transform[2] * localY[i] + transform[4];
+		vertices[i * 2 + 1] = transform[1] * localX[i] + transform[3] * localY[i] + transform[5];
+	}
+}
+
+Sprite::Bounds Sprite::getBounds() const
+{
+	GLfloat vertices[8];
+	GLfloat texCoords[8];
+	Bounds bounds;
+
+	getQuad(vertices, texCoords);
+
+	bounds.left = bounds.right = vertices[0];
+	bounds.bottom = bounds.top = vertices[1];
+
+	for(int i = 1; i < 4; i++)
+	{
+		bounds.left = min(bounds.left, vertices[i * 2]);
+		bounds.right = max(bounds.right, vertices[i * 2]);
+		bounds.bottom = min(bounds.bottom, vertices[i * 2 + 1]);
+		bounds.top = max(bounds.top, vertices[i * 2 + 1]);
+	}
+
+	return bounds;
+}
+
+bool Sprite::hitTest(GLfloat worldX, GLfloat worldY) const
+{
+	if(image == NULL)
+	{
+		return false;
+	}
+
+	GLfloat determinant = transform[0] * transform[3] - transform[2] * transform[1];
+
+	// a sprite scaled to nothing covers nothing
+	if(determinant == 0)
+	{
+		return false;
+	}
+
+	// undo the translation, then the rotation and scale
+	GLfloat dx = worldX - transform[4];
+	GLfloat dy = worldY - transform[5];
+	GLfloat localX = (transform[3] * dx - transform[2] * dy) / determinant;
+	GLfloat localY = (transform[0] * dy - transform[1] * dx) / determinant;
+
+	// from the pivot to the bottom left corner of the image, see getQuad()
+	GLfloat imageX = localX + pivotX * image->getWidth();
+	GLfloat imageY = localY + pivotY * image->getHeight();
+
+	// checked before converting, far away points do not fit a LONG
+	if(!(imageX >= 0 && imageX < image->getWidth() && imageY >= 0 && imageY < image->getHeight()))
+	{
+		return false;
+	}
+
+	return image->getAlphaMask().contains((LONG)imageX, (LONG)imageY);
+}
+
+bool Sprite::isDirty() const
+{
+	return dirty;
+}
+
+void Sprite::getDirtyBounds(Bounds &previous, Bounds &current) const
+{
+	previous = cleanBounds;
+	current = getBounds();
+}
+
+void Sprite::markClean()
+{
+	// the bounds of a clean sprite are still the ones on screen
+	if(dirty)
+	{
+		cleanBounds = getBounds();
+		dirty = false;
+	}
+}
+
+GLuint Sprite::getTexture()
+{
+	if(!sceneInitialized)
+	{
+		initScene();
+	}
+
+	return textureID;
+}
+
+void Sprite::setTextureRegion(GLuint textureID, GLint x, GLint y,
+							  GLint textureWidth, GLint textureHeight, bool premultiplied)
+{
+	this->textureID = textureID;
+	regionX = x;
+	regionY = y;
+	this->textureWidth = textureWidth;
+	this->textureHeight = textureHeight;
+	// atlases always store the rows bottom up
+	flipTexture = false;
+	this->premultiplied = premultiplied;
+}
+
+bool Sprite::isPremultiplied() const
+{
+	return premultiplied;
+}
+
+int Sprite::getMipLevel() const
+{
+	if(image == NULL)
+	{
+		return 0;
+	}
+
+	// one world unit is one pixel with the projection set up in reshape(), so
+	// a sprite at scale s covers s pixels per texel along each axis. Pick the
+	// sharpest level that is not magnified along the more shrunk axis.
+	GLfloat scale = min(fabs(scaleX), fabs(scaleY));
+	int level = 0;
+
+	while(level + 1 < image->getMipLevelCount() && scale * (1 << (level + 1)) <= 1.0f)
+	{
+		level++;
+	}
+
+	return level;
+}
+
+const ImageLoader *Sprite::getImage() const
+{
+	return image;
+}
+
+const string &Sprite::getFilename() const
+{
+	return filename;
 }
 
 void Sprite::setX(GLdouble x)
 {
 	this->x = x;
+	updateTransform();
+	dirty = true;
 }
 
 void Sprite::setY(GLdouble y)
 {
 	this->y = y;
+	updateTransform();
+	dirty = true;
 }
 
 void Sprite::setScale(GLfloat x, GLfloat y)
 {
 	scaleX = x;
 	scaleY = y;
+	updateTransform();
+	dirty = true;
 }
 
 GLint Sprite::getHeight() const
@@ -30,10 +30,22 @@
 using namespace std;
 
 class ImageLoader;
+struct Rotation;
 
 class Sprite
 {
 public:
+	/**
+	 * An axis aligned rectangle in world coordinates. It is empty when left > right.
+	 */
+	struct Bounds
+	{
+		GLfloat left;
+		GLfloat bottom;
+		GLfloat right;
+		GLfloat top;
+	};
+
 	/**
 	 * Enable 2D drawing mode to draw our sprites. This function MUST be called before
 	 * any sprite is drawn on screen using the draw method.
@@ -47,14 +59,119 @@ public:
 	static void disable2D();
 
 	Sprite(string filename);
+
+	/**
+	 * Creates a sprite showing the same image from the same texture (or atlas
+	 * region) with the same pivot, position, scale and angle, e.g. to draw an
+	 * image many times without loading it again.
+	 */
+	Sprite(const Sprite &other);
 	virtual ~Sprite();
 
 	virtual void draw();
-	virtual void rotate(GLint degrees);
+	virtual void rotate(GLfloat degrees);
+
+	/**
+	 * Turns the sprite to a rotation whose cosine and sine are already known,
+	 * e.g. a position from a RotationTable, instead of computing them.
+	 */
+	void setRotation(const Rotation &rotation);
+
+	/**
+	 * Returns the 2x3 matrix that takes a point relative to the pivot to
+	 * world coordinates: translate * scale * rotate, kept up to date whenever
+	 * the sprite is turned, moved or scaled so drawing needs no trigonometry.
+	 * @param transform Receives { a, b, c, d, e, f } for x' = a * x + c * y + e
+	 *        and y' = b * x + d * y + f, in the column order OpenGL uses.
+	 */
+	void getTransform(GLfloat transform[6]) const;
+
+	/**
+	 * Calculates the corners of the sprite in world coordinates together with
+	 * their texture coordinates, using the same pivot, scale and rotation as draw().
+	 * The corners are returned in GL_QUADS order.
+	 * @param vertices Receives the (x, y) pairs of the four corners.
+	 * @param texCoords Receives the (s, t) pairs of the four corners.
+	 */
+	void getQuad(GLfloat vertices[8], GLfloat texCoords[8]) const;
+
+	/**
+	 * @return The smallest axis aligned rectangle containing the quad of getQuad().
+	 */
+	Bounds getBounds() const;
+
+	/**
+	 * Tells whether a point in world coordinates falls on an opaque enough
+	 * pixel of the sprite, e.g. to find the sprite under the mouse. Turned
+	 * and scaled sprites are tested through the inverse of their transform
+	 * against the coverage mask of their image, see ImageLoader::getAlphaMask(),
+	 * so a test costs the same whatever the size of the image.
+	 */
+	bool hitTest(GLfloat worldX, GLfloat worldY) const;
+
+	/**
+	 * @return True if the sprite was turned, moved or scaled since the last
+	 *         call to markClean(), so the area it covers on screen has to be
+	 *         redrawn. New sprites are dirty.
+	 */
+	bool isDirty() const;
+
+	/**
+	 * Returns where the sprite was when markClean() was last called and where
+	 * it is now. Both have to be redrawn when the sprite is dirty.
+	 * @param previous Empty if markClean() was never called.
+	 */
+	void getDirtyBounds(Bounds &previous, Bounds &current) const;
+
+	/**
+	 * Remembers the current bounds as the ones on screen, to be called once
+	 * the sprite has been drawn.
+	 */
+	void markClean();
+
+	/**
+	 * Returns the texture this sprite is drawn with, uploading it if it is not
+	 * in video memory yet.
+	 */
+	GLuint getTexture();
+
+	/**
+	 * Draws the sprite from a sub-rectangle of a shared texture instead of its
+	 * own texture, e.g. from a TextureAtlas. The texture must contain the
+	 * sprite's image with its bottom left corner at (x, y).
+	 * @param textureWidth The size of the whole texture in pixels.
+	 * @param premultiplied True if the colours in the texture are multiplied
+	 *        by alpha.
+	 */
+	void setTextureRegion(GLuint textureID, GLint x, GLint y,
+						  GLint textureWidth, GLint textureHeight, bool premultiplied = false);
+
+	/**
+	 * @return True if the texture the sprite is drawn with has premultiplied
+	 *         alpha, which needs GL_ONE instead of GL_SRC_ALPHA for blending.
+	 */
+	bool isPremultiplied() const;
+
+	/**
+	 * @return The mip level of the image that matches the current scale, the
+	 *         one renderers without automatic level selection should sample.
+	 *         OpenGL picks levels per pixel by itself.
+	 */
+	int getMipLevel() const;
+
+	/**
+	 * @return The image the sprite was loaded from.
+	 */
+	const ImageLoader *getImage() const;
+
+	/**
+	 * @return The path of the image the sprite was loaded from.
+	 */
+	const string &getFilename() const;
 
 	// getter and setter methods
-	GLint getAngle() const;
-	void setAngle(GLint degrees);
+	GLfloat getAngle() const;
+	void setAngle(GLfloat degrees);
 	void setX(GLdouble x);
 	void setY(GLdouble y);
 	GLint getHeight() const;
@@ -95,21 +212,51 @@ public:
 	 */
 	void setScale(GLfloat x, GLfloat y);
 private:
+	string filename;
 	ImageLoader *image;
 	GLuint textureID;
-	GLint angle;
+	GLint regionX;
+	GLint regionY;
+	GLint textureWidth;
+	GLint textureHeight;
+	bool flipTexture;
+	bool premultiplied;
+	bool sceneInitialized;
+	GLfloat angle;
+	GLfloat cosAngle;
+	GLfloat sinAngle;
+	GLfloat transform[6];
 	GLdouble x;
 	GLdouble y;
 	GLfloat pivotX;
 	GLfloat pivotY;
 	GLfloat scaleX;
 	GLfloat scaleY;
+	// dirty rectangle tracking
+	bool dirty;
+	Bounds cleanBounds;
 
 	//-----------------------------------------------------------------------------
-	// Initializes extensions, textures, render states, etc. before rendering
+	// Initializes extensions, textures, render states, etc. before rendering.
+	// Only needs to run once, before the first time the sprite is drawn.
 	//-----------------------------------------------------------------------------
 	void initScene();
 
+	/**
+	 * Returns the translation applied to the sprite when it is drawn.
+	 */
+	void getTranslation(GLfloat &transX, GLfloat &transY) const;
+
+	/**
+	 * Recomputes the transform after the rotation, position or scale changed.
+	 */
+	void updateTransform();
+
+	/**
+	 * Returns the texture coordinates of the corners in GL_QUADS order.
+	 */
+	void getTexCoords(GLfloat texCoords[8]) const;
+
 	/**
 	 * A helper function taken from http://www.opengl.org/resources/features/OGLextensions/
 	 * to help determine if an OpenGL extension is supported on the target machine at run-time
@@ -117,6 +264,9 @@ private:
 	 * @return True if extension is supported and false if it is not.
 	 */
 	bool isExtensionSupported(const char *extension) const;
+
+	// sprites hold a reference on their image, copy them with the constructor
+	Sprite &operator=(const Sprite &other);
 };
 
 #endif /* SPRITE_H_ */
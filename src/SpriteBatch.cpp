@@ -0,0 +1,160 @@
+/*
+ * SpriteBatch.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+// buffer objects are core since OpenGL 1.5 but only declared as extensions
+#define GL_GLEXT_PROTOTYPES
+
+#include <GL/glut.h>
+#include <cstddef>
+#include "SpriteBatch.h"
+#include "Sprite.h"
+#include "Profiler.h"
+
+SpriteBatch::SpriteBatch()
+{
+	vertexBuffer = 0;
+	drawCalls = 0;
+}
+
+SpriteBatch::~SpriteBatch()
+{
+	if(vertexBuffer != 0)
+	{
+		glDeleteBuffers(1, &vertexBuffer);
+	}
+}
+
+void SpriteBatch::begin()
+{
+	vertices.clear();
+	textures.clear();
+	premultiplied.clear();
+}
+
+void SpriteBatch::add(Sprite &sprite)
+{
+	GLfloat corners[8];
+	GLfloat texCoords[8];
+
+	sprite.getQuad(corners, texCoords);
+
+	for(int i = 0; i < 4; i++)
+	{
+		Vertex vertex;
+		vertex.x = corners[i * 2];
+		vertex.y = corners[i * 2 + 1];
+		vertex.s = texCoords[i * 2];
+		vertex.t = texCoords[i * 2 + 1];
+		vertices.push_back(vertex);
+	}
+
+	textures.push_back(sprite.getTexture());
+	premultiplied.push_back(sprite.isPremultiplied());
+}
+
+void SpriteBatch::flush()
+{
+	drawCalls = 0;
+
+	if(textures.empty())
+	{
+		return;
+	}
+
+	if(vertexBuffer == 0)
+	{
+		glGenBuffers(1, &vertexBuffer);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	// orphan the previous contents so the driver does not have to wait for the
+	// last frame to finish drawing from it
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(Vertex), &vertices[0]);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	draw();
+}
+
+void SpriteBatch::draw()
+{
+	Profiler::Scope scope(Profiler::BATCH_DRAW);
+
+	drawCalls = 0;
+
+	if(textures.empty() || vertexBuffer == 0)
+	{
+		return;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+
+	glEnable(GL_BLEND);
+	glEnable(GL_TEXTURE_2D);
+	glColor3f(1.0f, 1.0f, 1.0f);
+
+	glPushMatrix();
+	glLoadIdentity();
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glVertexPointer(2, GL_FLOAT, sizeof(Vertex), (const GLvoid *)offsetof(Vertex, x));
+	glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), (const GLvoid *)offsetof(Vertex, s));
+
+	// draw runs of quads sharing a texture, keeping the order they were added in
+	// so blending still composites them correctly
+	size_t first = 0;
+
+	while(first < textures.size())
+	{
+		size_t last = first + 1;
+
+		while(last < textures.size() && textures[last] == textures[first] &&
+			  premultiplied[last] == premultiplied[first])
+		{
+			last++;
+		}
+
+		glBlendFunc(premultiplied[first] ? GL_ONE : GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glBindTexture(GL_TEXTURE_2D, textures[first]);
+		glDrawArrays(GL_QUADS, first * 4, (last - first) * 4);
+		drawCalls++;
+		Profiler::countStateChanges(2);
+
+		first = last;
+	}
+
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glPopMatrix();
+
+	// the vertex buffer bound and unbound
+	Profiler::countStateChanges(2);
+	Profiler::countDrawCalls(drawCalls);
+}
+
+unsigned int SpriteBatch::getDrawCalls() const
+{
+	return drawCalls;
+}
@@ -0,0 +1,91 @@
+/*
+ * SpriteBatch.h
+ *
+ * Collects sprites for a frame and draws them with as few draw calls as
+ * possible. The corners of every sprite are transformed on the CPU and
+ * written to a single vertex buffer, which is then drawn with one call per
+ * run of sprites sharing the same texture.
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifndef SPRITEBATCH_H_
+#define SPRITEBATCH_H_
+
+#include <GL/glut.h>
+#include <vector>
+
+using namespace std;
+
+class Sprite;
+
+class SpriteBatch
+{
+public:
+	SpriteBatch();
+	virtual ~SpriteBatch();
+
+	/**
+	 * Starts collecting a new batch, forgetting any sprites that were added but
+	 * never flushed.
+	 */
+	void begin();
+
+	/**
+	 * Adds the sprite with its current position, pivot, scale and angle.
+	 * Sprites are drawn in the order they are added, so later sprites are drawn
+	 * on top of earlier ones.
+	 */
+	void add(Sprite &sprite);
+
+	/**
+	 * Uploads the collected quads and draws them. Consecutive sprites with the
+	 * same texture and the same kind of alpha are drawn with a single call.
+	 * Requires the 2D mode set up by Sprite::enable2D().
+	 */
+	void flush();
+
+	/**
+	 * Draws the quads uploaded by the last flush() again without uploading
+	 * them, e.g. once for every scissor rectangle of a partial redraw.
+	 */
+	void draw();
+
+	/**
+	 * @return The number of draw calls issued by the last flush().
+	 */
+	unsigned int getDrawCalls() const;
+
+private:
+	struct Vertex
+	{
+		GLfloat x;
+		GLfloat y;
+		GLfloat s;
+		GLfloat t;
+	};
+
+	vector<Vertex> vertices;
+	vector<GLuint> textures; // one per quad
+	vector<bool> premultiplied; // one per quad
+	GLuint vertexBuffer;
+	unsigned int drawCalls;
+};
+
+#endif /* SPRITEBATCH_H_ */
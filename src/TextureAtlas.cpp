@@ -0,0 +1,377 @@
+/*
+ * TextureAtlas.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include "TextureAtlas.h"
+#include "TextureCache.h"
+#include "Sprite.h"
+#include "PixelConvert.h"
+
+// sorts regions from the tallest to the shortest image, which keeps the skyline flat
+static bool tallerFirst(const pair<GLint, size_t> &a, const pair<GLint, size_t> &b)
+{
+	return a.first > b.first;
+}
+
+TextureAtlas::TextureAtlas(GLint padding, GLint levels)
+{
+	this->levels = max(levels, 1);
+	// at every level the regions must start on whole pixels and keep a gutter
+	alignment = 1 << (this->levels - 1);
+	this->padding = padding * alignment;
+	textureID = 0;
+	width = 0;
+	height = 0;
+	format = ImageLoader::FORMAT_BGRA;
+	premultiplied = false;
+}
+
+TextureAtlas::~TextureAtlas()
+{
+	if(textureID != 0)
+	{
+		glDeleteTextures(1, &textureID);
+	}
+}
+
+void TextureAtlas::add(Sprite *sprite)
+{
+	sprites.push_back(sprite);
+	add(sprite->getImage());
+}
+
+void TextureAtlas::add(const ImageLoader *image)
+{
+	for(size_t i = 0; i < regions.size(); i++)
+	{
+		if(regions[i].image == image)
+		{
+			return;
+		}
+	}
+
+	Region region;
+	region.image = image;
+	region.x = 0;
+	region.y = 0;
+	regions.push_back(region);
+}
+
+bool TextureAtlas::build()
+{
+	GLint maxSize = 0;
+	ImageLoader image;
+
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+
+	if(!compose(image, maxSize))
+	{
+		return false;
+	}
+
+	adopt(*this, TextureCache::createTexture(image));
+
+	return true;
+}
+
+bool TextureAtlas::compose(ImageLoader &image, GLint maxSize)
+{
+	GLint widest = 0;
+	long area = 0;
+
+	// keep the byte order of the first image so it can be copied as it is
+	format = regions.empty() ? ImageLoader::FORMAT_BGRA : regions[0].image->getFormat();
+	premultiplied = false;
+
+	for(size_t i = 0; i < regions.size(); i++)
+	{
+		premultiplied = premultiplied || regions[i].image->isPremultiplied();
+
+		GLint regionWidth = align(regions[i].image->getWidth() + 2 * padding);
+		GLint regionHeight = align(regions[i].image->getHeight() + 2 * padding);
+
+		widest = max(widest, regionWidth);
+		area += (long)regionWidth * regionHeight;
+	}
+
+	// start with a square that could hold all images and widen it until the
+	// packed images also fit vertically
+	GLint atlasWidth = max(widest, align((GLint)ceil(sqrt((double)area))));
+	GLint atlasHeight = pack(atlasWidth);
+
+	while(atlasHeight > maxSize && atlasWidth < maxSize)
+	{
+		atlasWidth = min(atlasWidth * 2, maxSize / alignment * alignment);
+		atlasHeight = pack(atlasWidth);
+	}
+
+	if(atlasWidth > maxSize || atlasHeight > maxSize || atlasHeight < 0)
+	{
+		cout << "ERROR: Images do not fit into a texture atlas of " << maxSize << "x" << maxSize << endl;
+		return false;
+	}
+
+	width = atlasWidth;
+	height = atlasHeight;
+
+	BYTE *pixels = image.create(width, height, format, premultiplied);
+
+	for(size_t i = 0; i < regions.size(); i++)
+	{
+		blit(pixels, regions[i]);
+	}
+
+	// the gutters keep the regions apart down to the last level
+	image.generateMipmaps(levels);
+
+	return true;
+}
+
+void TextureAtlas::adopt(const TextureAtlas &composed, GLuint texture)
+{
+	if(textureID != 0 && textureID != texture)
+	{
+		glDeleteTextures(1, &textureID);
+	}
+
+	textureID = texture;
+	width = composed.width;
+	height = composed.height;
+	format = composed.format;
+	premultiplied = composed.premultiplied;
+
+	for(size_t i = 0; i < regions.size() && i < composed.regions.size(); i++)
+	{
+		regions[i].x = composed.regions[i].x;
+		regions[i].y = composed.regions[i].y;
+	}
+
+	for(size_t i = 0; i < sprites.size(); i++)
+	{
+		assign(sprites[i]);
+	}
+}
+
+bool TextureAtlas::assign(Sprite *sprite) const
+{
+	for(size_t i = 0; i < regions.size(); i++)
+	{
+		if(regions[i].image == sprite->getImage())
+		{
+			sprite->setTextureRegion(textureID, regions[i].x, regions[i].y, width, height, premultiplied);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+GLint TextureAtlas::pack(GLint atlasWidth)
+{
+	vector<SkylineNode> skyline;
+	vector< pair<GLint, size_t> > order;
+	GLint packedHeight = 0;
+
+	SkylineNode ground;
+	ground.x = 0;
+	ground.y = 0;
+	ground.width = atlasWidth;
+	skyline.push_back(ground);
+
+	for(size_t i = 0; i < regions.size(); i++)
+	{
+		order.push_back(make_pair(regions[i].image->getHeight(), i));
+	}
+
+	stable_sort(order.begin(), order.end(), tallerFirst);
+
+	for(size_t i = 0; i < order.size(); i++)
+	{
+		Region &region = regions[order[i].second];
+		GLint rectWidth = align(region.image->getWidth() + 2 * padding);
+		GLint rectHeight = align(region.image->getHeight() + 2 * padding);
+		GLint bestX;
+		GLint bestY;
+
+		int index = findPosition(skyline, atlasWidth, rectWidth, rectHeight, bestX, bestY);
+
+		if(index < 0)
+		{
+			return -1;
+		}
+
+		region.x = bestX + padding;
+		region.y = bestY + padding;
+		packedHeight = max(packedHeight, bestY + rectHeight);
+
+		// raise the skyline under the new rectangle
+		SkylineNode node;
+		node.x = bestX;
+		node.y = bestY + rectHeight;
+		node.width = rectWidth;
+		skyline.insert(skyline.begin() + index, node);
+
+		for(size_t j = index + 1; j < skyline.size(); )
+		{
+			GLint overlap = node.x + node.width - skyline[j].x;
+
+			if(overlap <= 0)
+			{
+				break;
+			}
+
+			if(overlap < skyline[j].width)
+			{
+				skyline[j].x += overlap;
+				skyline[j].width -= overlap;
+				break;
+			}
+
+			skyline.erase(skyline.begin() + j);
+		}
+
+		// merge neighbours at the same height
+		for(size_t j = 0; j + 1 < skyline.size(); )
+		{
+			if(skyline[j].y == skyline[j + 1].y)
+			{
+				skyline[j].width += skyline[j + 1].width;
+				skyline.erase(skyline.begin() + j + 1);
+			}
+			else
+			{
+				j++;
+			}
+		}
+	}
+
+	return packedHeight;
+}
+
+GLint TextureAtlas::align(GLint size) const
+{
+	return (size + alignment - 1) / alignment * alignment;
+}
+
+int TextureAtlas::findPosition(const vector<SkylineNode> &skyline, GLint atlasWidth,
+							   GLint rectWidth, GLint rectHeight, GLint &bestX, GLint &bestY) const
+{
+	int bestIndex = -1;
+	GLint bestTop = 0;
+
+	for(size_t i = 0; i < skyline.size(); i++)
+	{
+		GLint x = skyline[i].x;
+
+		if(x + rectWidth > atlasWidth)
+		{
+			break;
+		}
+
+		// the rectangle rests on the highest node it spans
+		GLint y = 0;
+		GLint spanned = 0;
+
+		for(size_t j = i; spanned < rectWidth; j++)
+		{
+			y = max(y, skyline[j].y);
+			spanned += skyline[j].width;
+		}
+
+		if(bestIndex < 0 || y + rectHeight < bestTop)
+		{
+			bestIndex = i;
+			bestTop = y + rectHeight;
+			bestX = x;
+			bestY = y;
+		}
+	}
+
+	return bestIndex;
+}
+
+void TextureAtlas::blit(BYTE *pixels, const Region &region) const
+{
+	GLint imageWidth = region.image->getWidth();
+	GLint imageHeight = region.image->getHeight();
+	bool swapRedBlue = region.image->getFormat() != format;
+	bool premultiply = premultiplied && !region.image->isPremultiplied();
+
+	if(region.image->getPixelData() == NULL || imageWidth <= 0 || imageHeight <= 0)
+	{
+		return;
+	}
+
+	for(GLint row = -padding; row < imageHeight + padding; row++)
+	{
+		GLint sourceRow = min(max(row, 0), imageHeight - 1);
+		const BYTE *from = region.image->getRow(sourceRow);
+		BYTE *to = pixels + ((region.y + row) * width + region.x) * 4;
+
+		if(swapRedBlue)
+		{
+			// swapping red and blue works both ways
+			PixelConvert::bgraToRgbaRow(to, from, imageWidth);
+		}
+		else
+		{
+			memcpy(to, from, imageWidth * 4);
+		}
+
+		if(premultiply)
+		{
+			PixelConvert::premultiplyRow(to, to, imageWidth);
+		}
+
+		// repeat the edge pixels already written into the gutter
+		from = to;
+
+		for(GLint i = 1; i <= padding; i++)
+		{
+			memcpy(to - i * 4, from, 4);
+			memcpy(to + (imageWidth + i - 1) * 4, from + (imageWidth - 1) * 4, 4);
+		}
+	}
+}
+
+GLuint TextureAtlas::getTexture() const
+{
+	return textureID;
+}
+
+GLint TextureAtlas::getWidth() const
+{
+	return width;
+}
+
+GLint TextureAtlas::getHeight() const
+{
+	return height;
+}
+
+bool TextureAtlas::isPremultiplied() const
+{
+	return premultiplied;
+}
@@ -0,0 +1,170 @@
+/*
+ * TextureAtlas.h
+ *
+ * Packs the images of several sprites into a single texture so that they can
+ * all be drawn without binding another texture in between. Every sprite added
+ * to the atlas is pointed at its own sub-rectangle of the shared texture.
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifndef TEXTUREATLAS_H_
+#define TEXTUREATLAS_H_
+
+#include <GL/glut.h>
+#include <vector>
+#include "ImageLoader.h"
+
+using namespace std;
+
+class Sprite;
+
+class TextureAtlas
+{
+public:
+	/**
+	 * @param padding Number of pixels left around every image in the smallest
+	 *        mip level. The border pixels of each image are repeated into this
+	 *        gutter so filtering does not bleed neighbouring images into each
+	 *        other.
+	 * @param levels Number of mip levels. Every extra level doubles the gutter
+	 *        and the alignment of the images in the full size atlas.
+	 */
+	TextureAtlas(GLint padding = 1, GLint levels = 5);
+
+	/**
+	 * Deletes the atlas texture. Sprites using the atlas must not be drawn
+	 * anymore after this.
+	 */
+	virtual ~TextureAtlas();
+
+	/**
+	 * Adds a sprite to the atlas. Sprites sharing the same image share the same
+	 * region in the atlas. Has no effect on the sprite until build() is called.
+	 */
+	void add(Sprite *sprite);
+
+	/**
+	 * Adds an image without a sprite, e.g. to an atlas that is only composed.
+	 * The atlas does not take ownership of the image.
+	 */
+	void add(const ImageLoader *image);
+
+	/**
+	 * Packs the images of all added sprites, uploads the atlas and points every
+	 * sprite at its region. A GL context must be current.
+	 * @return True on success, false if the images do not fit in the largest
+	 *         texture supported by the driver.
+	 */
+	bool build();
+
+	/**
+	 * The part of build() that runs on the CPU: packs the images and fills in
+	 * the atlas pixels and their mip levels. Touches no GL state, so an atlas
+	 * of freshly loaded images can be composed on another thread and handed
+	 * to adopt() of the atlas in use.
+	 * @param image Receives the atlas.
+	 * @param maxSize GL_MAX_TEXTURE_SIZE, which has to be queried on the
+	 *        thread owning the GL context.
+	 * @return False if the images do not fit into maxSize x maxSize.
+	 */
+	bool compose(ImageLoader &image, GLint maxSize);
+
+	/**
+	 * Switches to a texture created elsewhere from the pixels of another
+	 * atlas' compose(), which must hold the same images in the same order
+	 * (their sizes may differ). The old texture is deleted and every sprite
+	 * is pointed at its region in the new one. A GL context must be current.
+	 */
+	void adopt(const TextureAtlas &composed, GLuint texture);
+
+	/**
+	 * Points a sprite at the region of its image, e.g. a copy of a sprite made
+	 * before adopt() switched textures.
+	 * @return False if its image is not in the atlas.
+	 */
+	bool assign(Sprite *sprite) const;
+
+	GLuint getTexture() const;
+	GLint getWidth() const;
+	GLint getHeight() const;
+
+	/**
+	 * @return True if the atlas holds premultiplied colours, which is the case
+	 *         as soon as one of its images does.
+	 */
+	bool isPremultiplied() const;
+
+private:
+	struct Region
+	{
+		const ImageLoader *image;
+		GLint x;
+		GLint y;
+	};
+
+	// a horizontal segment of the top edge of the packed area
+	struct SkylineNode
+	{
+		GLint x;
+		GLint y;
+		GLint width;
+	};
+
+	vector<Sprite *> sprites;
+	vector<Region> regions;
+	GLint padding;
+	GLint levels;
+	GLint alignment;
+	GLuint textureID;
+	GLint width;
+	GLint height;
+	// layout of the atlas pixels, taken from the images it holds
+	ImageLoader::PixelFormat format;
+	bool premultiplied;
+
+	/**
+	 * Places every region with a skyline bottom-left packer.
+	 * @return The height of the packed area, or -1 if an image is wider than
+	 *         atlasWidth.
+	 */
+	GLint pack(GLint atlasWidth);
+
+	/**
+	 * Rounds the size up to the alignment of the regions.
+	 */
+	GLint align(GLint size) const;
+
+	/**
+	 * Finds the lowest position where a rectangle of the given size fits on the
+	 * skyline.
+	 * @return The index of the skyline node the rectangle starts at, or -1.
+	 */
+	int findPosition(const vector<SkylineNode> &skyline, GLint atlasWidth,
+					 GLint rectWidth, GLint rectHeight, GLint &bestX, GLint &bestY) const;
+
+	/**
+	 * Copies the image into the atlas pixels and repeats its border pixels into
+	 * the surrounding padding. Images of a different format or alpha than the
+	 * atlas are converted on the way.
+	 */
+	void blit(BYTE *pixels, const Region &region) const;
+};
+
+#endif /* TEXTUREATLAS_H_ */
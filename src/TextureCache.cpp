@@ -0,0 +1,279 @@
+/*
+ * TextureCache.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <cstring>
+#include "TextureCache.h"
+#include "ImageLoader.h"
+#include "AssetPack.h"
+
+map<string, TextureCache::Entry> TextureCache::entries;
+const AssetPack *TextureCache::assetPack = NULL;
+ImageLoader::LoadMode TextureCache::loadMode = ImageLoader::NATIVE;
+unsigned long TextureCache::pendingBytes = 0;
+unsigned long TextureCache::frameBytes = 0;
+unsigned long TextureCache::totalBytes = 0;
+
+ImageLoader *TextureCache::acquire(const string &filename)
+{
+	map<string, Entry>::iterator it = entries.find(filename);
+
+	if(it == entries.end())
+	{
+		insert(filename, loadImage(filename));
+		it = entries.find(filename);
+	}
+
+	it->second.refCount++;
+	return it->second.image;
+}
+
+ImageLoader *TextureCache::loadImage(const string &filename)
+{
+	ImageLoader *image;
+
+	if(assetPack != NULL && assetPack->find(filename) != NULL)
+	{
+		image = new ImageLoader();
+		image->loadPack(*assetPack, filename);
+	}
+	else
+	{
+		image = new ImageLoader(filename.c_str(), loadMode);
+	}
+
+	image->generateMipmaps();
+
+	return image;
+}
+
+void TextureCache::insert(const string &filename, ImageLoader *image)
+{
+	if(entries.find(filename) != entries.end())
+	{
+		delete image;
+		return;
+	}
+
+	Entry entry;
+	entry.image = image;
+	entry.textureID = 0;
+	entry.refCount = 0;
+	entries.insert(make_pair(filename, entry));
+}
+
+bool TextureCache::contains(const string &filename)
+{
+	return entries.find(filename) != entries.end();
+}
+
+void TextureCache::setAssetPack(const AssetPack *pack)
+{
+	assetPack = pack;
+}
+
+void TextureCache::setLoadMode(ImageLoader::LoadMode mode)
+{
+	loadMode = mode;
+}
+
+void TextureCache::release(const string &filename)
+{
+	map<string, Entry>::iterator it = entries.find(filename);
+
+	if(it == entries.end())
+	{
+		return;
+	}
+
+	if(--it->second.refCount > 0)
+	{
+		return;
+	}
+
+	// the texture only exists if the image was drawn at least once
+	if(it->second.textureID != 0)
+	{
+		glDeleteTextures(1, &it->second.textureID);
+	}
+
+	delete it->second.image;
+	entries.erase(it);
+}
+
+GLuint TextureCache::getTexture(const string &filename)
+{
+	map<string, Entry>::iterator it = entries.find(filename);
+
+	if(it == entries.end())
+	{
+		return 0;
+	}
+
+	Entry &entry = it->second;
+
+	if(entry.textureID == 0)
+	{
+		// the rows go up as they are stored, Sprite flips the texture
+		// coordinates of images stored top row first
+		entry.textureID = createTexture(*entry.image);
+	}
+
+	return entry.textureID;
+}
+
+void TextureCache::replace(const string &filename, ImageLoader *image)
+{
+	map<string, Entry>::iterator it = entries.find(filename);
+
+	if(it != entries.end())
+	{
+		it->second.image->swap(*image);
+
+		if(it->second.textureID != 0)
+		{
+			glBindTexture(GL_TEXTURE_2D, it->second.textureID);
+			fillTexture(*it->second.image, false);
+		}
+	}
+
+	delete image;
+}
+
+GLuint TextureCache::createTexture(const ImageLoader &image, bool fromPixelBuffer)
+{
+	GLuint textureID;
+
+	// Generate one texture ID
+	glGenTextures(1, &textureID);
+	glBindTexture(GL_TEXTURE_2D, textureID);
+	fillTexture(image, fromPixelBuffer);
+
+	return textureID;
+}
+
+void TextureCache::fillTexture(const ImageLoader &image, bool fromPixelBuffer)
+{
+	GLenum format = image.getFormat() == ImageLoader::FORMAT_BGRA ? GL_BGRA : GL_RGBA;
+	int levels = image.getMipLevelCount();
+	unsigned long offset = 0;
+
+	// Enable trilinear filtering on this texture, so sprites drawn smaller than
+	// their image read a level of about their size instead of aliasing
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+	// same as texture rectangles, which never repeat
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	for(int level = 0; level < levels; level++)
+	{
+		GLsizei width = image.getMipWidth(level);
+		GLsizei height = image.getMipHeight(level);
+
+		if(fromPixelBuffer)
+		{
+			// with a pixel buffer bound the pointer is an offset into it
+			upload(width, height, (const GLvoid *)offset, format, 0, level);
+			offset += (unsigned long)width * height * 4;
+		}
+		else
+		{
+			upload(width, height, image.getMipLevel(level), format, image.getMipStride(level) / 4, level);
+		}
+	}
+}
+
+unsigned long TextureCache::packLevels(const ImageLoader &image, BYTE *destination)
+{
+	unsigned long size = 0;
+
+	for(int level = 0; level < image.getMipLevelCount(); level++)
+	{
+		LONG width = image.getMipWidth(level);
+		LONG height = image.getMipHeight(level);
+		LONG rowBytes = width * 4;
+
+		if(destination != NULL)
+		{
+			const BYTE *source = image.getMipLevel(level);
+			LONG stride = image.getMipStride(level);
+
+			// rows stay in the order they are stored in, like createTexture() uploads them
+			for(LONG row = 0; row < height; row++)
+			{
+				memcpy(destination + size + (unsigned long)row * rowBytes, source + (unsigned long)row * stride, rowBytes);
+			}
+		}
+
+		size += (unsigned long)rowBytes * height;
+	}
+
+	return size;
+}
+
+void TextureCache::upload(GLsizei width, GLsizei height, const GLvoid *pixels,
+						  GLenum format, GLint rowLength, GLint level)
+{
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength == width ? 0 : rowLength);
+
+	// Write the 32-bit texture buffer to video memory. BGRA is the order most
+	// drivers store textures in, so the bitmap pixels go up unconverted.
+	glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, width, height,
+				 0, format, GL_UNSIGNED_BYTE, pixels);
+
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+	pendingBytes += (unsigned long)width * height * 4;
+}
+
+void TextureCache::endFrame()
+{
+	frameBytes = pendingBytes;
+	totalBytes += pendingBytes;
+	pendingBytes = 0;
+}
+
+unsigned long TextureCache::getFrameBytesUploaded()
+{
+	return frameBytes;
+}
+
+unsigned long TextureCache::getTotalBytesUploaded()
+{
+	return totalBytes + pendingBytes;
+}
+
+unsigned int TextureCache::getTextureCount()
+{
+	unsigned int count = 0;
+
+	for(map<string, Entry>::const_iterator it = entries.begin(); it != entries.end(); ++it)
+	{
+		if(it->second.textureID != 0)
+		{
+			count++;
+		}
+	}
+
+	return count;
+}
@@ -0,0 +1,169 @@
+/*
+ * TextureCache.h
+ *
+ * Keeps one decoded image and one OpenGL texture per image path so that every
+ * Sprite showing the same bitmap shares them. Entries are reference counted
+ * and freed when the last Sprite using them is destroyed.
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifndef TEXTURECACHE_H_
+#define TEXTURECACHE_H_
+
+#include <GL/glut.h>
+#include <map>
+#include <string>
+#include "ImageLoader.h"
+
+using namespace std;
+
+class AssetPack;
+
+class TextureCache
+{
+public:
+	/**
+	 * Returns the image for the given path, loading it from disk the first time
+	 * it is requested. Every call must be matched by a call to release().
+	 * Images found in the asset pack are loaded from there instead.
+	 */
+	static ImageLoader *acquire(const string &filename);
+
+	/**
+	 * Decodes an image the way acquire() does, from the asset pack or the
+	 * bitmap, without adding it to the cache. Touches no GL state, so it may
+	 * run on any thread while the asset pack stays open.
+	 * @return The image, for the caller to delete.
+	 */
+	static ImageLoader *loadImage(const string &filename);
+
+	/**
+	 * Adds an image decoded elsewhere, e.g. by an AssetLoader, for acquire()
+	 * to find. The cache takes ownership of the image; if the path is cached
+	 * already the given image is deleted instead. Images nobody acquires stay
+	 * in memory.
+	 */
+	static void insert(const string &filename, ImageLoader *image);
+
+	/**
+	 * @return True if the image is in the cache, i.e. acquire() will not load it.
+	 */
+	static bool contains(const string &filename);
+
+	/**
+	 * Sets the asset pack images are looked up in before falling back to the
+	 * bitmap files, NULL to always load bitmaps. The pack must stay open while
+	 * images are being acquired.
+	 */
+	static void setAssetPack(const AssetPack *pack);
+
+	/**
+	 * Sets how bitmaps are loaded, NATIVE by default: their pixels are used
+	 * in place in the mapped file. CONVERT copies them out, for files that
+	 * may be written while in use. Set it before images are loaded.
+	 */
+	static void setLoadMode(ImageLoader::LoadMode mode);
+
+	/**
+	 * Drops one reference to the given path. The image and its texture are
+	 * deleted once nobody references them anymore.
+	 */
+	static void release(const string &filename);
+
+	/**
+	 * Returns the texture name for the given path, uploading the image to video
+	 * memory the first time it is needed. A GL context must be current.
+	 * The path must have been acquired before.
+	 */
+	static GLuint getTexture(const string &filename);
+
+	/**
+	 * Replaces the pixels of a cached image with those of a new one, e.g. the
+	 * bitmap reloaded after it was edited, keeping the ImageLoader sprites
+	 * point at. If the image has a texture of its own it is uploaded again
+	 * right away, under the same name.
+	 * @param image The new image, deleted once its pixels were taken over. It
+	 *        is deleted as well if the path is not cached.
+	 */
+	static void replace(const string &filename, ImageLoader *image);
+
+	/**
+	 * Creates a GL_TEXTURE_2D from the image and all of its mip levels, with
+	 * trilinear filtering if there is more than one level. The sides do not
+	 * need to be powers of two. The caller owns the returned texture.
+	 * @param fromPixelBuffer Read the levels from the bound
+	 *        GL_PIXEL_UNPACK_BUFFER, laid out by packLevels(), instead of the
+	 *        image. The upload then returns without waiting for the copy.
+	 */
+	static GLuint createTexture(const ImageLoader &image, bool fromPixelBuffer = false);
+
+	/**
+	 * Copies all mip levels of the image one after another, tightly packed,
+	 * the way createTexture() reads them from a pixel buffer.
+	 * @param destination NULL to only get the size.
+	 * @return The number of bytes the levels take.
+	 */
+	static unsigned long packLevels(const ImageLoader &image, BYTE *destination);
+
+	/**
+	 * Uploads the given pixels into a level of the currently bound 2D texture
+	 * and adds the size of the upload to the statistics.
+	 * @param format GL_RGBA or GL_BGRA, the order of the bytes in each pixel.
+	 * @param rowLength Pixels from one row to the next, 0 if the rows are
+	 *        tightly packed.
+	 */
+	static void upload(GLsizei width, GLsizei height, const GLvoid *pixels,
+					   GLenum format = GL_RGBA, GLint rowLength = 0, GLint level = 0);
+
+	/**
+	 * Marks the end of a frame. The bytes uploaded since the previous call are
+	 * made available through getFrameBytesUploaded().
+	 */
+	static void endFrame();
+
+	// statistics
+	static unsigned long getFrameBytesUploaded();
+	static unsigned long getTotalBytesUploaded();
+	static unsigned int getTextureCount();
+
+private:
+	struct Entry
+	{
+		ImageLoader *image;
+		GLuint textureID;
+		int refCount;
+	};
+
+	static map<string, Entry> entries;
+
+	/**
+	 * Sets the filtering of the bound texture and uploads all levels of the
+	 * image into it.
+	 */
+	static void fillTexture(const ImageLoader &image, bool fromPixelBuffer);
+
+	static const AssetPack *assetPack;
+	static ImageLoader::LoadMode loadMode;
+	static unsigned long pendingBytes;
+	static unsigned long frameBytes;
+	static unsigned long totalBytes;
+};
+
+#endif /* TEXTURECACHE_H_ */
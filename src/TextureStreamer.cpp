@@ -0,0 +1,350 @@
+/*
+ * TextureStreamer.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+// buffer mapping and fences are core since OpenGL 3.2 but only declared as extensions
+#define GL_GLEXT_PROTOTYPES
+
+#include <GL/glut.h>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "TextureStreamer.h"
+#include "TextureCache.h"
+
+TextureStreamer::TextureStreamer()
+{
+	stopping = false;
+	pixelBuffers = -1;
+
+	for(int i = 0; i < STREAMER_BUFFERS; i++)
+	{
+		buffers[i] = 0;
+		bufferUsed[i] = false;
+	}
+
+	worker = thread(&TextureStreamer::run, this);
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	{
+		unique_lock<mutex> guard(lock);
+		stopping = true;
+	}
+
+	workQueued.notify_all();
+	worker.join();
+
+	for(size_t i = 0; i < jobs.size(); i++)
+	{
+		Job *job = jobs[i];
+
+		if(job->stage == FILLING || job->stage == FILLED)
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[job->buffer]);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+
+		if(job->fence != NULL)
+		{
+			glDeleteSync(job->fence);
+		}
+
+		if(job->texture != 0)
+		{
+			glDeleteTextures(1, &job->texture);
+		}
+
+		delete job->image;
+		delete job;
+	}
+
+	if(pixelBuffers > 0)
+	{
+		glDeleteBuffers(STREAMER_BUFFERS, buffers);
+	}
+}
+
+void TextureStreamer::load(Producer produce, Consumer consume)
+{
+	Job *job = new Job();
+
+	job->produce = produce;
+	job->consume = consume;
+	job->stage = PRODUCING;
+	job->image = NULL;
+	job->buffer = -1;
+	job->destination = NULL;
+	job->texture = 0;
+	job->fence = NULL;
+
+	{
+		unique_lock<mutex> guard(lock);
+		jobs.push_back(job);
+		work.push_back(job);
+	}
+
+	workQueued.notify_one();
+}
+
+bool TextureStreamer::update()
+{
+	if(pixelBuffers < 0)
+	{
+		// mapping buffer ranges and fences are core since OpenGL 3.2
+		const char *version = (const char *)glGetString(GL_VERSION);
+		const char *extensions = (const char *)glGetString(GL_EXTENSIONS);
+		int major = 0;
+		int minor = 0;
+
+		if(version != NULL)
+		{
+			sscanf(version, "%d.%d", &major, &minor);
+		}
+
+		pixelBuffers = major > 3 || (major == 3 && minor >= 2) ||
+					   (extensions != NULL && strstr(extensions, "GL_ARB_sync") != NULL &&
+						strstr(extensions, "GL_ARB_map_buffer_range") != NULL &&
+						strstr(extensions, "GL_ARB_pixel_buffer_object") != NULL);
+
+		if(pixelBuffers)
+		{
+			glGenBuffers(STREAMER_BUFFERS, buffers);
+		}
+	}
+
+	// hand over finished textures, oldest first so a newer texture is never
+	// replaced by an older one
+	for(;;)
+	{
+		Job *job;
+
+		{
+			unique_lock<mutex> guard(lock);
+
+			if(jobs.empty())
+			{
+				break;
+			}
+
+			job = jobs.front();
+
+			if(job->stage == PRODUCED && job->image == NULL)
+			{
+				// the producer gave up
+				jobs.pop_front();
+				delete job;
+				continue;
+			}
+
+			if(job->stage != UPLOADING)
+			{
+				break;
+			}
+		}
+
+		if(job->fence != NULL)
+		{
+			if(glClientWaitSync(job->fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED)
+			{
+				break;
+			}
+
+			glDeleteSync(job->fence);
+			job->fence = NULL;
+		}
+
+		if(job->buffer >= 0)
+		{
+			bufferUsed[job->buffer] = false;
+		}
+
+		{
+			unique_lock<mutex> guard(lock);
+			jobs.pop_front();
+		}
+
+		job->consume(job->image, job->texture);
+		delete job;
+	}
+
+	// the jobs waiting for this thread, in order
+	vector<Job *> ready;
+
+	{
+		unique_lock<mutex> guard(lock);
+
+		for(size_t i = 0; i < jobs.size(); i++)
+		{
+			if((jobs[i]->stage == PRODUCED && jobs[i]->image != NULL) || jobs[i]->stage == FILLED)
+			{
+				ready.push_back(jobs[i]);
+			}
+		}
+	}
+
+	for(size_t i = 0; i < ready.size(); i++)
+	{
+		if(ready[i]->stage == PRODUCED)
+		{
+			startUpload(ready[i]);
+		}
+		else
+		{
+			finishUpload(ready[i]);
+		}
+	}
+
+	return isBusy();
+}
+
+bool TextureStreamer::isBusy()
+{
+	unique_lock<mutex> guard(lock);
+	return !jobs.empty();
+}
+
+void TextureStreamer::startUpload(Job *job)
+{
+	int buffer = -1;
+
+	for(int i = 0; i < STREAMER_BUFFERS && pixelBuffers > 0; i++)
+	{
+		if(!bufferUsed[i])
+		{
+			buffer = i;
+			break;
+		}
+	}
+
+	if(pixelBuffers > 0 && buffer < 0)
+	{
+		// both buffers are busy, try again on the next update
+		return;
+	}
+
+	BYTE *destination = NULL;
+
+	if(buffer >= 0)
+	{
+		GLsizeiptr size = TextureCache::packLevels(*job->image, NULL);
+
+		// new storage every time, the driver may still be reading the old one
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[buffer]);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+		destination = (BYTE *)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+											   GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	if(destination == NULL)
+	{
+		// no buffer to copy into, upload from the image right here
+		job->texture = TextureCache::createTexture(*job->image);
+
+		unique_lock<mutex> guard(lock);
+		job->stage = UPLOADING;
+		return;
+	}
+
+	bufferUsed[buffer] = true;
+	job->buffer = buffer;
+	job->destination = destination;
+
+	{
+		unique_lock<mutex> guard(lock);
+		job->stage = FILLING;
+		work.push_back(job);
+	}
+
+	workQueued.notify_one();
+}
+
+void TextureStreamer::finishUpload(Job *job)
+{
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[job->buffer]);
+
+	// the contents can get lost while mapped, e.g. on a mode switch
+	bool intact = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+
+	if(intact)
+	{
+		job->texture = TextureCache::createTexture(*job->image, true);
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	if(!intact)
+	{
+		job->texture = TextureCache::createTexture(*job->image);
+	}
+
+	job->destination = NULL;
+	job->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	unique_lock<mutex> guard(lock);
+	job->stage = UPLOADING;
+}
+
+void TextureStreamer::run()
+{
+	for(;;)
+	{
+		Job *job;
+		Stage stage;
+
+		{
+			unique_lock<mutex> guard(lock);
+
+			while(work.empty() && !stopping)
+			{
+				workQueued.wait(guard);
+			}
+
+			if(stopping)
+			{
+				return;
+			}
+
+			job = work.front();
+			work.pop_front();
+			stage = job->stage;
+		}
+
+		if(stage == PRODUCING)
+		{
+			ImageLoader *image = job->produce();
+
+			unique_lock<mutex> guard(lock);
+			job->image = image;
+			job->stage = PRODUCED;
+		}
+		else
+		{
+			TextureCache::packLevels(*job->image, job->destination);
+
+			unique_lock<mutex> guard(lock);
+			job->stage = FILLED;
+		}
+	}
+}
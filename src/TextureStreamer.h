@@ -0,0 +1,138 @@
+/*
+ * TextureStreamer.h
+ *
+ * Uploads textures without stalling the thread that draws. An image is
+ * produced (decoded, composed into an atlas, ...) on a worker thread, which
+ * also copies it into one of two pixel unpack buffers mapped for it; the GL
+ * thread then starts the upload from the buffer, which returns right away,
+ * and puts a fence behind it. Once the fence signals the texture is complete
+ * and is handed over to be swapped in for the old one. With two buffers one
+ * image can be copied while the previous one is uploading.
+ *
+ * Drivers without pixel buffers or fences get the texture uploaded the usual
+ * way, still with the image produced on the worker.
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifndef TEXTURESTREAMER_H_
+#define TEXTURESTREAMER_H_
+
+#include <GL/glut.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "ImageLoader.h"
+
+using namespace std;
+
+// pixel buffers filled and uploaded in turn
+#define STREAMER_BUFFERS 2
+
+class TextureStreamer
+{
+public:
+	/**
+	 * Runs on the worker thread and returns the image to upload, or NULL to
+	 * drop the job. It must not touch GL state or images the GL thread uses.
+	 */
+	typedef function<ImageLoader *()> Producer;
+
+	/**
+	 * Runs on the GL thread with the image and its texture once the texture
+	 * is complete, and owns both from then on.
+	 */
+	typedef function<void(ImageLoader *image, GLuint texture)> Consumer;
+
+	/**
+	 * Starts the worker. The pixel buffers are created by the first update().
+	 */
+	TextureStreamer();
+
+	/**
+	 * Stops the worker and frees the buffers and the unfinished jobs. The GL
+	 * context the streamer was updated with must still be current.
+	 */
+	virtual ~TextureStreamer();
+
+	/**
+	 * Queues a texture. Jobs are consumed in the order they were queued.
+	 */
+	void load(Producer produce, Consumer consume);
+
+	/**
+	 * Moves the jobs along without waiting for the worker or the GPU, to be
+	 * called regularly (e.g. every frame) on the thread owning the GL
+	 * context. Consumers are called from here.
+	 * @return True while jobs are left.
+	 */
+	bool update();
+
+	/**
+	 * @return True while jobs are left.
+	 */
+	bool isBusy();
+
+private:
+	enum Stage
+	{
+		PRODUCING,
+		PRODUCED,
+		FILLING,
+		FILLED,
+		UPLOADING
+	};
+
+	struct Job
+	{
+		Producer produce;
+		Consumer consume;
+		Stage stage;
+		ImageLoader *image;
+		// the mapped buffer the worker copies the image into
+		int buffer;
+		BYTE *destination;
+		GLuint texture;
+		GLsync fence;
+	};
+
+	thread worker;
+	mutex lock;
+	condition_variable workQueued;
+	deque<Job *> jobs;
+	// jobs the worker has to produce or fill, in order
+	deque<Job *> work;
+	bool stopping;
+
+	GLuint buffers[STREAMER_BUFFERS];
+	bool bufferUsed[STREAMER_BUFFERS];
+	int pixelBuffers; // -1 unknown, 0 unsupported, 1 supported
+
+	void run();
+	void startUpload(Job *job);
+	void finishUpload(Job *job);
+
+	// the worker cannot be copied along with the streamer
+	TextureStreamer(const TextureStreamer &other);
+	TextureStreamer &operator=(const TextureStreamer &other);
+};
+
+#endif /* TEXTURESTREAMER_H_ */
@@ -0,0 +1,605 @@
+/*
+ * TimeZone.cpp
+ *
+ * The TZif format is described in RFC 8536, the TZ strings in POSIX
+ * (XBD 8.3).
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <sys/stat.h>
+#include "TimeZone.h"
+
+#define ZONEINFO_DIRECTORY "/usr/share/zoneinfo"
+#define SYSTEM_ZONE_FILE "/etc/localtime"
+#define SECONDS_PER_DAY 86400L
+#define SECONDS_PER_HOUR 3600L
+// sizes in the TZif header
+#define TZIF_HEADER_SIZE 44
+#define TZIF_TYPE_SIZE 6
+// the largest zone file read, real ones are a few kilobytes
+#define TZIF_MAX_SIZE (1 << 20)
+// zones find() loads at most
+#define MAX_ZONES 1024
+
+static const time_t BEGINNING = numeric_limits<time_t>::min();
+static const time_t END = numeric_limits<time_t>::max();
+
+static mutex zonesLock;
+static map<string, TimeZone *> zones;
+
+static long floorDivide(long long value, long divisor)
+{
+	return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+/**
+ * Days from 1970-01-01 to the given date, see
+ * http://howardhinnant.github.io/date_algorithms.html
+ */
+static long daysFromCivil(long year, int month, int day)
+{
+	year -= month <= 2;
+	long era = (year >= 0 ? year : year - 399) / 400;
+	long yearOfEra = year - era * 400;
+	long dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+	long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+
+	return era * 146097 + dayOfEra - 719468;
+}
+
+/**
+ * @return The year, in UTC, of the given time.
+ */
+static long yearOf(time_t unixTime)
+{
+	long days = floorDivide(unixTime, SECONDS_PER_DAY) + 719468;
+	long era = (days >= 0 ? days : days - 146096) / 146097;
+	long dayOfEra = days - era * 146097;
+	long yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+	long dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+	long monthIndex = (5 * dayOfYear + 2) / 153;
+
+	// the year of the algorithm starts in March
+	return yearOfEra + era * 400 + (monthIndex >= 10);
+}
+
+static bool isLeapYear(long year)
+{
+	return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+static int daysInMonth(long year, int month)
+{
+	static const int days[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+	return month == 2 && isLeapYear(year) ? 29 : days[month - 1];
+}
+
+static long long readBigEndian(const unsigned char *bytes, int size)
+{
+	unsigned long long value = 0;
+
+	for(int i = 0; i < size; i++)
+	{
+		value = value << 8 | bytes[i];
+	}
+
+	// sign extend 32-bit values
+	if(size == 4)
+	{
+		return (int)value;
+	}
+
+	return (long long)value;
+}
+
+/**
+ * Reads a zone abbreviation, letters or anything between < and >.
+ * @return The first character after it, NULL if there is none.
+ */
+static const char *parseAbbreviation(const char *text)
+{
+	if(*text == '<')
+	{
+		const char *end = strchr(text, '>');
+		return end != NULL ? end + 1 : NULL;
+	}
+
+	const char *start = text;
+
+	while(isalpha((unsigned char)*text))
+	{
+		text++;
+	}
+
+	return text - start >= 3 ? text : NULL;
+}
+
+/**
+ * Reads [+|-]hh[:mm[:ss]].
+ * @return The first character after it, NULL if there is none.
+ */
+static const char *parseTime(const char *text, long &seconds)
+{
+	long sign = 1;
+	long parts[3] = { 0, 0, 0 };
+
+	if(*text == '+' || *text == '-')
+	{
+		sign = *text == '-' ? -1 : 1;
+		text++;
+	}
+
+	if(!isdigit((unsigned char)*text))
+	{
+		return NULL;
+	}
+
+	for(int i = 0; i < 3; i++)
+	{
+		char *end;
+		parts[i] = strtol(text, &end, 10);
+		text = end;
+
+		if(i == 2 || *text != ':' || !isdigit((unsigned char)text[1]))
+		{
+			break;
+		}
+
+		text++;
+	}
+
+	seconds = sign * (parts[0] * SECONDS_PER_HOUR + parts[1] * 60 + parts[2]);
+
+	return text;
+}
+
+TimeZone::TimeZone(const string &name)
+{
+	const char *tz = getenv("TZ");
+	string spec = name.empty() && tz != NULL ? tz : name;
+
+	this->name = name;
+	initialOffset = 0;
+	hasRule = false;
+
+	if(!spec.empty() && spec[0] == ':')
+	{
+		spec.erase(0, 1);
+	}
+
+	if(name.empty() && tz == NULL)
+	{
+		loaded = loadFile(SYSTEM_ZONE_FILE);
+	}
+	else if(spec.empty())
+	{
+		// an empty TZ means UTC
+		loaded = true;
+	}
+	else if(spec[0] == '/')
+	{
+		loaded = loadFile(spec);
+	}
+	else
+	{
+		const char *directory = getenv("TZDIR");
+		string path = string(directory != NULL ? directory : ZONEINFO_DIRECTORY) + "/" + spec;
+
+		loaded = spec.find("..") == string::npos && loadFile(path);
+
+		if(!loaded)
+		{
+			loaded = hasRule = parseRule(spec);
+		}
+	}
+
+	if(!loaded)
+	{
+		transitions.clear();
+		offsets.clear();
+		initialOffset = 0;
+		hasRule = false;
+	}
+}
+
+const TimeZone *TimeZone::get(const string &name)
+{
+	unique_lock<mutex> guard(zonesLock);
+	map<string, TimeZone *>::iterator it = zones.find(name);
+
+	if(it == zones.end())
+	{
+		it = zones.insert(make_pair(name, new TimeZone(name))).first;
+
+		if(!it->second->loaded)
+		{
+			const char *tz = getenv("TZ");
+			printf("Warning: unknown timezone %s, using UTC instead\n", name.empty() && tz != NULL ? tz : name.c_str());
+		}
+	}
+
+	return it->second;
+}
+
+const TimeZone *TimeZone::find(const string &name)
+{
+	// anything else is a file name
+	if(name.empty() || name[0] == '/' || name[0] == ':' || name.find("..") != string::npos)
+	{
+		return NULL;
+	}
+
+	unique_lock<mutex> guard(zonesLock);
+	map<string, TimeZone *>::iterator it = zones.find(name);
+
+	if(it != zones.end())
+	{
+		return it->second->loaded ? it->second : NULL;
+	}
+
+	if(zones.size() >= MAX_ZONES)
+	{
+		return NULL;
+	}
+
+	TimeZone *zone = new TimeZone(name);
+
+	if(!zone->loaded)
+	{
+		delete zone;
+		return NULL;
+	}
+
+	zones.insert(make_pair(name, zone));
+
+	return zone;
+}
+
+const string &TimeZone::getName() const
+{
+	return name;
+}
+
+bool TimeZone::loadFile(const string &path)
+{
+	struct stat status;
+
+	// not a device or a pipe that never ends
+	if(stat(path.c_str(), &status) != 0 || !S_ISREG(status.st_mode) || status.st_size > TZIF_MAX_SIZE)
+	{
+		return false;
+	}
+
+	ifstream in(path.c_str(), ios::binary);
+
+	if(!in)
+	{
+		return false;
+	}
+
+	stringstream contents;
+	contents << in.rdbuf();
+	string data = contents.str();
+	const unsigned char *bytes = (const unsigned char *)data.data();
+	size_t size = data.size();
+
+	if(size < TZIF_HEADER_SIZE || memcmp(bytes, "TZif", 4) != 0)
+	{
+		return false;
+	}
+
+	// version 1 has 32-bit times, later versions repeat the data with 64-bit
+	// times after it, and the TZ string for later times after that
+	int timeSize = 4;
+	size_t offset = 0;
+
+	for(int pass = 0; pass < 2; pass++)
+	{
+		if(offset + TZIF_HEADER_SIZE > size)
+		{
+			return false;
+		}
+
+		const unsigned char *header = bytes + offset;
+		long long utcCount = readBigEndian(header + 20, 4);
+		long long standardCount = readBigEndian(header + 24, 4);
+		long long leapCount = readBigEndian(header + 28, 4);
+		long long timeCount = readBigEndian(header + 32, 4);
+		long long typeCount = readBigEndian(header + 36, 4);
+		long long charCount = readBigEndian(header + 40, 4);
+		size_t dataSize = timeCount * (timeSize + 1) + typeCount * TZIF_TYPE_SIZE + charCount +
+						  leapCount * (timeSize + 4) + standardCount + utcCount;
+
+		if(utcCount < 0 || standardCount < 0 || leapCount < 0 || timeCount < 0 || typeCount < 1 || charCount < 0 ||
+		   offset + TZIF_HEADER_SIZE + dataSize > size)
+		{
+			return false;
+		}
+
+		if(pass == 0 && header[4] >= '2')
+		{
+			// skip to the 64-bit data
+			offset += TZIF_HEADER_SIZE + dataSize;
+			timeSize = 8;
+			continue;
+		}
+
+		const unsigned char *times = header + TZIF_HEADER_SIZE;
+		const unsigned char *typeIndices = times + timeCount * timeSize;
+		const unsigned char *types = typeIndices + timeCount;
+
+		transitions.resize(timeCount);
+		offsets.resize(timeCount);
+
+		for(long long i = 0; i < timeCount; i++)
+		{
+			int type = typeIndices[i];
+
+			if(type >= typeCount)
+			{
+				return false;
+			}
+
+			transitions[i] = readBigEndian(times + i * timeSize, timeSize);
+			offsets[i] = readBigEndian(types + type * TZIF_TYPE_SIZE, 4);
+		}
+
+		// the first type is the one in effect before the first transition
+		initialOffset = readBigEndian(types, 4);
+
+		// the TZ string between two newlines at the very end
+		size_t footer = offset + TZIF_HEADER_SIZE + dataSize;
+
+		if(timeSize == 8 && footer < size && bytes[footer] == '\n')
+		{
+			size_t end = data.find('\n', footer + 1);
+
+			if(end != string::npos && end > footer + 1)
+			{
+				hasRule = parseRule(data.substr(footer + 1, end - footer - 1));
+			}
+		}
+
+		break;
+	}
+
+	return true;
+}
+
+bool TimeZone::parseRule(const string &text)
+{
+	const char *next = parseAbbreviation(text.c_str());
+	long seconds;
+
+	if(next == NULL || (next = parseTime(next, seconds)) == NULL)
+	{
+		return false;
+	}
+
+	// POSIX counts hours west of Greenwich
+	rule.standardOffset = -seconds;
+	rule.daylightOffset = rule.standardOffset + SECONDS_PER_HOUR;
+	rule.daylight = false;
+
+	if(*next != '\0')
+	{
+		if((next = parseAbbreviation(next)) == NULL)
+		{
+			return false;
+		}
+
+		rule.daylight = true;
+
+		if(*next != ',' && *next != '\0')
+		{
+			if((next = parseTime(next, seconds)) == NULL)
+			{
+				return false;
+			}
+
+			rule.daylightOffset = -seconds;
+		}
+
+		// the rules of the US if none are given
+		string dates = *next == ',' ? next : ",M3.2.0,M11.1.0";
+		const char *date = dates.c_str();
+		RuleDate *targets[] = { &rule.start, &rule.end };
+
+		for(int i = 0; i < 2; i++)
+		{
+			RuleDate &target = *targets[i];
+			char *end;
+
+			if(*date++ != ',')
+			{
+				return false;
+			}
+
+			target.week = 0;
+			target.month = 0;
+			target.time = 2 * SECONDS_PER_HOUR;
+
+			if(*date == 'M')
+			{
+				target.kind = 'M';
+				target.month = strtol(date + 1, &end, 10);
+
+				if(*end != '.')
+				{
+					return false;
+				}
+
+				target.week = strtol(end + 1, &end, 10);
+
+				if(*end != '.')
+				{
+					return false;
+				}
+
+				target.day = strtol(end + 1, &end, 10);
+
+				if(target.month < 1 || target.month > 12 || target.week < 1 || target.week > 5 ||
+				   target.day < 0 || target.day > 6)
+				{
+					return false;
+				}
+			}
+			else
+			{
+				target.kind = *date == 'J' ? 'J' : 'D';
+				target.day = strtol(date + (*date == 'J'), &end, 10);
+
+				if(end == date || target.day < (target.kind == 'J') || target.day > 365)
+				{
+					return false;
+				}
+			}
+
+			date = end;
+
+			if(*date == '/' && (date = parseTime(date + 1, target.time)) == NULL)
+			{
+				return false;
+			}
+		}
+
+		if(*date != '\0')
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+time_t TimeZone::getRuleTime(int year, const RuleDate &date, long offset) const
+{
+	long day;
+
+	if(date.kind == 'J')
+	{
+		// February 29 is never counted
+		day = daysFromCivil(year, 1, 1) + date.day - 1 + (isLeapYear(year) && date.day >= 60);
+	}
+	else if(date.kind == 'D')
+	{
+		day = daysFromCivil(year, 1, 1) + date.day;
+	}
+	else
+	{
+		long first = daysFromCivil(year, date.month, 1);
+		// 1970-01-01 was a Thursday
+		int weekday = (int)((first % 7 + 7 + 4) % 7);
+		int dayOfMonth = (date.day - weekday + 7) % 7 + (date.week - 1) * 7;
+
+		// week 5 means the last one
+		while(dayOfMonth >= daysInMonth(year, date.month))
+		{
+			dayOfMonth -= 7;
+		}
+
+		day = first + dayOfMonth;
+	}
+
+	// the time is local, in the offset before the change
+	return (time_t)day * SECONDS_PER_DAY + date.time - offset;
+}
+
+TimeZone::Span TimeZone::getRuleSpan(time_t unixTime) const
+{
+	Span span = { rule.standardOffset, BEGINNING, END };
+
+	if(!rule.daylight)
+	{
+		return span;
+	}
+
+	// the changes of the years around the time, in order; the southern
+	// hemisphere starts daylight saving later in the year than it ends it
+	vector< pair<time_t, long> > changes;
+	long year = yearOf(unixTime);
+
+	for(long y = year - 1; y <= year + 1; y++)
+	{
+		changes.push_back(make_pair(getRuleTime(y, rule.start, rule.standardOffset), rule.daylightOffset));
+		changes.push_back(make_pair(getRuleTime(y, rule.end, rule.daylightOffset), rule.standardOffset));
+	}
+
+	sort(changes.begin(), changes.end());
+
+	for(size_t i = 0; i < changes.size(); i++)
+	{
+		if(changes[i].first > unixTime)
+		{
+			span.until = changes[i].first;
+			break;
+		}
+
+		span.offset = changes[i].second;
+		span.from = changes[i].first;
+	}
+
+	return span;
+}
+
+TimeZone::Span TimeZone::getSpan(time_t unixTime) const
+{
+	// the first transition after the time
+	size_t next = upper_bound(transitions.begin(), transitions.end(), unixTime) - transitions.begin();
+	Span span;
+
+	if(next < transitions.size())
+	{
+		span.offset = next > 0 ? offsets[next - 1] : initialOffset;
+		span.from = next > 0 ? transitions[next - 1] : BEGINNING;
+		span.until = transitions[next];
+		return span;
+	}
+
+	// past the last transition the TZ string takes over
+	if(hasRule)
+	{
+		span = getRuleSpan(unixTime);
+
+		if(!transitions.empty() && span.from < transitions.back())
+		{
+			span.from = transitions.back();
+		}
+
+		return span;
+	}
+
+	span.offset = transitions.empty() ? initialOffset : offsets.back();
+	span.from = transitions.empty() ? BEGINNING : transitions.back();
+	span.until = END;
+
+	return span;
+}
@@ -0,0 +1,136 @@
+/*
+ * TimeZone.h
+ *
+ * UTC offsets of timezones without localtime(). localtime() follows the TZ
+ * environment variable, takes a lock inside the C library on every call and
+ * may check the zone file again, which gets expensive with many clocks and
+ * serializes threads. A TimeZone reads the transitions of its zone from the
+ * TZif file in the zoneinfo directory once, together with the POSIX TZ rule
+ * the file ends with for the times after its last transition; looking up an
+ * offset afterwards is a search in memory that takes no locks.
+ *
+ * getSpan() also says how long the offset holds, so callers can keep it until
+ * the next transition and only add it to the UTC time on every tick.
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifndef TIMEZONE_H_
+#define TIMEZONE_H_
+
+#include <string>
+#include <vector>
+#include <time.h>
+
+using namespace std;
+
+class TimeZone
+{
+public:
+	/**
+	 * An offset and the times it holds for.
+	 */
+	struct Span
+	{
+		// seconds east of UTC
+		long offset;
+		// the offset is valid for from <= t < until
+		time_t from;
+		time_t until;
+	};
+
+	/**
+	 * Returns the zone with the given name, loading it the first time it is
+	 * asked for. Zones stay loaded until the program ends and may be used
+	 * from any thread.
+	 * @param name A zone of the zoneinfo directory (TZDIR or
+	 *        /usr/share/zoneinfo), e.g. "Europe/Paris", a POSIX TZ string like
+	 *        "EST5EDT", or empty for the zone TZ or /etc/localtime name.
+	 *        Zones that cannot be read are UTC, with a warning.
+	 */
+	static const TimeZone *get(const string &name);
+
+	/**
+	 * Like get(), for names from untrusted sources such as the requests of
+	 * RenderService: only zoneinfo names and POSIX TZ strings, never a file
+	 * path. Unknown zones are not kept, and no more than 1024 zones are
+	 * loaded this way.
+	 * @return NULL if the zone is unknown or too many are loaded already.
+	 */
+	static const TimeZone *find(const string &name);
+
+	/**
+	 * @return Seconds east of UTC at the given time.
+	 */
+	long getOffset(time_t unixTime) const
+	{
+		return getSpan(unixTime).offset;
+	}
+
+	/**
+	 * @return The offset at the given time and the times it is valid for.
+	 */
+	Span getSpan(time_t unixTime) const;
+
+	const string &getName() const;
+
+private:
+	// a day of the year as POSIX TZ rules give it
+	struct RuleDate
+	{
+		// 'J' for Jn (1-365, February 29 never counts), 'D' for n (0-365),
+		// 'M' for Mm.w.d (day d of week w of month m, week 5 is the last)
+		char kind;
+		int day;
+		int week;
+		int month;
+		// seconds after local midnight, may be negative or beyond a day
+		long time;
+	};
+
+	// the rule for the times after the last transition, from the TZ string
+	struct Rule
+	{
+		long standardOffset;
+		long daylightOffset;
+		bool daylight;
+		RuleDate start;
+		RuleDate end;
+	};
+
+	string name;
+	vector<time_t> transitions;
+	// the offset from every transition on
+	vector<long> offsets;
+	// before the first transition
+	long initialOffset;
+	Rule rule;
+	bool hasRule;
+	// false for unknown zones, which are UTC
+	bool loaded;
+
+	TimeZone(const string &name);
+
+	bool loadFile(const string &path);
+	bool parseRule(const string &rule);
+	Span getRuleSpan(time_t unixTime) const;
+	time_t getRuleTime(int year, const RuleDate &date, long offset) const;
+};
+
+#endif /* TIMEZONE_H_ */
@@ -23,57 +23,502 @@
  *
  */
 
+#define GL_GLEXT_PROTOTYPES
 #include <GL/glut.h>
 #include <cstdlib>
+#include <cstring>
+#include <csignal>
 #include <string>
 #include <iostream>
 #include <sstream>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <thread>
 #include <time.h>
 #include "Sprite.h"
+#include "TextureCache.h"
+#include "SpriteBatch.h"
+#include "TextureAtlas.h"
+#include "RedrawScheduler.h"
+#include "HeadlessContext.h"
+#include "SoftwareRenderer.h"
+#include "ImageLoader.h"
+#include "AssetPack.h"
+#include "AssetLoader.h"
+#include "FileWatcher.h"
+#include "TextureStreamer.h"
+#include "DirtyRegion.h"
+#include "LayerCache.h"
+#include "ClockWall.h"
+#include "TimeZone.h"
+#include "RotationTable.h"
+#include "FrameTimeHistogram.h"
+#include "Profiler.h"
+#include "FrameExporter.h"
+#include "RenderService.h"
 
 #define ESCAPE_KEY 27
+// shows and hides the timings of the last frame over the clock
+#define OVERLAY_KEY 'p'
+// the overlay's top left corner and size in pixels
+#define OVERLAY_MARGIN 8
+#define OVERLAY_WIDTH 330
+#define OVERLAY_LINE_HEIGHT 15
+#define OVERLAY_LINES 7
+// built by "make pack", the bitmaps are used when it is missing
+#define ASSET_PACK "graphics/clock.pack"
+// bitmaps written to this directory while the clock runs are shown right away
+#define IMAGE_DIRECTORY "graphics"
+// milliseconds between checks while a reloaded texture is on its way
+#define STREAM_POLL_INTERVAL 10
+#define SECONDS_PER_DAY (24 * 60 * 60)
+// the widest and tallest --size, what GL_MAX_TEXTURE_SIZE is on most drivers
+#define MAX_IMAGE_SIZE 16384
 
 using namespace std;
 
 static const time_t TIME_INTERVAL = 1; // in seconds
+// frame rate of a sweeping clock when vsync is not available, and of the
+// frames rendered with --headless --sweep unless --fps is given
+static const int DEFAULT_FPS = 60;
 
 static int windowWidth = 524;
 static int windowHeight = 524;
 
+// the images of the clock, in the order they go into the atlas
+static const char *imageFiles[] = { "graphics/clockface.bmp", "graphics/hours_hand.bmp",
+									"graphics/minutes_hand.bmp", "graphics/seconds_hand.bmp" };
+
 static Sprite *clockFace = NULL;
 static Sprite *hoursHand = NULL;
 static Sprite *minutesHand = NULL;
 static Sprite *secondsHand = NULL;
 
-void display (void)
+static SpriteBatch *batch = NULL;
+static TextureAtlas *atlas = NULL;
+// the clock face never changes, it is drawn once into a layer of its own
+// unless --no-layer-cache is given
+static LayerCache *layerCache = NULL;
+static bool cacheLayers = true;
+
+// a grid of clocks, one per zone listed in the file given with --wall
+static ClockWall *wall = NULL;
+static vector<string> wallZones;
+
+// the zone of the single clock and its UTC offset, kept until the zone's next
+// transition
+static const TimeZone *zone = NULL;
+static TimeZone::Span zoneSpan = { 0, 0, 0 };
+
+// what is drawn: the sprites that never move (the face, or the faces of the
+// wall) below the ones that do
+static vector<Sprite *> staticSprites;
+static vector<Sprite *> movingSprites;
+
+// command line options for rendering without a window
+static bool headless = false;
+static bool software = false;
+static string outputFile = "clock.bmp";
+static vector<string> timezones;
+static time_t renderTime = 0;
+static int frameCount = 1;
+// --export streams a frame every exportStep seconds from exportFrom up to
+// exportTo as video instead of saving a bitmap
+static string exportFile;
+static string exportFormat = "y4m";
+static time_t exportFrom = 0;
+static time_t exportTo = 0;
+static bool exportFromGiven = false;
+static bool exportToGiven = false;
+static double exportStep = 1;
+
+// --serve answers requests for images of the clock on a socket
+static string serveAddress;
+static int renderThreads = 0;
+static int cacheMegabytes = 64;
+static int maxPendingRenders = 256;
+// skins besides the images in graphics/, name and directory
+static vector<pair<string, string> > skinDirectories;
+static RenderService *service = NULL;
+
+static string packFile = ASSET_PACK;
+static AssetPack assetPack;
+// threads decoding the images at startup, 0 for one per processor
+static int loaderThreads = 0;
+
+// --print-clicks prints the image under every left click
+static bool printClicks = false;
+
+// edited bitmaps are reloaded and uploaded in the background, unless --no-watch
+static bool watchImages = true;
+static FileWatcher *imageWatcher = NULL;
+static TextureStreamer *streamer = NULL;
+// bitmaps that changed while a reload was on its way
+static vector<string> changedImages;
+
+// when main() started, to measure the time to the first frame
+static struct timespec startTime;
+static bool firstFrameShown = false;
+
+// only the rectangles the hands moved through are redrawn unless --full-redraw
+// is given, or the frame buffer contents were lost
+static DirtyRegion dirtyRegion;
+static bool partialRedraw = true;
+static bool fullRedraw = true;
+// set when the hands were updated, a redisplay without it means the window was exposed
+static bool handsUpdated = false;
+
+// with --sweep the hands move smoothly, redrawn every refresh of the display
+// or --fps times a second, instead of ticking once a second
+static bool sweep = false;
+static int targetFps = 0;
+
+// time between the frames that moved the hands, and time spent drawing them
+static FrameTimeHistogram frameIntervals;
+static FrameTimeHistogram renderTimes;
+static double lastFrameStart = 0;
+
+// the timings of the last frame drawn over the window, toggled with OVERLAY_KEY
+// or shown from the start with --overlay, and of every frame written to
+// --profile on exit
+static bool showOverlay = false;
+static string profileFile;
+
+// pixels cleared and composited again
+static long lastFramePixels = 0;
+static long long totalPixels = 0;
+static long framesDrawn = 0;
+
+/**
+ * @return The pixels the overlay covers, in the top left corner of the window
+ */
+DirtyRegion::Rect getOverlayRect()
+{
+	int height = OVERLAY_LINES * OVERLAY_LINE_HEIGHT + OVERLAY_MARGIN;
+	DirtyRegion::Rect rect = { 0, windowHeight - height - OVERLAY_MARGIN,
+							   OVERLAY_WIDTH + OVERLAY_MARGIN * 2, height + OVERLAY_MARGIN };
+
+	return rect;
+}
+
+/**
+ * Draws the timings of the last frame whose GPU time is known in the top left
+ * corner, on a light background so they can be read over the clock
+ */
+void drawOverlay()
+{
+	const Profiler::Frame *frame = Profiler::getLastCompleteFrame();
+	vector<string> lines;
+
+	if(frame != NULL)
+	{
+		Profiler::describe(*frame, lines);
+	}
+	else
+	{
+		lines.push_back("no frames yet");
+	}
+
+	DirtyRegion::Rect rect = getOverlayRect();
+
+	glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT | GL_COLOR_BUFFER_BIT);
+	glDisable(GL_TEXTURE_2D);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	// world coordinates are centred on the window, see reshape()
+	glColor4f(1.0f, 1.0f, 1.0f, 0.85f);
+	glRecti(rect.x - windowWidth / 2, rect.y - windowHeight / 2,
+			rect.x + rect.width - windowWidth / 2, rect.y + rect.height - windowHeight / 2);
+
+	glColor3f(0.0f, 0.0f, 0.0f);
+
+	for(size_t i = 0; i < lines.size() && i < OVERLAY_LINES; i++)
+	{
+		glWindowPos2i(OVERLAY_MARGIN * 2, windowHeight - OVERLAY_MARGIN * 2 - (i + 1) * OVERLAY_LINE_HEIGHT + 4);
+
+		for(size_t j = 0; j < lines[i].size(); j++)
+		{
+			glutBitmapCharacter(GLUT_BITMAP_9_BY_15, lines[i][j]);
+		}
+	}
+
+	glPopAttrib();
+}
+
+/**
+ * Collects the parts of the frame buffer that changed since the last frame:
+ * the old and new bounds of every sprite that moved, or everything.
+ */
+void updateDirtyRegion()
+{
+	vector<Sprite *> *lists[] = { &staticSprites, &movingSprites };
+
+	dirtyRegion.clear();
+
+	if(fullRedraw || !partialRedraw)
+	{
+		dirtyRegion.addAll();
+	}
+
+	for(int list = 0; list < 2; list++)
+	{
+		for(size_t i = 0; i < lists[list]->size(); i++)
+		{
+			Sprite *sprite = (*lists[list])[i];
+
+			if(!fullRedraw && partialRedraw)
+			{
+				dirtyRegion.add(*sprite);
+			}
+
+			sprite->markClean();
+		}
+	}
+
+	if(showOverlay && !headless && !fullRedraw && partialRedraw)
+	{
+		dirtyRegion.add(getOverlayRect());
+	}
+
+	fullRedraw = false;
+
+	lastFramePixels = dirtyRegion.getPixelCount();
+	totalPixels += lastFramePixels;
+	framesDrawn++;
+}
+
+/**
+ * Draws the clock into the current frame buffer. Shared by the window and the
+ * headless renderer.
+ */
+void renderScene (void)
 {
-	glClear(GL_COLOR_BUFFER_BIT);
+	bool layerChanged = layerCache != NULL && layerCache->isStale();
+
+	if(layerCache != NULL && !layerCache->update(windowWidth, windowHeight))
+	{
+		// no frame buffer objects, draw the static sprites every frame
+		delete layerCache;
+		layerCache = NULL;
+	}
+
+	// the whole background changed
+	if(layerCache != NULL && layerChanged)
+	{
+		fullRedraw = true;
+	}
+
+	updateDirtyRegion();
+
+	const vector<DirtyRegion::Rect> &rects = dirtyRegion.getRects();
+
 	glRasterPos2i(0, 0);
 
-	// draw the clock
-	clockFace->setPivot(0.5, 0.5);
-	clockFace->setX(0);
-	clockFace->setY(0);
-	clockFace->draw();
+	// draw the clock, replacing only the dirty rectangles. Everything comes
+	// from the atlas, so it is one draw call however many clocks there are.
+	batch->begin();
+
+	for(size_t i = 0; i < staticSprites.size() && layerCache == NULL; i++)
+	{
+		batch->add(*staticSprites[i]);
+	}
+
+	for(size_t i = 0; i < movingSprites.size(); i++)
+	{
+		batch->add(*movingSprites[i]);
+	}
+
+	glEnable(GL_SCISSOR_TEST);
+
+	for(size_t i = 0; i < rects.size(); i++)
+	{
+		glScissor(rects[i].x, rects[i].y, rects[i].width, rects[i].height);
+		Profiler::countStateChanges(1);
+
+		if(layerCache != NULL)
+		{
+			layerCache->draw();
+		}
+		else
+		{
+			glClear(GL_COLOR_BUFFER_BIT);
+		}
 
-	hoursHand->setX(0);
-	hoursHand->setY(0);
-	hoursHand->setPivot(0.5, 0.075);
-	hoursHand->draw();
+		if(i == 0)
+		{
+			batch->flush();
+		}
+		else
+		{
+			batch->draw();
+		}
+	}
 
-	minutesHand->setX(0);
-	minutesHand->setY(0);
-	minutesHand->setPivot(0.5, 0.0566);
-	minutesHand->draw();
+	glDisable(GL_SCISSOR_TEST);
 
-	secondsHand->setX(0);
-	secondsHand->setY(0);
-	secondsHand->setPivot(0.5, 0.0545);
-	secondsHand->draw();
+	// GLUT fonts need a window
+	if(showOverlay && !headless)
+	{
+		drawOverlay();
+	}
 
 	glFlush();
-	glutSwapBuffers();
 	glDisable(GL_TEXTURE_2D);
+
+	TextureCache::endFrame();
+}
+
+/**
+ * Draws the clock into a frame buffer in memory, without OpenGL
+ */
+void renderSoftware(SoftwareRenderer &renderer)
+{
+	if(layerCache != NULL && layerCache->isStale())
+	{
+		layerCache->update(renderer);
+		fullRedraw = true;
+	}
+
+	updateDirtyRegion();
+
+	const vector<DirtyRegion::Rect> &rects = dirtyRegion.getRects();
+
+	for(size_t i = 0; i < rects.size(); i++)
+	{
+		renderer.setClipRect(rects[i].x, rects[i].y, rects[i].width, rects[i].height);
+
+		if(layerCache != NULL)
+		{
+			layerCache->draw(renderer);
+		}
+		else
+		{
+			// same colour as glClearColor in init()
+			renderer.clear(255, 255, 255, 0);
+
+			for(size_t j = 0; j < staticSprites.size(); j++)
+			{
+				renderer.draw(*staticSprites[j]);
+			}
+		}
+
+		for(size_t j = 0; j < movingSprites.size(); j++)
+		{
+			renderer.draw(*movingSprites[j]);
+		}
+	}
+
+	renderer.resetClipRect();
+}
+
+/**
+ * Shows the frame drawn into the back buffer. Instead of swapping, which
+ * leaves the back buffer undefined, only the redrawn rectangles are copied to
+ * the front buffer so the next frame can be drawn over this one.
+ * @param wholeWindow Copies everything, e.g. after the window was exposed.
+ */
+void presentFrame(bool wholeWindow)
+{
+	vector<DirtyRegion::Rect> rects = dirtyRegion.getRects();
+
+	if(wholeWindow)
+	{
+		DirtyRegion::Rect all = { 0, 0, windowWidth, windowHeight };
+		rects.assign(1, all);
+	}
+
+	glPushAttrib(GL_COLOR_BUFFER_BIT | GL_ENABLE_BIT | GL_PIXEL_MODE_BIT);
+	glDisable(GL_BLEND);
+	glDisable(GL_TEXTURE_2D);
+	glReadBuffer(GL_BACK);
+	glDrawBuffer(GL_FRONT);
+
+	for(size_t i = 0; i < rects.size(); i++)
+	{
+		glWindowPos2i(rects[i].x, rects[i].y);
+		glCopyPixels(rects[i].x, rects[i].y, rects[i].width, rects[i].height, GL_COLOR);
+	}
+
+	Profiler::countDrawCalls(rects.size());
+
+	glPopAttrib();
+	glFlush();
+}
+
+/**
+ * Prints how long it took from starting the program until the first frame was
+ * drawn, the first time it is called.
+ */
+void reportFirstFrame()
+{
+	if(firstFrameShown)
+	{
+		return;
+	}
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	firstFrameShown = true;
+
+	double seconds = (now.tv_sec - startTime.tv_sec) + (now.tv_nsec - startTime.tv_nsec) / 1e9;
+	cout << "time to first frame: " << seconds * 1000 << "ms, images from "
+		 << (assetPack.isOpen() ? packFile : "bitmaps") << endl;
+}
+
+/**
+ * @return Seconds on the monotonic clock, for measuring frame times.
+ */
+double monotonicSeconds()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+void display (void)
+{
+	double start = monotonicSeconds();
+
+	Profiler::beginFrame(true);
+
+	{
+		Profiler::Scope scope(Profiler::DISPLAY);
+
+		renderScene();
+
+		if(partialRedraw)
+		{
+			presentFrame(!handsUpdated);
+		}
+		else
+		{
+			glutSwapBuffers();
+		}
+	}
+
+	Profiler::endFrame(TextureCache::getFrameBytesUploaded());
+
+	// exposing the window redraws without an animation frame
+	if(handsUpdated)
+	{
+		if(lastFrameStart > 0)
+		{
+			frameIntervals.add(start - lastFrameStart);
+		}
+
+		lastFrameStart = start;
+		renderTimes.add(monotonicSeconds() - start);
+	}
+
+	handsUpdated = false;
+
+	if(!firstFrameShown)
+	{
+		glFinish();
+		reportFirstFrame();
+	}
 }
 
 void reshape(int w, int h)
@@ -87,6 +532,115 @@ void reshape(int w, int h)
 	glOrtho(-w/2, w/2, -h/2, h/2, -1.0, 1.0);
 	glMatrixMode(GL_MODELVIEW);
 	glLoadIdentity();
+
+	// the frame buffer was resized, nothing in it can be kept
+	dirtyRegion.setSize(w, h);
+	fullRedraw = true;
+
+	if(layerCache != NULL)
+	{
+		layerCache->invalidate();
+	}
+
+	if(wall != NULL)
+	{
+		wall->layout(w, h);
+	}
+}
+
+/**
+ * Creates the sprites of a clock from the images in the given directory, named
+ * like the ones in graphics/, with their pivots set up and placed at (0, 0)
+ */
+void createClockSprites(const string &directory, Sprite *sprites[4])
+{
+	// pivots for images loaded from bitmaps, the asset pack stores the same ones
+	GLfloat pivots[][2] = { { 0.5, 0.5 }, { 0.5, 0.075 }, { 0.5, 0.0566 }, { 0.5, 0.0545 } };
+
+	for(int i = 0; i < 4; i++)
+	{
+		string name = imageFiles[i] + strlen(IMAGE_DIRECTORY);
+
+		sprites[i] = new Sprite(directory + name);
+
+		// set the pivots first, setPivot moves the sprite to keep it in place
+		if(!sprites[i]->getImage()->hasPivot())
+		{
+			sprites[i]->setPivot(pivots[i][0], pivots[i][1]);
+		}
+
+		sprites[i]->setX(0);
+		sprites[i]->setY(0);
+	}
+}
+
+/**
+ * Loads the clock images and places the hands on the middle of the face
+ */
+void loadSprites()
+{
+	// decode all images at once, the sprites then find them in the cache. The
+	// textures are uploaded later on this thread, by the atlas
+	AssetLoader loader(loaderThreads);
+
+	for(int i = 0; i < 4; i++)
+	{
+		loader.add(imageFiles[i]);
+	}
+
+	loader.finish();
+
+	Sprite *sprites[4];
+
+	createClockSprites(IMAGE_DIRECTORY, sprites);
+
+	clockFace = sprites[0];
+	hoursHand = sprites[1];
+	minutesHand = sprites[2];
+	secondsHand = sprites[3];
+}
+
+/**
+ * Decides what is drawn: the single clock, or if --wall was given a wall of
+ * clocks made of copies of its sprites
+ */
+void createScene()
+{
+	if(!wallZones.empty())
+	{
+		wall = new ClockWall(clockFace, hoursHand, minutesHand, secondsHand);
+		wall->setZones(wallZones);
+		wall->setSweep(sweep);
+		wall->layout(windowWidth, windowHeight);
+
+		staticSprites = wall->getFaces();
+		movingSprites = wall->getHands();
+	}
+	else
+	{
+		Sprite *hands[] = { hoursHand, minutesHand, secondsHand };
+
+		staticSprites.assign(1, clockFace);
+		movingSprites.assign(hands, hands + 3);
+	}
+}
+
+/**
+ * Puts the sprites that never move into a layer of their own, if layers are
+ * cached
+ */
+void createLayerCache()
+{
+	if(cacheLayers)
+	{
+		// same colour as glClearColor in init()
+		layerCache = new LayerCache(255, 255, 255, 0);
+
+		for(size_t i = 0; i < staticSprites.size(); i++)
+		{
+			layerCache->add(staticSprites[i]);
+		}
+	}
 }
 
 void init (void)
@@ -99,48 +653,303 @@ void init (void)
 
 	Sprite::enable2D();
 
-	clockFace = new Sprite("graphics/clockface.bmp");
-	hoursHand = new Sprite("graphics/hours_hand.bmp");
-	minutesHand = new Sprite("graphics/minutes_hand.bmp");
-	secondsHand = new Sprite("graphics/seconds_hand.bmp");
+	loadSprites();
+
+	// pack all layers into one texture so the whole clock is drawn without
+	// switching textures
+	atlas = new TextureAtlas();
+	atlas->add(clockFace);
+	atlas->add(hoursHand);
+	atlas->add(minutesHand);
+	atlas->add(secondsHand);
+	atlas->build();
+
+	createScene();
+	createLayerCache();
+
+	batch = new SpriteBatch();
 
-	// clear buffer and display image
 	reshape(windowWidth, windowHeight);
-	display();
 }
 
-void clockAnimation()
+/**
+ * Loads the images again with the changed bitmaps and composes a new atlas
+ * from them on the streamer's worker, then swaps in the atlas texture and the
+ * images once the texture is in video memory. The images in use are not
+ * touched until then, so drawing goes on undisturbed.
+ */
+void reloadImages(const vector<string> &changed)
 {
-	static time_t lastRendered = 0;
+	struct Reload
+	{
+		TextureAtlas atlas;
+		vector<ImageLoader *> images;
+		vector<bool> changed;
+		// the sections timed on the streamer's worker
+		CpuProfiler::Times times;
+
+		// the images of a reload that failed or never finished
+		~Reload()
+		{
+			for(size_t i = 0; i < images.size(); i++)
+			{
+				delete images[i];
+			}
+		}
+	};
+
+	shared_ptr<Reload> reload(new Reload());
+	GLint maxSize = 0;
 
-	time_t unixTime = time(NULL);
-	struct tm *currentTime = localtime(&unixTime);
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
 
-	// only re-render the screen after the time interval has passed. Remember we
-	// do not want to render the screen to often because otherwise it will become
-	// too expensive.
-	if(lastRendered == 0 || unixTime - lastRendered >= TIME_INTERVAL)
+	for(int i = 0; i < 4; i++)
 	{
-		// note we use negative angles because in math angles are always measured counter-clockwise
-		// so by using a negative angle we will get a clockwise angle needed for our clock.
-		hoursHand->setAngle(-1 * (30 * currentTime->tm_hour + ((int)(6 * currentTime->tm_min / 90.0)) * 7.5));
-		minutesHand->setAngle(-1 * 6 * currentTime->tm_min);
-		secondsHand->setAngle(-1 * 6 * currentTime->tm_sec);
+		reload->changed.push_back(find(changed.begin(), changed.end(), imageFiles[i]) != changed.end());
+	}
+
+	streamer->load([reload, maxSize]() -> ImageLoader * {
+		for(int i = 0; i < 4; i++)
+		{
+			ImageLoader *image;
+
+			if(reload->changed[i])
+			{
+				// copied out of the file, which may be written again while in use
+				image = new ImageLoader(imageFiles[i], ImageLoader::CONVERT);
+				image->generateMipmaps();
+			}
+			else
+			{
+				image = TextureCache::loadImage(imageFiles[i]);
+			}
+
+			reload->images.push_back(image);
+			reload->atlas.add(image);
+
+			// e.g. caught halfway through being written, the next write reloads it
+			if(image->getPixelData() == NULL)
+			{
+				return NULL;
+			}
+		}
+
+		// those of a reload that failed are kept for the next one
+		CpuProfiler::takeThreadTimes(reload->times);
+
+		ImageLoader *pixels = new ImageLoader();
+
+		if(!reload->atlas.compose(*pixels, maxSize))
+		{
+			delete pixels;
+			return NULL;
+		}
+
+		return pixels;
+	}, [reload](ImageLoader *pixels, GLuint texture) {
+		delete pixels;
+		Profiler::addThreadTimes(reload->times);
+
+		for(int i = 0; i < 4; i++)
+		{
+			if(reload->changed[i])
+			{
+				TextureCache::replace(imageFiles[i], reload->images[i]);
+			}
+			else
+			{
+				delete reload->images[i];
+			}
+		}
+
+		reload->images.clear();
+
+		// the copies on the wall were made from the sprites in the atlas
+		atlas->adopt(reload->atlas, texture);
 
-		lastRendered = unixTime;
+		for(size_t i = 0; i < staticSprites.size(); i++)
+		{
+			atlas->assign(staticSprites[i]);
+		}
+
+		for(size_t i = 0; i < movingSprites.size(); i++)
+		{
+			atlas->assign(movingSprites[i]);
+		}
+
+		if(layerCache != NULL)
+		{
+			layerCache->invalidate();
+		}
+
+		fullRedraw = true;
 		glutPostRedisplay();
+	});
+}
+
+/**
+ * Moves a reload along until its texture is swapped in, then starts the next
+ * one if more bitmaps changed meanwhile
+ */
+void streamImages(int value)
+{
+	if(streamer->update())
+	{
+		glutTimerFunc(STREAM_POLL_INTERVAL, streamImages, 0);
+	}
+	else if(!changedImages.empty())
+	{
+		reloadImages(changedImages);
+		changedImages.clear();
+		glutTimerFunc(STREAM_POLL_INTERVAL, streamImages, 0);
+	}
+}
+
+/**
+ * Starts reloading the clock's bitmaps that were written since the last call
+ */
+void pollImages()
+{
+	vector<string> changed;
+
+	if(imageWatcher == NULL || !imageWatcher->poll(changed))
+	{
+		return;
+	}
+
+	for(size_t i = 0; i < changed.size(); i++)
+	{
+		if(find(imageFiles, imageFiles + 4, changed[i]) != imageFiles + 4 &&
+		   find(changedImages.begin(), changedImages.end(), changed[i]) == changedImages.end())
+		{
+			changedImages.push_back(changed[i]);
+		}
+	}
+
+	// a reload on its way picks them up once it is done
+	if(!changedImages.empty() && !streamer->isBusy())
+	{
+		reloadImages(changedImages);
+		changedImages.clear();
+		glutTimerFunc(STREAM_POLL_INTERVAL, streamImages, 0);
 	}
 }
 
+/**
+ * Points the hands at the given time in the current timezone, sweeping
+ * through the fraction of the second with --sweep
+ */
+void updateHands(const struct timespec &time)
+{
+	if(wall != NULL)
+	{
+		wall->update(time);
+		return;
+	}
+
+	if(time.tv_sec < zoneSpan.from || time.tv_sec >= zoneSpan.until)
+	{
+		zoneSpan = zone->getSpan(time.tv_sec);
+	}
+
+	long seconds = (time.tv_sec + zoneSpan.offset) % SECONDS_PER_DAY;
+	const Rotation *rotations[3];
+
+	if(seconds < 0)
+	{
+		seconds += SECONDS_PER_DAY;
+	}
+
+	if(sweep)
+	{
+		ClockWall::getRotations(seconds + time.tv_nsec / 1e9, rotations);
+	}
+	else
+	{
+		ClockWall::getRotations(seconds / 3600, seconds / 60 % 60, seconds % 60, rotations);
+	}
+
+	hoursHand->setRotation(*rotations[0]);
+	minutesHand->setRotation(*rotations[1]);
+	secondsHand->setRotation(*rotations[2]);
+}
+
+void clockAnimation()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+
+	updateHands(now);
+	handsUpdated = true;
+	glutPostRedisplay();
+
+	pollImages();
+}
+
 /**
  * Clean up before exiting the program
  */
 void cleanup()
 {
+	Sprite *sprites[] = { clockFace, hoursHand, minutesHand, secondsHand };
+
+	if(!profileFile.empty())
+	{
+		// the last frames' GPU times are still in flight
+		Profiler::finish();
+
+		bool csv = profileFile.size() > 4 && profileFile.compare(profileFile.size() - 4, 4, ".csv") == 0;
+		bool written = csv ? Profiler::writeCSV(profileFile.c_str()) : Profiler::writeJSON(profileFile.c_str());
+
+		if(written)
+		{
+			cout << "profile of " << Profiler::getFrames().size() << " frames written to " << profileFile << endl;
+		}
+	}
+
+	for(int i = 0; i < 4; i++)
+	{
+		if(sprites[i] != NULL)
+		{
+			cout << sprites[i]->getFilename() << ": loaded in " << sprites[i]->getImage()->getLoadTime() * 1000
+				 << "ms, peak RSS " << sprites[i]->getImage()->getPeakRSS() << " KB" << endl;
+		}
+	}
+
+	// before the atlas, its textures may still be on their way
+	delete streamer;
+	delete imageWatcher;
 	delete clockFace;
 	delete hoursHand;
 	delete minutesHand;
 	delete secondsHand;
+	delete batch;
+	delete atlas;
+	delete layerCache;
+	delete wall;
+
+	cout << "texture uploads: " << TextureCache::getTotalBytesUploaded() << " bytes total, "
+		 << TextureCache::getFrameBytesUploaded() << " bytes in the last frame" << endl;
+	if(framesDrawn > 0)
+	{
+		cout << "pixels touched: " << lastFramePixels << " in the last frame, "
+			 << totalPixels / framesDrawn << " per frame on average, "
+			 << (long)windowWidth * windowHeight << " in a full frame" << endl;
+	}
+
+	if(renderTimes.getCount() > 0)
+	{
+		cout << "render time: " << renderTimes.getSummary() << endl;
+	}
+
+	if(frameIntervals.getCount() > 0)
+	{
+		cout << "frame interval: " << frameIntervals.getSummary() << endl;
+	}
+
+	cout << "scheduler: " << RedrawScheduler::getWakeupsPerSecond() << " wakeups/s, "
+		 << RedrawScheduler::getCpuUsage() * 100 << "% cpu, "
+		 << RedrawScheduler::getCpuSeconds() << "s cpu total" << endl;
 }
 
 void keyboard(unsigned char key, int x, int y)
@@ -151,22 +960,678 @@ void keyboard(unsigned char key, int x, int y)
 		cleanup();
 		exit(0);
 		break;
+	case OVERLAY_KEY:
+		showOverlay = !showOverlay;
+		// hiding it has to restore what was under it
+		fullRedraw = true;
+		glutPostRedisplay();
+		break;
 	default:
 		break;
 	}
 }
 
+/**
+ * Prints the sprite under a left click, the one drawn last if several are,
+ * with --print-clicks
+ */
+void mouse(int button, int state, int x, int y)
+{
+	if(button != GLUT_LEFT_BUTTON || state != GLUT_DOWN)
+	{
+		return;
+	}
+
+	// window coordinates start at the top left, the scene's origin is in the
+	// middle of the window with y going up, see reshape()
+	GLfloat worldX = x - windowWidth / 2;
+	GLfloat worldY = windowHeight / 2 - y;
+	vector<Sprite *> *lists[] = { &movingSprites, &staticSprites };
+
+	for(int i = 0; i < 2; i++)
+	{
+		for(size_t j = lists[i]->size(); j > 0; j--)
+		{
+			Sprite *sprite = (*lists[i])[j - 1];
+
+			if(sprite->hitTest(worldX, worldY))
+			{
+				cout << "Clicked " << sprite->getFilename() << endl;
+				return;
+			}
+		}
+	}
+}
+
+/**
+ * Sets the timezone of the single clock, an empty name means the system default
+ */
+void setTimezone(const string &name)
+{
+	TimeZone::Span unknown = { 0, 0, 0 };
+
+	zone = TimeZone::get(name);
+	zoneSpan = unknown;
+}
+
+/**
+ * Returns the output file for the given zone. When several zones are rendered
+ * the zone name is added before the extension, e.g. clock_Europe-Paris.bmp
+ */
+string getOutputFile(const string &zone)
+{
+	if(timezones.size() < 2)
+	{
+		return outputFile;
+	}
+
+	string suffix = "_" + zone;
+
+	for(size_t i = 0; i < suffix.size(); i++)
+	{
+		if(suffix[i] == '/')
+		{
+			suffix[i] = '-';
+		}
+	}
+
+	size_t dot = outputFile.rfind('.');
+
+	if(dot == string::npos)
+	{
+		return outputFile + suffix;
+	}
+
+	return outputFile.substr(0, dot) + suffix + outputFile.substr(dot);
+}
+
+/**
+ * Renders a frame offscreen showing the given time, with the software renderer
+ * when there is one
+ */
+void renderFrame(SoftwareRenderer *renderer, const struct timespec &frameTime)
+{
+	double frameStart = monotonicSeconds();
+
+	Profiler::beginFrame(renderer == NULL);
+
+	{
+		Profiler::Scope scope(Profiler::DISPLAY);
+
+		updateHands(frameTime);
+
+		if(renderer != NULL)
+		{
+			renderSoftware(*renderer);
+		}
+		else
+		{
+			renderScene();
+			glFinish();
+		}
+	}
+
+	Profiler::endFrame(TextureCache::getFrameBytesUploaded());
+
+	renderTimes.add(monotonicSeconds() - frameStart);
+
+	if(!firstFrameShown)
+	{
+		reportFirstFrame();
+	}
+}
+
+/**
+ * Renders the frames of --export, in the first zone given with --tz, and
+ * streams them out while the next ones render
+ */
+int exportVideo(HeadlessContext *context, SoftwareRenderer *renderer)
+{
+	FrameExporter exporter(windowWidth, windowHeight, FrameExporter::getFormat(exportFormat),
+						   targetFps > 0 ? targetFps : DEFAULT_FPS);
+
+	setTimezone(timezones.empty() ? "" : timezones[0]);
+
+	// a day from --time (or now) unless --from and --to say otherwise
+	if(!exportFromGiven)
+	{
+		exportFrom = renderTime;
+	}
+
+	if(!exportToGiven)
+	{
+		exportTo = exportFrom + SECONDS_PER_DAY;
+	}
+
+	if(!exporter.open(exportFile))
+	{
+		return 1;
+	}
+
+	long long stepNanos = (long long)(exportStep * 1e9);
+	long long endNanos = (long long)exportTo * 1000000000LL;
+	long frames = 0;
+	double start = monotonicSeconds();
+
+	for(long long nanos = (long long)exportFrom * 1000000000LL; nanos < endNanos; nanos += stepNanos)
+	{
+		struct timespec frameTime = { (time_t)(nanos / 1000000000LL), (long)(nanos % 1000000000LL) };
+
+		renderFrame(renderer, frameTime);
+
+		BYTE *pixels = exporter.acquire();
+
+		if(pixels == NULL)
+		{
+			// the output is gone, e.g. the encoder reading it quit
+			break;
+		}
+
+		if(renderer != NULL)
+		{
+			memcpy(pixels, renderer->getPixels(), windowWidth * windowHeight * 4);
+		}
+		else
+		{
+			context->readPixels(pixels);
+		}
+
+		exporter.submit(pixels);
+		frames++;
+	}
+
+	bool written = exporter.finish();
+	double seconds = monotonicSeconds() - start;
+
+	cout << exporter.getFramesWritten() << " of " << frames << " frames written to " << exportFile << " in "
+		 << seconds << "s (" << frames / seconds << " fps, " << frames * exportStep / seconds
+		 << "x real time); converting took " << exporter.getConvertSeconds() << "s and writing "
+		 << exporter.getWriteSeconds() << "s" << endl;
+
+	return written ? 0 : 1;
+}
+
+/**
+ * Stops the render service on Ctrl+C or kill
+ */
+void stopServing(int signal)
+{
+	if(service != NULL)
+	{
+		service->stop();
+	}
+}
+
+/**
+ * Answers requests for images of the clock on the --serve socket until the
+ * program is interrupted
+ */
+int serve()
+{
+	vector<Sprite *> skinSprites;
+	int result = 0;
+
+	loadSprites();
+
+	Sprite *sprites[] = { clockFace, hoursHand, minutesHand, secondsHand };
+
+	service = new RenderService(renderThreads > 0 ? renderThreads : thread::hardware_concurrency(), software,
+								windowWidth, windowHeight, (size_t)cacheMegabytes << 20, maxPendingRenders);
+	service->addSkin("default", sprites);
+
+	for(size_t i = 0; i < skinDirectories.size(); i++)
+	{
+		Sprite *skin[4];
+
+		createClockSprites(skinDirectories[i].second, skin);
+
+		if(skin[0]->getImage() == NULL || skin[0]->getImage()->getPixelData() == NULL)
+		{
+			cout << "Error: no clock images in " << skinDirectories[i].second << endl;
+			result = 1;
+		}
+
+		service->addSkin(skinDirectories[i].first, skin);
+		skinSprites.insert(skinSprites.end(), skin, skin + 4);
+	}
+
+	if(result == 0 && service->listen(serveAddress))
+	{
+		signal(SIGINT, stopServing);
+		signal(SIGTERM, stopServing);
+
+		cout << "serving " << windowWidth << "x" << windowHeight << " clocks at most on " << serveAddress << endl;
+
+		if(!service->run())
+		{
+			result = 1;
+		}
+
+		cout << "served " << service->getStats();
+	}
+	else
+	{
+		result = 1;
+	}
+
+	delete service;
+	service = NULL;
+
+	for(size_t i = 0; i < skinSprites.size(); i++)
+	{
+		delete skinSprites[i];
+	}
+
+	cleanup();
+
+	return result;
+}
+
+/**
+ * Renders the clock into an offscreen surface for every requested timezone and
+ * saves the results, without opening a window.
+ */
+int renderHeadless()
+{
+	HeadlessContext *context = NULL;
+	SoftwareRenderer *renderer = NULL;
+
+	if(software)
+	{
+		renderer = new SoftwareRenderer(windowWidth, windowHeight);
+		dirtyRegion.setSize(windowWidth, windowHeight);
+		loadSprites();
+		createScene();
+		createLayerCache();
+	}
+	else
+	{
+		context = new HeadlessContext(windowWidth, windowHeight);
+
+		if(!context->isValid())
+		{
+			delete context;
+			return 1;
+		}
+
+		init();
+	}
+
+	if(timezones.empty())
+	{
+		timezones.push_back("");
+	}
+
+	if(renderTime == 0)
+	{
+		renderTime = time(NULL);
+	}
+
+	if(!exportFile.empty())
+	{
+		int result = exportVideo(context, renderer);
+
+		cleanup();
+
+		delete renderer;
+		delete context;
+
+		return result;
+	}
+
+	int result = 0;
+
+	for(size_t i = 0; i < timezones.size() && result == 0; i++)
+	{
+		setTimezone(timezones[i]);
+
+		struct timespec start, end;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+
+		// frames show the seconds (or with --sweep the frames at --fps) leading
+		// up to the time to render, so the hands move from one frame to the
+		// next like they do in the window
+		long frameNanos = sweep ? 1000000000L / (targetFps > 0 ? targetFps : DEFAULT_FPS) : 1000000000L;
+
+		for(int frame = 0; frame < frameCount; frame++)
+		{
+			long long nanos = (long long)renderTime * 1000000000LL - (long long)(frameCount - 1 - frame) * frameNanos;
+			struct timespec frameTime = { (time_t)(nanos / 1000000000LL), (long)(nanos % 1000000000LL) };
+
+			renderFrame(renderer, frameTime);
+		}
+
+		if(renderer == NULL)
+		{
+			glFinish();
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &end);
+
+		if(frameCount > 1)
+		{
+			double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+			cout << frameCount << " frames in " << seconds << "s (" << frameCount / seconds << " fps)" << endl;
+		}
+
+		string fileName = getOutputFile(timezones[i]);
+		bool saved = renderer != NULL ? renderer->saveBMP(fileName.c_str()) : context->saveBMP(fileName.c_str());
+
+		if(saved)
+		{
+			cout << "saved " << fileName << endl;
+		}
+		else
+		{
+			result = 1;
+		}
+	}
+
+	cleanup();
+
+	delete renderer;
+	delete context;
+
+	return result;
+}
+
+/**
+ * Reads the command line options, leaving the GLUT ones for glutInit
+ * @return False if the options are invalid
+ */
+bool parseArguments(int argc, char* argv[])
+{
+	bool sizeGiven = false;
+
+	for(int i = 1; i < argc; i++)
+	{
+		string option = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if(option == "--headless")
+		{
+			headless = true;
+		}
+		else if(option == "--software")
+		{
+			headless = true;
+			software = true;
+		}
+		else if(option == "--output" && hasValue)
+		{
+			outputFile = argv[++i];
+		}
+		else if(option == "--tz" && hasValue)
+		{
+			timezones.push_back(argv[++i]);
+		}
+		else if(option == "--time" && hasValue)
+		{
+			renderTime = atol(argv[++i]);
+		}
+		else if(option == "--export" && hasValue)
+		{
+			headless = true;
+			exportFile = argv[++i];
+		}
+		else if(option == "--format" && hasValue)
+		{
+			exportFormat = argv[++i];
+
+			if(exportFormat != "y4m" && exportFormat != "rgba")
+			{
+				return false;
+			}
+		}
+		else if(option == "--from" && hasValue)
+		{
+			exportFrom = atol(argv[++i]);
+			exportFromGiven = true;
+		}
+		else if(option == "--to" && hasValue)
+		{
+			exportTo = atol(argv[++i]);
+			exportToGiven = true;
+		}
+		else if(option == "--step" && hasValue)
+		{
+			exportStep = atof(argv[++i]);
+
+			// at least a nanosecond, the export counts in them, and no more
+			// than the 64 bits of nanoseconds hold
+			if(!(exportStep * 1e9 >= 1) || exportStep > 1e9)
+			{
+				return false;
+			}
+		}
+		else if(option == "--serve" && hasValue)
+		{
+			serveAddress = argv[++i];
+		}
+		else if(option == "--render-threads" && hasValue)
+		{
+			renderThreads = max(1, atoi(argv[++i]));
+		}
+		else if(option == "--cache-mb" && hasValue)
+		{
+			cacheMegabytes = max(0, atoi(argv[++i]));
+		}
+		else if(option == "--max-pending" && hasValue)
+		{
+			maxPendingRenders = max(1, atoi(argv[++i]));
+		}
+		else if(option == "--skin" && hasValue)
+		{
+			string skin = argv[++i];
+			size_t equals = skin.find('=');
+
+			if(equals == string::npos || equals == 0)
+			{
+				return false;
+			}
+
+			skinDirectories.push_back(make_pair(skin.substr(0, equals), skin.substr(equals + 1)));
+		}
+		else if(option == "--frames" && hasValue)
+		{
+			frameCount = max(1, atoi(argv[++i]));
+		}
+		else if(option == "--pack" && hasValue)
+		{
+			packFile = argv[++i];
+		}
+		else if(option == "--no-pack")
+		{
+			packFile.clear();
+		}
+		else if(option == "--no-watch")
+		{
+			watchImages = false;
+		}
+		else if(option == "--print-clicks")
+		{
+			printClicks = true;
+		}
+		else if(option == "--loader-threads" && hasValue)
+		{
+			loaderThreads = max(1, atoi(argv[++i]));
+		}
+		else if(option == "--full-redraw")
+		{
+			partialRedraw = false;
+		}
+		else if(option == "--no-layer-cache")
+		{
+			cacheLayers = false;
+		}
+		else if(option == "--sweep")
+		{
+			sweep = true;
+		}
+		else if(option == "--fps" && hasValue)
+		{
+			targetFps = max(1, atoi(argv[++i]));
+		}
+		else if(option == "--overlay")
+		{
+			showOverlay = true;
+		}
+		else if(option == "--profile" && hasValue)
+		{
+			profileFile = argv[++i];
+		}
+		else if(option == "--wall" && hasValue)
+		{
+			if(!ClockWall::readZones(argv[++i], wallZones) || wallZones.empty())
+			{
+				return false;
+			}
+		}
+		else if(option == "--size" && hasValue)
+		{
+			if(sscanf(argv[++i], "%dx%d", &windowWidth, &windowHeight) != 2 || windowWidth < 1 ||
+			   windowHeight < 1 || windowWidth > MAX_IMAGE_SIZE || windowHeight > MAX_IMAGE_SIZE)
+			{
+				return false;
+			}
+
+			sizeGiven = true;
+		}
+		else if(option.compare(0, 2, "--") == 0)
+		{
+			return false;
+		}
+	}
+
+	if(!serveAddress.empty() && !sizeGiven)
+	{
+		// the largest image served
+		windowWidth = 1024;
+		windowHeight = 1024;
+	}
+
+	if(!wallZones.empty())
+	{
+		// zones given with --tz join the wall instead of being rendered one by one
+		wallZones.insert(wallZones.end(), timezones.begin(), timezones.end());
+		timezones.clear();
+
+		if(!sizeGiven)
+		{
+			windowWidth = 1280;
+			windowHeight = 720;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Starts moving the hands: once a second, or for a sweeping clock every
+ * refresh of the display or at the rate given with --fps
+ */
+void startAnimation()
+{
+	if(!sweep)
+	{
+		// only wake up when the time shown has to change. Remember we do not want to
+		// render the screen to often because otherwise it will become too expensive.
+		RedrawScheduler::start(TIME_INTERVAL * 1000, clockAnimation);
+		return;
+	}
+
+	if(targetFps > 0)
+	{
+		RedrawScheduler::start(1000.0 / targetFps, clockAnimation);
+		return;
+	}
+
+	// swapping is what waits for the display, but it leaves the back buffer
+	// undefined so every frame has to be drawn whole
+	bool partial = partialRedraw;
+	partialRedraw = false;
+
+	if(!RedrawScheduler::startVsync(clockAnimation))
+	{
+		cout << "vsync is not available, sweeping at " << DEFAULT_FPS << " fps" << endl;
+		partialRedraw = partial;
+		RedrawScheduler::start(1000.0 / DEFAULT_FPS, clockAnimation);
+	}
+}
+
 int main (int argc, char* argv[])
 {
+	clock_gettime(CLOCK_MONOTONIC, &startTime);
+
+	if(!parseArguments(argc, argv))
+	{
+		cout << "usage: " << argv[0] << " [--headless | --software] [--output file.bmp] [--size WxH]" << endl
+			 << "       [--tz zone]... [--time unix-seconds] [--frames count]" << endl
+			 << "       [--pack file.pack | --no-pack] [--loader-threads count]" << endl
+			 << "       [--full-redraw] [--no-layer-cache] [--no-watch]" << endl
+			 << "       [--wall zones.txt] [--sweep [--fps rate]] [--overlay] [--print-clicks]" << endl
+			 << "       [--profile stats.json | stats.csv]" << endl
+			 << "       [--export file | - [--format y4m | rgba] [--from unix-seconds]" << endl
+			 << "        [--to unix-seconds] [--step seconds]]" << endl
+			 << "       [--serve socket-path | port | host:port [--software] [--size WxH]" << endl
+			 << "        [--render-threads count] [--cache-mb size] [--max-pending count]" << endl
+			 << "        [--skin name=directory]...]" << endl;
+		return 1;
+	}
+
+	if(!packFile.empty() && assetPack.open(packFile.c_str()))
+	{
+		TextureCache::setAssetPack(&assetPack);
+	}
+
+	setTimezone("");
+
+	if(!serveAddress.empty())
+	{
+		return serve();
+	}
+
+	if(headless)
+	{
+		return renderHeadless();
+	}
+
 	glutInit(&argc, argv);
 	glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA);
 	glutInitWindowSize(windowWidth, windowHeight);
 	glutInitWindowPosition(100, 100);
 	glutCreateWindow("Analog Clock");
+
+	// an editor may truncate a bitmap while its pixels are in use, so they
+	// are copied out of the files rather than read from them in place
+	if(watchImages)
+	{
+		TextureCache::setLoadMode(ImageLoader::CONVERT);
+	}
+
 	init();
 	glutDisplayFunc(display);
 	glutReshapeFunc(reshape);
-	glutIdleFunc(clockAnimation);
+	glutKeyboardFunc(keyboard);
+
+	if(printClicks)
+	{
+		glutMouseFunc(mouse);
+	}
+
+	if(watchImages)
+	{
+		imageWatcher = new FileWatcher();
+		streamer = new TextureStreamer();
+
+		if(!imageWatcher->watch(IMAGE_DIRECTORY))
+		{
+			delete imageWatcher;
+			imageWatcher = NULL;
+		}
+	}
+
+	startAnimation();
 	glutMainLoop();
 
 	return 0;
@@ -0,0 +1,145 @@
+/*
+ * AssetCompiler.cpp
+ *
+ * Builds an asset pack out of bitmaps, doing the decoding, swizzling and
+ * premultiplication once offline instead of on every start of the clock.
+ *
+ *   AssetCompiler [--lz4] --output clock.pack image.bmp[:pivotX,pivotY]...
+ *
+ * Images are stored under the path they were given with, which is the name
+ * the clock asks TextureCache for.
+ *
+ *  Created on: 2026-10-18
+ *      Copyright: yagudaev.com
+ *      Version: $0.1.0$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License Version 3 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include "ImageLoader.h"
+#include "AssetPack.h"
+#include "PixelConvert.h"
+
+using namespace std;
+
+static void usage(const char *program)
+{
+	printf("usage: %s [--lz4] --output file.pack image.bmp[:pivotX,pivotY]...\n", program);
+}
+
+/**
+ * Loads a bitmap and turns it into premultiplied RGBA rows.
+ * @param argument The path, optionally followed by :pivotX,pivotY
+ */
+static bool loadAsset(const string &argument, AssetPack::Asset &asset)
+{
+	size_t colon = argument.rfind(':');
+
+	asset.name = argument.substr(0, colon);
+	asset.pivotX = 0;
+	asset.pivotY = 0;
+
+	if(colon != string::npos &&
+	   sscanf(argument.c_str() + colon + 1, "%f,%f", &asset.pivotX, &asset.pivotY) != 2)
+	{
+		printf("Error: the pivot of %s must be given as x,y\n", asset.name.c_str());
+		return false;
+	}
+
+	ImageLoader image;
+
+	if(!image.loadBMP(asset.name.c_str()))
+	{
+		return false;
+	}
+
+	asset.width = image.getWidth();
+	asset.height = image.getHeight();
+	asset.pixels.resize(asset.width * asset.height * 4);
+
+	for(LONG y = 0; y < asset.height; y++)
+	{
+		PixelConvert::premultiplyRow(&asset.pixels[y * asset.width * 4], image.getRow(y), asset.width);
+	}
+
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *output = NULL;
+	bool compress = false;
+	vector<AssetPack::Asset> assets;
+	long inputBytes = 0;
+
+	for(int i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], "--lz4") == 0)
+		{
+			compress = true;
+		}
+		else if(strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+		{
+			output = argv[++i];
+		}
+		else if(argv[i][0] == '-')
+		{
+			usage(argv[0]);
+			return 1;
+		}
+		else
+		{
+			AssetPack::Asset asset;
+
+			if(!loadAsset(argv[i], asset))
+			{
+				return 1;
+			}
+
+			struct stat info;
+
+			if(stat(asset.name.c_str(), &info) == 0)
+			{
+				inputBytes += info.st_size;
+			}
+
+			assets.push_back(asset);
+		}
+	}
+
+	if(output == NULL || assets.empty())
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	if(!AssetPack::write(output, assets, compress))
+	{
+		return 1;
+	}
+
+	struct stat info;
+	stat(output, &info);
+
+	printf("packed %d images into %s: %ld bytes of bitmaps, %ld bytes packed\n",
+		   (int)assets.size(), output, inputBytes, (long)info.st_size);
+
+	return 0;
+}